@@ -3,10 +3,9 @@
 in vec2 uv;
 out vec4 fragment_color;
 
-// uniform sampler2D u_texture_1;
-// uniform sampler2D u_texture_2;
+// uniform sampler2DArray u_textures;
 
 void main() {
-    // fragment_color = mix(texture(u_texture_1, uv), texture(u_texture_2, uv), 0.2);
+    // fragment_color = mix(texture(u_textures, vec3(uv, 0)), texture(u_textures, vec3(uv, 1)), 0.2);
     fragment_color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
 };
@@ -3,9 +3,18 @@ layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec2 a_uv;
 
 out vec2 uv;
-uniform mat4 u_model, u_view, u_projection;
+uniform mat4 u_model;
+
+layout(std140, binding = 0) uniform FrameUniforms {
+    mat4 u_view;
+    mat4 u_projection;
+    mat4 u_view_projection;
+    vec4 u_camera_position;
+    float u_time;
+    float u_delta_time;
+};
 
 void main() {
-    gl_Position = u_projection * u_view * u_model * vec4(a_position, 1.0);
+    gl_Position = u_view_projection * u_model * vec4(a_position, 1.0);
     uv = a_uv;
 };
@@ -0,0 +1,20 @@
+#version 450 core
+layout(location = 0) in uvec4 a_voxel; // xyz = block corner in the chunk, w = face
+layout(location = 1) in uvec2 a_block; // x = block, y = uv in blocks, one byte each
+
+out vec2 uv;
+uniform mat4 u_model;
+
+layout(std140, binding = 0) uniform FrameUniforms {
+    mat4 u_view;
+    mat4 u_projection;
+    mat4 u_view_projection;
+    vec4 u_camera_position;
+    float u_time;
+    float u_delta_time;
+};
+
+void main() {
+    gl_Position = u_view_projection * u_model * vec4(vec3(a_voxel.xyz), 1.0);
+    uv = vec2(float(a_block.y & 0xffu), float(a_block.y >> 8u));
+};
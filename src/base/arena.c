@@ -0,0 +1,90 @@
+/**
+ * @file arena.c
+ * @brief Implementation of the linear arena (a chain of bump allocated blocks)
+ */
+
+#include "arena.h"
+
+#include <stdlib.h>
+
+#define ALIGNMENT	 16
+#define ALIGN(size)	 (((size) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1))
+#define BLOCK_HEADER ALIGN(sizeof(ArenaBlock))
+
+typedef struct arena_block {
+	struct arena_block *previous; // Block that ran out before this one, NULL for the first
+	size_t size, used; // Bytes after the header
+} ArenaBlock;
+
+struct arena {
+	ArenaBlock *block; // Block allocations come from
+	size_t block_size;
+	ArenaStats stats;
+};
+
+static ArenaBlock *arena_block_create(Arena *arena, size_t size, ArenaBlock *previous);
+
+Arena *arena_create(size_t block_size) {
+	Arena *arena = malloc(sizeof(Arena));
+
+	*arena = (Arena){ .block_size = ALIGN(block_size ? block_size : ALIGNMENT) };
+	arena->block = arena_block_create(arena, arena->block_size, NULL);
+
+	return arena;
+}
+
+void arena_destroy(Arena *arena) {
+	if (arena == NULL)
+		return;
+
+	for (ArenaBlock *block = arena->block, *previous; block; block = previous) {
+		previous = block->previous;
+		free(block);
+	}
+	free(arena);
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+	size = ALIGN(size);
+
+	if (arena->block->used + size > arena->block->size)
+		arena->block = arena_block_create(arena, size > arena->block_size ? size : arena->block_size, arena->block);
+
+	void *memory = (uint8_t *)arena->block + BLOCK_HEADER + arena->block->used;
+	arena->block->used += size;
+
+	arena->stats.allocations++;
+	arena->stats.used += size;
+	return memory;
+}
+
+// A chained arena is replaced by one block the size of the whole chain, so the same load fits without chaining next time
+void arena_reset(Arena *arena) {
+	if (arena->block->previous) {
+		size_t size = arena->stats.reserved;
+		for (ArenaBlock *block = arena->block, *previous; block; block = previous) {
+			previous = block->previous;
+			free(block);
+		}
+
+		arena->stats.reserved = 0;
+		arena->block = arena_block_create(arena, size, NULL);
+	}
+
+	arena->block->used = 0;
+	arena->stats.used = 0;
+}
+
+void arena_get_stats(const Arena *arena, ArenaStats *stats) {
+	*stats = arena->stats;
+}
+
+ArenaBlock *arena_block_create(Arena *arena, size_t size, ArenaBlock *previous) {
+	ArenaBlock *block = malloc(BLOCK_HEADER + size);
+
+	*block = (ArenaBlock){ .previous = previous, .size = size, .used = 0 };
+	arena->stats.heap_allocations++;
+	arena->stats.reserved += size;
+
+	return block;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file arena.h
+ * @brief Linear arena allocator for memory that is freed all at once
+ *
+ * Allocations bump a pointer through a block and are never freed one by one, the whole
+ * arena is reset or destroyed instead. That suits scratch memory that lives for a frame
+ * and objects that own several allocations freed together. When a block runs out the
+ * arena chains another one, and the next reset folds the chain into a single block big
+ * enough for all of it, so an arena reset every frame stops touching the heap once it
+ * has seen its peak frame.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct arena Arena;
+
+/**
+ * @brief Allocation counters, cumulative since the arena was created
+ */
+typedef struct {
+	uint64_t allocations; // arena_alloc calls
+	uint64_t heap_allocations; // Blocks malloc-ed
+	size_t used; // Bytes handed out since the last reset
+	size_t reserved; // Bytes held in blocks
+} ArenaStats;
+
+/**
+ * @brief Creates an arena with one block
+ *
+ * @param block_size Bytes of the first block, and the least chained when it runs out
+ * @return Pointer to the new arena
+ *
+ * Example:
+ *   Arena *frame_arena = arena_create(64 * 1024);
+ */
+Arena *arena_create(size_t block_size);
+
+/**
+ * @brief Frees the arena and everything allocated from it
+ */
+void arena_destroy(Arena *arena);
+
+/**
+ * @brief Allocates size bytes, 16 byte aligned. The memory is not cleared
+ *
+ * Example:
+ *   Ray *rays = arena_alloc(frame_arena, sizeof(Ray) * count);
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Frees every allocation at once, keeping the memory for the next ones
+ *
+ * Example:
+ *   while (running) {
+ *       arena_reset(frame_arena);
+ *       ...
+ *   }
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * @brief Writes the allocation counters of the arena to stats
+ */
+void arena_get_stats(const Arena *arena, ArenaStats *stats);
@@ -0,0 +1,344 @@
+/**
+ * @file chunk_grid.c
+ * @brief Implementation of the sparse hash grid (open addressing with linear probing)
+ */
+
+#include "chunk_grid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EMPTY_CELL		 INT32_MIN
+#define INITIAL_CAPACITY 64
+
+typedef struct {
+	int32_t cell[3]; // cell[0] is EMPTY_CELL for a free slot
+	uint32_t value;
+} ChunkGridEntry;
+
+struct chunk_grid {
+	float cell_size[3], origin[3];
+	ChunkGridEntry *entries;
+	uint32_t capacity; // Power of two
+	uint32_t count;
+
+	// Box around every cell stored since the last clear, bounds ray walks
+	int32_t bounds_min[3], bounds_max[3];
+};
+
+typedef struct {
+	const ChunkGrid *grid;
+	float center[3], radius_squared;
+	ChunkGridVisitor visitor;
+	void *user_data;
+	uint32_t visited;
+} SphereQuery;
+
+static uint32_t chunk_grid_hash(const int32_t cell[3]);
+static uint32_t chunk_grid_find_slot(const ChunkGrid *grid, const int32_t cell[3]);
+static void chunk_grid_grow(ChunkGrid *grid);
+static bool sphere_query_visit(void *user_data, const int32_t cell[3], uint32_t value);
+
+ChunkGrid *chunk_grid_create(const float cell_size[3], const float origin[3]) {
+	ChunkGrid *grid = malloc(sizeof(ChunkGrid));
+
+	memcpy(grid->cell_size, cell_size, sizeof(grid->cell_size));
+	memcpy(grid->origin, origin, sizeof(grid->origin));
+	grid->capacity = INITIAL_CAPACITY;
+	grid->entries = malloc(sizeof(ChunkGridEntry) * grid->capacity);
+	chunk_grid_clear(grid);
+
+	return grid;
+}
+
+void chunk_grid_destroy(ChunkGrid *grid) {
+	if (grid == NULL)
+		return;
+
+	free(grid->entries);
+	free(grid);
+}
+
+void chunk_grid_set(ChunkGrid *grid, const int32_t cell[3], uint32_t value) {
+	// Keep the table at most 70% full, probes get long past that
+	if ((grid->count + 1) * 10 > grid->capacity * 7)
+		chunk_grid_grow(grid);
+
+	ChunkGridEntry *entry = &grid->entries[chunk_grid_find_slot(grid, cell)];
+	if (entry->cell[0] == EMPTY_CELL) {
+		memcpy(entry->cell, cell, sizeof(entry->cell));
+		grid->count++;
+
+		for (uint32_t axis = 0; axis < 3; axis++) {
+			if (cell[axis] < grid->bounds_min[axis])
+				grid->bounds_min[axis] = cell[axis];
+			if (cell[axis] > grid->bounds_max[axis])
+				grid->bounds_max[axis] = cell[axis];
+		}
+	}
+	entry->value = value;
+}
+
+bool chunk_grid_get(const ChunkGrid *grid, const int32_t cell[3], uint32_t *value) {
+	const ChunkGridEntry *entry = &grid->entries[chunk_grid_find_slot(grid, cell)];
+	if (entry->cell[0] == EMPTY_CELL)
+		return false;
+
+	if (value)
+		*value = entry->value;
+	return true;
+}
+
+bool chunk_grid_remove(ChunkGrid *grid, const int32_t cell[3]) {
+	const uint32_t mask = grid->capacity - 1;
+	uint32_t slot = chunk_grid_find_slot(grid, cell);
+	if (grid->entries[slot].cell[0] == EMPTY_CELL)
+		return false;
+
+	// Backward shift: pull later entries of the probe run into the hole unless that would move them before their home
+	// slot, so lookups never need tombstones
+	uint32_t hole = slot;
+	for (uint32_t next = (hole + 1) & mask; grid->entries[next].cell[0] != EMPTY_CELL; next = (next + 1) & mask) {
+		uint32_t home = chunk_grid_hash(grid->entries[next].cell) & mask;
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			grid->entries[hole] = grid->entries[next];
+			hole = next;
+		}
+	}
+	grid->entries[hole].cell[0] = EMPTY_CELL;
+	grid->count--;
+
+	return true;
+}
+
+void chunk_grid_clear(ChunkGrid *grid) {
+	for (uint32_t i = 0; i < grid->capacity; i++)
+		grid->entries[i].cell[0] = EMPTY_CELL;
+	grid->count = 0;
+
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		grid->bounds_min[axis] = INT32_MAX;
+		grid->bounds_max[axis] = INT32_MIN;
+	}
+}
+
+uint32_t chunk_grid_count(const ChunkGrid *grid) {
+	return grid->count;
+}
+
+void chunk_grid_cell_of(const ChunkGrid *grid, const float position[3], int32_t cell[3]) {
+	for (uint32_t axis = 0; axis < 3; axis++)
+		cell[axis] = (int32_t)floorf((position[axis] - grid->origin[axis]) / grid->cell_size[axis]);
+}
+
+uint32_t chunk_grid_neighbours(const ChunkGrid *grid, const int32_t cell[3], uint32_t values[6]) {
+	uint32_t found = 0;
+
+	for (uint32_t face = 0; face < 6; face++) {
+		int32_t neighbour[3] = { cell[0], cell[1], cell[2] };
+		neighbour[face / 2] += face % 2 ? -1 : 1;
+		if (chunk_grid_get(grid, neighbour, &values[face]))
+			found |= 1u << face;
+	}
+
+	return found;
+}
+
+uint32_t chunk_grid_query_box(const ChunkGrid *grid, const int32_t min[3], const int32_t max[3], ChunkGridVisitor visitor, void *user_data) {
+	int32_t low[3], high[3];
+	uint64_t volume = 1;
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		low[axis] = min[axis] > grid->bounds_min[axis] ? min[axis] : grid->bounds_min[axis];
+		high[axis] = max[axis] < grid->bounds_max[axis] ? max[axis] : grid->bounds_max[axis];
+		if (low[axis] > high[axis])
+			return 0;
+		volume *= (uint64_t)((int64_t)high[axis] - low[axis] + 1);
+	}
+
+	uint32_t visited = 0;
+	if (volume > grid->capacity) {
+		for (uint32_t i = 0; i < grid->capacity; i++) {
+			const ChunkGridEntry *entry = &grid->entries[i];
+			if (entry->cell[0] == EMPTY_CELL)
+				continue;
+			if (entry->cell[0] < low[0] || entry->cell[0] > high[0] || entry->cell[1] < low[1] || entry->cell[1] > high[1] || entry->cell[2] < low[2] ||
+				entry->cell[2] > high[2])
+				continue;
+
+			visited++;
+			if (!visitor(user_data, entry->cell, entry->value))
+				return visited;
+		}
+		return visited;
+	}
+
+	for (int32_t z = low[2]; z <= high[2]; z++) {
+		for (int32_t y = low[1]; y <= high[1]; y++) {
+			for (int32_t x = low[0]; x <= high[0]; x++) {
+				const int32_t cell[3] = { x, y, z };
+				uint32_t value;
+				if (!chunk_grid_get(grid, cell, &value))
+					continue;
+
+				visited++;
+				if (!visitor(user_data, cell, value))
+					return visited;
+			}
+		}
+	}
+	return visited;
+}
+
+uint32_t chunk_grid_query_sphere(const ChunkGrid *grid, const float center[3], float radius, ChunkGridVisitor visitor, void *user_data) {
+	SphereQuery query = { .grid = grid, .radius_squared = radius * radius, .visitor = visitor, .user_data = user_data };
+	memcpy(query.center, center, sizeof(query.center));
+
+	int32_t min[3], max[3];
+	const float low[3] = { center[0] - radius, center[1] - radius, center[2] - radius };
+	const float high[3] = { center[0] + radius, center[1] + radius, center[2] + radius };
+	chunk_grid_cell_of(grid, low, min);
+	chunk_grid_cell_of(grid, high, max);
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		// A sphere ending exactly on a cell boundary touches the cell below it too
+		if (grid->origin[axis] + min[axis] * grid->cell_size[axis] == low[axis])
+			min[axis]--;
+	}
+
+	chunk_grid_query_box(grid, min, max, sphere_query_visit, &query);
+	return query.visited;
+}
+
+// Amanatides & Woo: step into whichever neighbouring cell the ray reaches first
+uint32_t chunk_grid_query_ray(const ChunkGrid *grid, const float origin[3], const float direction[3], float max_distance, ChunkGridVisitor visitor,
+							  void *user_data) {
+	if (grid->count == 0)
+		return 0;
+
+	float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	if (length == 0.f)
+		return 0;
+	const float dir[3] = { direction[0] / length, direction[1] / length, direction[2] / length };
+
+	// Clip the ray to the box around the stored cells
+	float t_enter = 0.f, t_exit = max_distance;
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		float low = grid->origin[axis] + grid->bounds_min[axis] * grid->cell_size[axis];
+		float high = grid->origin[axis] + (grid->bounds_max[axis] + 1.f) * grid->cell_size[axis];
+		if (dir[axis] == 0.f) {
+			if (origin[axis] < low || origin[axis] >= high)
+				return 0;
+			continue;
+		}
+
+		float t0 = (low - origin[axis]) / dir[axis], t1 = (high - origin[axis]) / dir[axis];
+		if (t0 > t1) {
+			float swap = t0;
+			t0 = t1, t1 = swap;
+		}
+		t_enter = t0 > t_enter ? t0 : t_enter;
+		t_exit = t1 < t_exit ? t1 : t_exit;
+	}
+	if (t_enter > t_exit)
+		return 0;
+
+	const float start[3] = { origin[0] + dir[0] * t_enter, origin[1] + dir[1] * t_enter, origin[2] + dir[2] * t_enter };
+	int32_t cell[3], step[3];
+	float t_next[3], t_delta[3];
+	chunk_grid_cell_of(grid, start, cell);
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		// The entry point sits on the box, rounding can put it one cell outside
+		if (cell[axis] < grid->bounds_min[axis])
+			cell[axis] = grid->bounds_min[axis];
+		if (cell[axis] > grid->bounds_max[axis])
+			cell[axis] = grid->bounds_max[axis];
+
+		if (dir[axis] == 0.f) {
+			step[axis] = 0;
+			t_next[axis] = t_delta[axis] = INFINITY;
+			continue;
+		}
+		step[axis] = dir[axis] > 0.f ? 1 : -1;
+		t_delta[axis] = grid->cell_size[axis] / fabsf(dir[axis]);
+		float boundary = grid->origin[axis] + (cell[axis] + (step[axis] > 0)) * grid->cell_size[axis];
+		t_next[axis] = (boundary - origin[axis]) / dir[axis];
+	}
+
+	uint32_t visited = 0;
+	for (;;) {
+		uint32_t value;
+		if (chunk_grid_get(grid, cell, &value)) {
+			visited++;
+			if (!visitor(user_data, cell, value))
+				return visited;
+		}
+
+		uint32_t axis = t_next[0] < t_next[1] ? (t_next[0] < t_next[2] ? 0 : 2) : (t_next[1] < t_next[2] ? 1 : 2);
+		if (t_next[axis] > t_exit)
+			return visited;
+
+		cell[axis] += step[axis];
+		t_next[axis] += t_delta[axis];
+		if (cell[axis] < grid->bounds_min[axis] || cell[axis] > grid->bounds_max[axis])
+			return visited;
+	}
+}
+
+uint32_t chunk_grid_hash(const int32_t cell[3]) {
+	uint32_t hash = (uint32_t)cell[0] * 73856093u ^ (uint32_t)cell[1] * 19349663u ^ (uint32_t)cell[2] * 83492791u;
+
+	// Finalizer of MurmurHash3, so neighbouring cells land far apart in the table
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+// The slot holding cell, or the free slot where it would go
+uint32_t chunk_grid_find_slot(const ChunkGrid *grid, const int32_t cell[3]) {
+	const uint32_t mask = grid->capacity - 1;
+	uint32_t slot = chunk_grid_hash(cell) & mask;
+
+	for (;; slot = (slot + 1) & mask) {
+		const ChunkGridEntry *entry = &grid->entries[slot];
+		if (entry->cell[0] == EMPTY_CELL || (entry->cell[0] == cell[0] && entry->cell[1] == cell[1] && entry->cell[2] == cell[2]))
+			return slot;
+	}
+}
+
+void chunk_grid_grow(ChunkGrid *grid) {
+	ChunkGridEntry *previous = grid->entries;
+	uint32_t previous_capacity = grid->capacity;
+
+	grid->capacity *= 2;
+	grid->entries = malloc(sizeof(ChunkGridEntry) * grid->capacity);
+	for (uint32_t i = 0; i < grid->capacity; i++)
+		grid->entries[i].cell[0] = EMPTY_CELL;
+
+	for (uint32_t i = 0; i < previous_capacity; i++) {
+		if (previous[i].cell[0] != EMPTY_CELL)
+			grid->entries[chunk_grid_find_slot(grid, previous[i].cell)] = previous[i];
+	}
+	free(previous);
+}
+
+// Forwards the cells of the sphere's bounding box that the sphere actually touches
+bool sphere_query_visit(void *user_data, const int32_t cell[3], uint32_t value) {
+	SphereQuery *query = user_data;
+	const ChunkGrid *grid = query->grid;
+
+	float distance_squared = 0.f;
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		float low = grid->origin[axis] + cell[axis] * grid->cell_size[axis], high = low + grid->cell_size[axis];
+		float closest = query->center[axis] < low ? low : query->center[axis] > high ? high : query->center[axis];
+		distance_squared += (closest - query->center[axis]) * (closest - query->center[axis]);
+	}
+
+	if (distance_squared > query->radius_squared)
+		return true;
+
+	query->visited++;
+	return query->visitor(query->user_data, cell, value);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file chunk_grid.h
+ * @brief Sparse hash grid mapping integer cell coordinates to values
+ *
+ * The grid cuts space into boxes of cell_size world units starting at an origin and
+ * only stores the cells something was put in, so it suits chunked worlds that stream
+ * in around the camera. Lookups are a single hash probe. Range and ray queries visit
+ * cells rather than scanning every entry.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct chunk_grid ChunkGrid;
+
+/**
+ * @brief Query callback, invoked once per occupied cell the query reaches
+ *
+ * @param user_data Pointer passed to the query
+ * @param cell Coordinates of the cell
+ * @param value Value stored in the cell
+ * @return false to stop the query early
+ */
+typedef bool (*ChunkGridVisitor)(void *user_data, const int32_t cell[3], uint32_t value);
+
+/**
+ * @brief Creates an empty grid
+ *
+ * @param cell_size World units a cell spans along x, y and z
+ * @param origin World position of the corner of cell (0, 0, 0)
+ * @return Pointer to the new grid
+ *
+ * Example:
+ *   // Columns of 250 x 250 units that hold everything between y = -200 and y = 200
+ *   ChunkGrid *grid = chunk_grid_create((float[3]){ 250.f, 400.f, 250.f }, (float[3]){ 0.f, -200.f, 0.f });
+ */
+ChunkGrid *chunk_grid_create(const float cell_size[3], const float origin[3]);
+
+/**
+ * @brief Frees the grid
+ */
+void chunk_grid_destroy(ChunkGrid *grid);
+
+/**
+ * @brief Stores value in cell, replacing what it held
+ *
+ * Cells with x = INT32_MIN can't be stored, the grid uses that coordinate to mark free slots.
+ */
+void chunk_grid_set(ChunkGrid *grid, const int32_t cell[3], uint32_t value);
+
+/**
+ * @brief Looks cell up
+ *
+ * @param value Receives the stored value, may be NULL to only test for the cell
+ * @return true if the cell holds a value
+ */
+bool chunk_grid_get(const ChunkGrid *grid, const int32_t cell[3], uint32_t *value);
+
+/**
+ * @brief Removes cell
+ *
+ * @return true if the cell held a value
+ */
+bool chunk_grid_remove(ChunkGrid *grid, const int32_t cell[3]);
+
+/**
+ * @brief Removes every cell, keeping the memory
+ */
+void chunk_grid_clear(ChunkGrid *grid);
+
+/**
+ * @brief Returns the number of occupied cells
+ */
+uint32_t chunk_grid_count(const ChunkGrid *grid);
+
+/**
+ * @brief Writes the coordinates of the cell containing the world position to cell
+ */
+void chunk_grid_cell_of(const ChunkGrid *grid, const float position[3], int32_t cell[3]);
+
+/**
+ * @brief Looks up the six cells sharing a face with cell
+ *
+ * @param values Receives the values in the order +x, -x, +y, -y, +z, -z
+ * @return Mask with bit i set when neighbour i is occupied, the other values are left as they are
+ */
+uint32_t chunk_grid_neighbours(const ChunkGrid *grid, const int32_t cell[3], uint32_t values[6]);
+
+/**
+ * @brief Visits the occupied cells with coordinates in [min, max], inclusive, in no particular order
+ *
+ * Walks the box or every entry, whichever is less work.
+ *
+ * @return Number of cells visited
+ */
+uint32_t chunk_grid_query_box(const ChunkGrid *grid, const int32_t min[3], const int32_t max[3], ChunkGridVisitor visitor, void *user_data);
+
+/**
+ * @brief Visits the occupied cells whose box intersects the sphere, in no particular order
+ *
+ * Example:
+ *   // Every chunk within the view distance
+ *   chunk_grid_query_sphere(grid, camera_position, view_distance, collect_chunk, &visible);
+ *
+ * @return Number of cells visited
+ */
+uint32_t chunk_grid_query_sphere(const ChunkGrid *grid, const float center[3], float radius, ChunkGridVisitor visitor, void *user_data);
+
+/**
+ * @brief Visits the occupied cells the ray passes through, nearest first
+ *
+ * A 3D DDA steps from cell to cell along the ray until max_distance or until it leaves
+ * the box around every cell ever stored, so rays through empty space stay cheap.
+ *
+ * @param direction Doesn't need to be normalized
+ * @param max_distance World units along the ray
+ * @return Number of cells visited
+ */
+uint32_t chunk_grid_query_ray(const ChunkGrid *grid, const float origin[3], const float direction[3], float max_distance, ChunkGridVisitor visitor,
+							  void *user_data);
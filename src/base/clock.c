@@ -0,0 +1,21 @@
+/**
+ * @file clock.c
+ * @brief Implementation of the monotonic clock
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "clock.h"
+
+#include <time.h>
+
+uint64_t clock_nanoseconds(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+double clock_seconds(void) {
+	return (double)clock_nanoseconds() * 1e-9;
+}
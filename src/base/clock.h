@@ -0,0 +1,23 @@
+/**
+ * @file clock.h
+ * @brief Monotonic wall clock for timing code
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Nanoseconds since an arbitrary fixed point, never goes backwards
+ */
+uint64_t clock_nanoseconds(void);
+
+/**
+ * @brief clock_nanoseconds in seconds
+ *
+ * Example:
+ *   double start = clock_seconds();
+ *   terrain_update(terrain, camera_position);
+ *   LOG_DEBUG("Update took %.2f ms", (clock_seconds() - start) * 1e3);
+ */
+double clock_seconds(void);
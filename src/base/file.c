@@ -0,0 +1,80 @@
+/**
+ * @file file.c
+ * @brief Implementation of the file system helpers (POSIX)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool file_create_directories(const char *directory) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s", directory);
+
+	for (char *c = path + 1; *c; c++) {
+		if (*c != '/')
+			continue;
+
+		*c = '\0';
+		if (mkdir(path, 0755) != 0 && errno != EEXIST)
+			return false;
+		*c = '/';
+	}
+
+	return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+bool file_write_atomic(const char *path, const void *data, size_t size) {
+	// A unique name per call, threads of one process writing the same path must not share the temporary
+	char temporary_path[512];
+	snprintf(temporary_path, sizeof(temporary_path), "%s.XXXXXX", path);
+	int descriptor = mkstemp(temporary_path);
+	if (descriptor < 0)
+		return false;
+	fchmod(descriptor, 0644);
+
+	FILE *file = fdopen(descriptor, "wb");
+	if (file == NULL)
+		close(descriptor);
+	bool written = file && fwrite(data, 1, size, file) == size;
+	if (file)
+		written = fclose(file) == 0 && written;
+
+	if (!written || rename(temporary_path, path) != 0) {
+		remove(temporary_path);
+		return false;
+	}
+
+	return true;
+}
+
+const void *file_map(const char *path, size_t *size) {
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return NULL;
+
+	struct stat status;
+	void *mapping = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+		mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+
+	if (mapping == MAP_FAILED)
+		return NULL;
+
+	*size = status.st_size;
+	return mapping;
+}
+
+void file_unmap(const void *mapping, size_t size) {
+	if (mapping)
+		munmap((void *)mapping, size);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file file.h
+ * @brief Small file system helpers for the on-disk caches
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Creates directory and any missing parents, like mkdir -p
+ *
+ * @return true if the directory exists afterwards
+ */
+bool file_create_directories(const char *directory);
+
+/**
+ * @brief Writes size bytes to path through a temporary file that is renamed over it
+ *
+ * Readers (including other processes mapping path) see either the old file or the
+ * complete new one, never half a file.
+ *
+ * @return true if path now holds data
+ */
+bool file_write_atomic(const char *path, const void *data, size_t size);
+
+/**
+ * @brief Maps path read-only
+ *
+ * @param path File to map
+ * @param size Receives the file size
+ * @return The mapping, or NULL if the file can't be opened or is empty
+ *
+ * Example:
+ *   size_t size;
+ *   const uint8_t *data = file_map(path, &size);
+ *   if (data) {
+ *       for (size_t i = 0; i < size; i++)
+ *           hash = (hash ^ data[i]) * 1099511628211ull;
+ *       file_unmap(data, size);
+ *   }
+ */
+const void *file_map(const char *path, size_t *size);
+
+/**
+ * @brief Releases a mapping returned by file_map
+ */
+void file_unmap(const void *mapping, size_t size);
@@ -0,0 +1,218 @@
+/**
+ * @file job_system.c
+ * @brief Implementation of the job system
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "job_system.h"
+#include "base.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define JOB_QUEUE_INITIAL_CAPACITY 256
+
+typedef struct {
+	JobFunction function;
+	void *user_data;
+	uint32_t index;
+	JobCounter *counter;
+} Job;
+
+struct job_system {
+	pthread_t *workers;
+	uint32_t worker_count, thread_count;
+
+	/* Ring buffer of queued jobs, guarded by mutex */
+	Job *queue;
+	uint32_t head, count, capacity;
+	bool running;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t work_available;
+	pthread_cond_t work_finished;
+};
+
+static void *job_system_worker(void *argument);
+static bool job_system_pop(JobSystem *jobs, Job *job);
+static void job_run(JobSystem *jobs, Job *job);
+
+JobSystem *job_system_create(uint32_t thread_count) {
+	if (thread_count == 0) {
+		long core_count = sysconf(_SC_NPROCESSORS_ONLN);
+		thread_count = core_count > 0 ? (uint32_t)core_count : 1;
+	}
+
+	JobSystem *jobs = malloc(sizeof(JobSystem));
+	*jobs = (JobSystem){ 0 };
+
+	jobs->thread_count = thread_count;
+	jobs->worker_count = thread_count - 1; // The waiting thread runs jobs too
+	jobs->capacity = JOB_QUEUE_INITIAL_CAPACITY;
+	jobs->queue = malloc(sizeof(Job) * jobs->capacity);
+	jobs->running = true;
+
+	pthread_mutex_init(&jobs->mutex, NULL);
+	pthread_cond_init(&jobs->work_available, NULL);
+	pthread_cond_init(&jobs->work_finished, NULL);
+
+	jobs->workers = jobs->worker_count ? malloc(sizeof(pthread_t) * jobs->worker_count) : NULL;
+	for (uint32_t i = 0; i < jobs->worker_count; i++) {
+		if (pthread_create(&jobs->workers[i], NULL, job_system_worker, jobs) != 0) {
+			LOG_ERROR("Failed to create job worker thread %u, continuing with %u", i, i);
+			jobs->worker_count = i;
+			jobs->thread_count = i + 1;
+			break;
+		}
+	}
+
+	LOG_INFO("Job system running on %u thread(s)", jobs->thread_count);
+	return jobs;
+}
+
+void job_system_destroy(JobSystem *jobs) {
+	if (jobs == NULL)
+		return;
+
+	pthread_mutex_lock(&jobs->mutex);
+	jobs->running = false;
+	pthread_cond_broadcast(&jobs->work_available);
+	pthread_mutex_unlock(&jobs->mutex);
+
+	for (uint32_t i = 0; i < jobs->worker_count; i++)
+		pthread_join(jobs->workers[i], NULL);
+
+	// Workers drain the queue before exiting, but with no workers it may still hold jobs
+	Job job;
+	while (job_system_pop(jobs, &job))
+		job_run(jobs, &job);
+
+	pthread_mutex_destroy(&jobs->mutex);
+	pthread_cond_destroy(&jobs->work_available);
+	pthread_cond_destroy(&jobs->work_finished);
+	free(jobs->workers);
+	free(jobs->queue);
+	free(jobs);
+}
+
+uint32_t job_system_thread_count(JobSystem *jobs) {
+	return jobs->thread_count;
+}
+
+void job_system_dispatch(JobSystem *jobs, uint32_t job_count, JobFunction function, void *user_data, JobCounter *counter) {
+	if (counter)
+		__atomic_add_fetch(&counter->pending, job_count, __ATOMIC_ACQ_REL);
+
+	// Single-threaded fallback: nothing would ever pick the jobs up, so run them right away
+	if (jobs->worker_count == 0) {
+		for (uint32_t i = 0; i < job_count; i++) {
+			Job job = { .function = function, .user_data = user_data, .index = i, .counter = counter };
+			job_run(jobs, &job);
+		}
+		return;
+	}
+
+	pthread_mutex_lock(&jobs->mutex);
+	if (jobs->count + job_count > jobs->capacity) {
+		uint32_t new_capacity = jobs->capacity;
+		while (new_capacity < jobs->count + job_count)
+			new_capacity *= 2;
+
+		// Unroll the ring so the queued jobs start at index 0 of the new allocation
+		Job *queue = malloc(sizeof(Job) * new_capacity);
+		for (uint32_t i = 0; i < jobs->count; i++)
+			queue[i] = jobs->queue[(jobs->head + i) % jobs->capacity];
+
+		free(jobs->queue);
+		jobs->queue = queue;
+		jobs->head = 0;
+		jobs->capacity = new_capacity;
+	}
+
+	for (uint32_t i = 0; i < job_count; i++) {
+		uint32_t slot = (jobs->head + jobs->count++) % jobs->capacity;
+		jobs->queue[slot] = (Job){ .function = function, .user_data = user_data, .index = i, .counter = counter };
+	}
+	pthread_cond_broadcast(&jobs->work_available);
+	pthread_mutex_unlock(&jobs->mutex);
+}
+
+void job_system_wait(JobSystem *jobs, JobCounter *counter) {
+	if (counter == NULL)
+		return;
+
+	while (!job_system_is_done(counter)) {
+		Job job;
+		if (job_system_pop(jobs, &job)) {
+			job_run(jobs, &job);
+			continue;
+		}
+
+		// Nothing left to help with, sleep until some worker finishes a job
+		pthread_mutex_lock(&jobs->mutex);
+		while (!job_system_is_done(counter) && jobs->count == 0)
+			pthread_cond_wait(&jobs->work_finished, &jobs->mutex);
+		pthread_mutex_unlock(&jobs->mutex);
+	}
+}
+
+bool job_system_is_done(JobCounter *counter) {
+	return counter == NULL || __atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+void job_system_parallel_for(JobSystem *jobs, uint32_t job_count, JobFunction function, void *user_data) {
+	JobCounter counter = { 0 };
+	job_system_dispatch(jobs, job_count, function, user_data, &counter);
+	job_system_wait(jobs, &counter);
+}
+
+void *job_system_worker(void *argument) {
+	JobSystem *jobs = (JobSystem *)argument;
+
+	for (;;) {
+		pthread_mutex_lock(&jobs->mutex);
+		while (jobs->running && jobs->count == 0)
+			pthread_cond_wait(&jobs->work_available, &jobs->mutex);
+
+		if (jobs->count == 0) {
+			// Shutting down and the queue is drained
+			pthread_mutex_unlock(&jobs->mutex);
+			return NULL;
+		}
+
+		Job job = jobs->queue[jobs->head];
+		jobs->head = (jobs->head + 1) % jobs->capacity;
+		jobs->count--;
+		pthread_mutex_unlock(&jobs->mutex);
+
+		job_run(jobs, &job);
+	}
+}
+
+bool job_system_pop(JobSystem *jobs, Job *job) {
+	bool popped = false;
+
+	pthread_mutex_lock(&jobs->mutex);
+	if (jobs->count > 0) {
+		*job = jobs->queue[jobs->head];
+		jobs->head = (jobs->head + 1) % jobs->capacity;
+		jobs->count--;
+		popped = true;
+	}
+	pthread_mutex_unlock(&jobs->mutex);
+
+	return popped;
+}
+
+void job_run(JobSystem *jobs, Job *job) {
+	job->function(job->user_data, job->index);
+
+	if (job->counter && __atomic_sub_fetch(&job->counter->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+		// Take the lock so a waiter can't miss the wakeup between its check and its wait
+		pthread_mutex_lock(&jobs->mutex);
+		pthread_cond_broadcast(&jobs->work_finished);
+		pthread_mutex_unlock(&jobs->mutex);
+	}
+}
@@ -0,0 +1,86 @@
+/**
+ * @file job_system.h
+ * @brief Fixed-size worker pool for data-parallel jobs
+ *
+ * Jobs are plain function pointers invoked with a user pointer and a job index,
+ * which makes splitting a loop into tiles a single dispatch call. Completion is
+ * tracked with a JobCounter that the caller can wait on (the waiting thread helps
+ * run queued jobs instead of sleeping).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct job_system JobSystem;
+
+/**
+ * @brief Job entry point
+ *
+ * @param user_data Pointer passed to job_system_dispatch
+ * @param index Index of this job in [0, job_count)
+ */
+typedef void (*JobFunction)(void *user_data, uint32_t index);
+
+/**
+ * @brief Tracks the number of unfinished jobs of one or more dispatches
+ *
+ * Zero-initialize before the first dispatch, e.g. JobCounter counter = { 0 };
+ */
+typedef struct {
+	uint32_t pending;
+} JobCounter;
+
+/**
+ * @brief Creates a job system
+ *
+ * @param thread_count Total threads working on jobs, including the thread that waits on them.
+ *                     0 picks the number of online cores, 1 runs every job inline on the caller.
+ * @return Pointer to the new job system
+ *
+ * Example:
+ *   JobSystem *jobs = job_system_create(0);
+ */
+JobSystem *job_system_create(uint32_t thread_count);
+
+/**
+ * @brief Finishes all queued jobs, joins the workers and frees the job system
+ */
+void job_system_destroy(JobSystem *jobs);
+
+/**
+ * @brief Returns the thread count the job system was created with (after resolving 0)
+ */
+uint32_t job_system_thread_count(JobSystem *jobs);
+
+/**
+ * @brief Queues job_count invocations of function without waiting for them
+ *
+ * @param jobs The job system
+ * @param job_count Number of jobs, each gets its own index
+ * @param function Job entry point
+ * @param user_data Pointer passed to every job
+ * @param counter Incremented by job_count, decremented as jobs finish (may be NULL)
+ *
+ * Example:
+ *   JobCounter counter = { 0 };
+ *   job_system_dispatch(jobs, tile_count, generate_tile, &context, &counter);
+ *   job_system_wait(jobs, &counter);
+ */
+void job_system_dispatch(JobSystem *jobs, uint32_t job_count, JobFunction function, void *user_data, JobCounter *counter);
+
+/**
+ * @brief Blocks until counter reaches zero, running queued jobs on the calling thread meanwhile
+ */
+void job_system_wait(JobSystem *jobs, JobCounter *counter);
+
+/**
+ * @brief Returns true if every job tracked by counter has finished
+ */
+bool job_system_is_done(JobCounter *counter);
+
+/**
+ * @brief Dispatches job_count jobs and waits for them
+ */
+void job_system_parallel_for(JobSystem *jobs, uint32_t job_count, JobFunction function, void *user_data);
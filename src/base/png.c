@@ -0,0 +1,157 @@
+/**
+ * @file png.c
+ * @brief Implementation of the PNG writer
+ */
+
+#include "png.h"
+#include "base.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFLATE_STORED_BLOCK_MAX 65535
+
+typedef struct {
+	FILE *file;
+	uint32_t crc;
+	uint32_t adler_a, adler_b;
+} PngWriter;
+
+static void png_chunk_begin(PngWriter *writer, const char *type, uint32_t length);
+static void png_chunk_write(PngWriter *writer, const void *data, uint32_t length);
+static void png_chunk_end(PngWriter *writer);
+static void png_zlib_write(PngWriter *writer, const uint8_t *data, uint32_t length);
+static void write_u32_be(uint8_t *out, uint32_t value);
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t length);
+
+bool png_write_rgba(const char *path, uint32_t width, uint32_t height, const uint8_t *pixels, bool flip_vertically) {
+	PngWriter writer = { .file = fopen(path, "wb"), .adler_a = 1 };
+	if (writer.file == NULL) {
+		LOG_ERROR("Can't open [ %s ] for writing", path);
+		return false;
+	}
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fwrite(signature, 1, sizeof(signature), writer.file);
+
+	// Header: size, 8 bits per channel, color type 6 (RGBA), default compression, filter and no interlacing
+	uint8_t header[13] = { [8] = 8, [9] = 6 };
+	write_u32_be(header, width);
+	write_u32_be(header + 4, height);
+	png_chunk_begin(&writer, "IHDR", sizeof(header));
+	png_chunk_write(&writer, header, sizeof(header));
+	png_chunk_end(&writer);
+
+	// Every row is prefixed with filter type 0, the stream is split into stored blocks of up to 64 KiB
+	uint32_t row_size = width * 4 + 1;
+	uint64_t raw_size = (uint64_t)row_size * height;
+	uint32_t block_count = (uint32_t)((raw_size + DEFLATE_STORED_BLOCK_MAX - 1) / DEFLATE_STORED_BLOCK_MAX);
+	uint64_t data_size = 2 + raw_size + block_count * 5ull + 4;
+	if (data_size > UINT32_MAX) {
+		LOG_ERROR("Image [ %s ] is too large to store uncompressed", path);
+		fclose(writer.file);
+		return false;
+	}
+
+	png_chunk_begin(&writer, "IDAT", (uint32_t)data_size);
+
+	static const uint8_t zlib_header[2] = { 0x78, 0x01 };
+	png_chunk_write(&writer, zlib_header, sizeof(zlib_header));
+
+	uint8_t *row = malloc(row_size);
+	uint32_t block_left = 0;
+	uint64_t raw_left = raw_size;
+	for (uint32_t y = 0; y < height; y++) {
+		uint32_t source_row = flip_vertically ? height - 1 - y : y;
+		row[0] = 0;
+		memcpy(row + 1, pixels + (size_t)source_row * width * 4, width * 4);
+
+		for (uint32_t offset = 0; offset < row_size;) {
+			if (block_left == 0) {
+				block_left = raw_left < DEFLATE_STORED_BLOCK_MAX ? (uint32_t)raw_left : DEFLATE_STORED_BLOCK_MAX;
+				uint8_t block_header[5] = {
+					raw_left == block_left, // Final block flag, block type 00 = stored
+					block_left & 0xFF, block_left >> 8,
+					~block_left & 0xFF, (~block_left >> 8) & 0xFF,
+				};
+				png_chunk_write(&writer, block_header, sizeof(block_header));
+			}
+
+			uint32_t length = row_size - offset < block_left ? row_size - offset : block_left;
+			png_zlib_write(&writer, row + offset, length);
+			offset += length;
+			block_left -= length;
+			raw_left -= length;
+		}
+	}
+	free(row);
+
+	uint8_t adler[4];
+	write_u32_be(adler, writer.adler_b << 16 | writer.adler_a);
+	png_chunk_write(&writer, adler, sizeof(adler));
+	png_chunk_end(&writer);
+
+	png_chunk_begin(&writer, "IEND", 0);
+	png_chunk_end(&writer);
+
+	bool written = ferror(writer.file) == 0;
+	fclose(writer.file);
+	return written;
+}
+
+void png_chunk_begin(PngWriter *writer, const char *type, uint32_t length) {
+	uint8_t length_bytes[4];
+	write_u32_be(length_bytes, length);
+	fwrite(length_bytes, 1, sizeof(length_bytes), writer->file);
+
+	// The CRC covers the type and the data, not the length
+	writer->crc = 0xFFFFFFFFu;
+	png_chunk_write(writer, type, 4);
+}
+
+void png_chunk_write(PngWriter *writer, const void *data, uint32_t length) {
+	fwrite(data, 1, length, writer->file);
+	writer->crc = crc32_update(writer->crc, data, length);
+}
+
+void png_chunk_end(PngWriter *writer) {
+	uint8_t crc[4];
+	write_u32_be(crc, writer->crc ^ 0xFFFFFFFFu);
+	fwrite(crc, 1, sizeof(crc), writer->file);
+}
+
+// Uncompressed data goes through the Adler-32 checksum of the zlib stream
+void png_zlib_write(PngWriter *writer, const uint8_t *data, uint32_t length) {
+	for (uint32_t i = 0; i < length; i++) {
+		writer->adler_a = (writer->adler_a + data[i]) % 65521;
+		writer->adler_b = (writer->adler_b + writer->adler_a) % 65521;
+	}
+	png_chunk_write(writer, data, length);
+}
+
+void write_u32_be(uint8_t *out, uint32_t value) {
+	out[0] = value >> 24;
+	out[1] = value >> 16;
+	out[2] = value >> 8;
+	out[3] = value;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t length) {
+	static uint32_t table[256];
+	static bool table_ready = false;
+
+	if (!table_ready) {
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (uint32_t k = 0; k < 8; k++)
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		table_ready = true;
+	}
+
+	for (uint32_t i = 0; i < length; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
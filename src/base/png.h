@@ -0,0 +1,27 @@
+/**
+ * @file png.h
+ * @brief Minimal PNG writer for frame captures
+ *
+ * Writes 8-bit RGBA images with uncompressed (stored) deflate blocks, so no
+ * compression library is needed. Files are about as large as the raw pixels.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Writes an RGBA8 image to path
+ *
+ * @param path Output file
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param pixels width * height * 4 bytes, rows packed
+ * @param flip_vertically Write the rows bottom to top, for pixels read back from GL
+ * @return true if the file was written
+ *
+ * Example:
+ *   png_write_rgba("frame.png", width, height, pixels, true);
+ */
+bool png_write_rgba(const char *path, uint32_t width, uint32_t height, const uint8_t *pixels, bool flip_vertically);
@@ -0,0 +1,136 @@
+/**
+ * @file pool.c
+ * @brief Implementation of the fixed-size pool (blocks of slots threaded on a free list)
+ */
+
+#include "pool.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define NO_SLOT UINT32_MAX
+
+// Sits in front of every element, its size keeps the elements 16 byte aligned
+typedef struct {
+	uint32_t index;
+	uint32_t generation; // Bumped on free, never 0
+	uint32_t next_free; // Next slot of the free list, NO_SLOT at its end
+	uint32_t live;
+} PoolSlot;
+
+struct pool {
+	size_t slot_size; // PoolSlot plus the element, rounded up to 16 bytes
+	uint32_t slots_per_block;
+	uint8_t **blocks;
+	uint32_t block_count, block_capacity;
+	uint32_t free_head; // NO_SLOT if every slot is live
+	PoolStats stats;
+};
+
+static PoolSlot *pool_slot(const Pool *pool, uint32_t index);
+static void pool_grow(Pool *pool);
+
+Pool *pool_create(size_t element_size, uint32_t elements_per_block) {
+	Pool *pool = malloc(sizeof(Pool));
+
+	*pool = (Pool){ 0 };
+	pool->slot_size = (sizeof(PoolSlot) + element_size + 15) & ~(size_t)15;
+	pool->slots_per_block = elements_per_block ? elements_per_block : 1;
+	pool->free_head = NO_SLOT;
+
+	return pool;
+}
+
+void pool_destroy(Pool *pool) {
+	if (pool == NULL)
+		return;
+
+	for (uint32_t i = 0; i < pool->block_count; i++)
+		free(pool->blocks[i]);
+	free(pool->blocks);
+	free(pool);
+}
+
+void *pool_alloc(Pool *pool, PoolHandle *handle) {
+	if (pool->free_head == NO_SLOT)
+		pool_grow(pool);
+
+	PoolSlot *slot = pool_slot(pool, pool->free_head);
+	pool->free_head = slot->next_free;
+	slot->live = true;
+
+	pool->stats.allocations++;
+	pool->stats.live++;
+
+	if (handle)
+		*handle = (PoolHandle){ .index = slot->index, .generation = slot->generation };
+	return slot + 1;
+}
+
+void pool_free(Pool *pool, void *element) {
+	if (element == NULL)
+		return;
+
+	PoolSlot *slot = (PoolSlot *)element - 1;
+	if (!slot->live)
+		return;
+
+	slot->live = false;
+	if (++slot->generation == 0)
+		slot->generation = 1;
+
+	slot->next_free = pool->free_head;
+	pool->free_head = slot->index;
+
+	pool->stats.frees++;
+	pool->stats.live--;
+}
+
+void *pool_get(const Pool *pool, PoolHandle handle) {
+	if (handle.generation == 0 || handle.index >= pool->stats.capacity)
+		return NULL;
+
+	PoolSlot *slot = pool_slot(pool, handle.index);
+	return slot->live && slot->generation == handle.generation ? slot + 1 : NULL;
+}
+
+PoolHandle pool_handle(const Pool *pool, const void *element) {
+	if (element == NULL)
+		return (PoolHandle){ 0 };
+
+	const PoolSlot *slot = (const PoolSlot *)element - 1;
+	if (slot->index >= pool->stats.capacity || pool_slot(pool, slot->index) != slot || !slot->live)
+		return (PoolHandle){ 0 };
+
+	return (PoolHandle){ .index = slot->index, .generation = slot->generation };
+}
+
+void pool_get_stats(const Pool *pool, PoolStats *stats) {
+	*stats = pool->stats;
+}
+
+PoolSlot *pool_slot(const Pool *pool, uint32_t index) {
+	uint8_t *block = pool->blocks[index / pool->slots_per_block];
+	return (PoolSlot *)(block + (size_t)(index % pool->slots_per_block) * pool->slot_size);
+}
+
+// Adds a block and threads its slots on the free list, lowest index first
+void pool_grow(Pool *pool) {
+	if (pool->block_count == pool->block_capacity) {
+		pool->block_capacity = pool->block_capacity ? pool->block_capacity * 2 : 4;
+		pool->blocks = realloc(pool->blocks, sizeof(uint8_t *) * pool->block_capacity);
+		pool->stats.heap_allocations++;
+	}
+
+	pool->blocks[pool->block_count++] = malloc(pool->slot_size * pool->slots_per_block);
+	pool->stats.heap_allocations++;
+
+	uint32_t first = pool->stats.capacity;
+	pool->stats.capacity += pool->slots_per_block;
+
+	for (uint32_t index = pool->stats.capacity; index-- > first;) {
+		PoolSlot *slot = pool_slot(pool, index);
+		*slot = (PoolSlot){ .index = index, .generation = 1, .next_free = pool->free_head, .live = false };
+		pool->free_head = index;
+	}
+}
@@ -0,0 +1,93 @@
+/**
+ * @file pool.h
+ * @brief Fixed-size object pool with generation-checked handles
+ *
+ * The pool hands out elements of one size from blocks it allocates a batch at a time,
+ * so creating and destroying many small objects doesn't go through malloc and free
+ * once the pool has grown to the peak count. Elements never move. Freed elements are
+ * reused first, which keeps live objects packed into few blocks.
+ *
+ * Every element can also be named by a handle that carries the generation of its slot.
+ * Freeing an element bumps the generation, so a handle kept past the free resolves to
+ * NULL instead of to whatever reused the slot. The pool is not thread safe.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct pool Pool;
+
+/**
+ * @brief Names an element of a pool, a zeroed handle is never valid
+ */
+typedef struct {
+	uint32_t index;
+	uint32_t generation;
+} PoolHandle;
+
+/**
+ * @brief Allocation counters, cumulative since the pool was created
+ */
+typedef struct {
+	uint64_t allocations, frees; // Elements handed out and given back
+	uint64_t heap_allocations; // malloc and realloc calls made to grow the pool
+	uint32_t live; // Elements handed out and not given back yet
+	uint32_t capacity; // Elements the pool holds without growing
+} PoolStats;
+
+/**
+ * @brief Creates an empty pool, no block is allocated until the first pool_alloc
+ *
+ * @param element_size Size of each element in bytes, elements are 16 byte aligned
+ * @param elements_per_block Elements allocated at once whenever the pool runs out
+ * @return Pointer to the new pool
+ *
+ * Example:
+ *   Pool *buffers = pool_create(sizeof(OpenGLBuffer), 64);
+ */
+Pool *pool_create(size_t element_size, uint32_t elements_per_block);
+
+/**
+ * @brief Frees the pool and every element still in it
+ */
+void pool_destroy(Pool *pool);
+
+/**
+ * @brief Hands out an element, its contents are undefined
+ *
+ * @param handle Receives the handle of the element, may be NULL
+ * @return Pointer to the element
+ *
+ * Example:
+ *   PoolHandle handle;
+ *   OpenGLBuffer *buffer = pool_alloc(buffers, &handle);
+ */
+void *pool_alloc(Pool *pool, PoolHandle *handle);
+
+/**
+ * @brief Gives element back to the pool and invalidates its handles
+ *
+ * Freeing NULL or an element that was already freed does nothing.
+ */
+void pool_free(Pool *pool, void *element);
+
+/**
+ * @brief Resolves a handle
+ *
+ * @return Pointer to the element, or NULL if it was freed since the handle was taken
+ */
+void *pool_get(const Pool *pool, PoolHandle handle);
+
+/**
+ * @brief Returns the handle of a live element of the pool
+ *
+ * @return The handle, or a zeroed one if element is NULL, freed or from another pool
+ */
+PoolHandle pool_handle(const Pool *pool, const void *element);
+
+/**
+ * @brief Writes the allocation counters of the pool to stats
+ */
+void pool_get_stats(const Pool *pool, PoolStats *stats);
@@ -1,5 +1,14 @@
 #include "base.h"
+#include "base/arena.h"
+#include "base/clock.h"
+#include "base/job_system.h"
+#include "base/png.h"
+#include "profiler.h"
 #include "renderer.h"
+#include "renderer/gl_renderer.h"
+#include "renderer/null_renderer.h"
+#include "terrain.h"
+#include "voxel.h"
 #include <cglm/vec3.h>
 
 #define GLAD_GL_IMPLEMENTATION
@@ -8,73 +17,183 @@
 #include <GLFW/glfw3.h>
 #include <cglm/affine-mat.h>
 #include <cglm/cglm.h>
-#include <fnl/FastNoiseLite.h>
 #include <stb/stb_image.h>
 
 #include <stdint.h>
-
-#define WINDOW_WIDTH  1280
-#define WINDOW_HEIGHT 720
-#define PLANE_SIZE	  1000
-#define SUB_DIVISION  256
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WINDOW_WIDTH			1280
+#define WINDOW_HEIGHT			720
+#define ORBIT_RADIUS			1250.f
+#define VIEW_DISTANCE			1500.f
+#define HEADLESS_FRAME_COUNT	600 // Frames a headless run renders unless --frames says otherwise
+#define HEADLESS_DELTA_TIME		(1.f / 60.f)
+#define HEADLESS_ORBIT_SPEED	30.f // Degrees of yaw per second
+#define PNG_INTERVAL			60 // Frames between PNG captures unless --png-interval says otherwise
+#define PROFILER_WINDOW			600 // Frames the rolling frame time stats of a windowed run cover
+#define PROFILER_LOG_INTERVAL	120 // Frames between frame time reports of a windowed run
+#define TEXTURE_UPLOAD_BUDGET	(1.0 / 1000.0) // Seconds per frame spent uploading textures that finished loading
+#define TEXTURE_LAYER_SIZE		512 // Side of the terrain texture array layers
+#define TEXTURE_CACHE_DIRECTORY	"cache/textures" // Cooked textures unless --texture-cache says otherwise
+#define MESH_CACHE_DIRECTORY	"cache/meshes" // Terrain chunk meshes unless --mesh-cache says otherwise
+#define VOXEL_WORLD_LAYERS		2 // Chunks stacked vertically in the --voxel-world and --voxel-benchmark worlds
+#define VOXEL_HEIGHT_SCALE		24.f // Blocks of height noise 1 maps to
+#define VOXEL_BLOCK_SIZE		4.f // World units per block
+#define VOXEL_EDIT_INTERVAL		10 // Frames between the scripted edits of a --voxel-world run
+#define VOXEL_EDIT_RADIUS		4 // Blocks
+#define PICK_DISTANCE			(VIEW_DISTANCE * 2) // How far the camera ray looks for what the camera points at
+#define FRAME_ARENA_SIZE		(64 * 1024) // Bytes of scratch memory a frame gets before the arena grows
 
 #define Min(a, b) (((a) < (b)) ? a : b)
 #define Max(a, b) (((a) > (b)) ? a : b)
 
+typedef struct {
+	uint32_t thread_count; // --threads N, 0 = one per core, 1 = single-threaded
+	RendererAPI backend; // --backend opengl|none, none runs headless on the null renderer
+	uint32_t frame_count; // --frames N, 0 = until the window closes
+	const char *record_path; // --record FILE, writes the null renderer command stream
+	bool offscreen; // --offscreen, renders OpenGL into an EGL framebuffer instead of a window
+	const char *png_directory; // --png DIR, offscreen frame captures
+	uint32_t png_interval; // --png-interval N
+	const char *profile_path; // --profile FILE, a Chrome trace if it ends in .json, a CSV otherwise
+	const char *texture_cache; // --texture-cache DIR|none, where cooked textures are kept, NULL = don't cook
+	const char *mesh_cache; // --mesh-cache DIR|none, where generated terrain chunks are kept, NULL = always generate
+	TerrainVertexLayout terrain_vertices; // --terrain-vertices quantized|float
+	uint32_t voxel_world; // --voxel-world N, draws N x N voxel chunk columns that get dug into instead of the terrain
+	uint32_t voxel_benchmark; // --voxel-benchmark N, meshes N x N voxel chunk columns on the CPU, reports and exits
+	uint32_t ray_batch; // --ray-batch N, also casts N rays from the camera at the ground every frame through the batch API
+} Options;
+
+// Cumulative over the run
+typedef struct {
+	uint64_t picks, hits;
+	double seconds, max_seconds;
+	uint64_t batch_rays, batch_hits;
+	double batch_seconds;
+} PickStats;
+
+// Heap use of the renderer's object pools and the frame arena, cumulative over the run
+typedef struct {
+	uint64_t heap_allocations;
+	uint32_t frames; // Frames that made at least one heap allocation
+	uint32_t last_frame; // Last frame that made one
+} HeapStats;
+
+Options parse_options(int argc, char **argv);
+fnl_state voxel_noise(void);
+void voxel_scripted_edit(VoxelWorld *world, uint32_t columns, uint32_t edit_index);
+void voxel_benchmark(uint32_t columns);
+void pick(Camera *camera, Terrain *terrain, VoxelWorld *voxel_world, Arena *frame_arena, uint32_t batch_count, PickStats *stats);
+void count_heap_allocations(Renderer *renderer, const Arena *frame_arena, uint32_t frame_index, HeapStats *stats);
+void scripted_camera(float time, float *yaw, float *pitch);
+void log_frame_stats(Profiler *profiler);
 void window_resize(GLFWwindow *window, int width, int height);
-void generate_plane_vertices(float size, uint32_t sub_division, float *vertices, uint32_t *indices);
 void get_mouse_offset(GLFWwindow *window, float *x_offset, float *y_offset);
 
-int main(void) {
-	glfwInit();
-
-	glfwWindowHint(GLFW_RESIZABLE, false);
-	GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Simple renderer", NULL, NULL);
-	glfwMakeContextCurrent(window);
-	gladLoadGL(glfwGetProcAddress);
+int main(int argc, char **argv) {
+	Options options = parse_options(argc, argv);
 	logger_set_level(LOG_LEVEL_DEBUG);
-
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	stbi_set_flip_vertically_on_load(true);
 
-	glEnable(GL_DEPTH_TEST);
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	if (options.voxel_benchmark) {
+		voxel_benchmark(options.voxel_benchmark);
+		return 0;
+	}
 
-	Renderer *gl_renderer = renderer_create(BACKEND_API_OPENGL);
-	glfwSetWindowUserPointer(window, gl_renderer);
-	glfwSetWindowSizeCallback(window, window_resize);
+	// Headless and offscreen runs have no window, the camera follows a scripted path at a fixed time step instead
+	GLFWwindow *window = NULL;
+	OpenGLOffscreen *offscreen = NULL;
+	if (options.backend == BACKEND_API_OPENGL && options.offscreen) {
+		offscreen = opengl_offscreen_create(WINDOW_WIDTH, WINDOW_HEIGHT);
+		if (offscreen == NULL)
+			return 1;
+	} else if (options.backend == BACKEND_API_OPENGL) {
+		glfwInit();
+
+		glfwWindowHint(GLFW_RESIZABLE, false);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Simple renderer", NULL, NULL);
+		glfwMakeContextCurrent(window);
+		gladLoadGL(glfwGetProcAddress);
+
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	}
 
-	// Vertex data
-	float vertices[((SUB_DIVISION + 2) * (SUB_DIVISION + 2)) * 5];
-	uint32_t indices[((SUB_DIVISION + 1) * (SUB_DIVISION + 1)) * 6];
-	generate_plane_vertices(PLANE_SIZE, SUB_DIVISION, vertices, indices);
+	if (options.backend == BACKEND_API_OPENGL) {
+		glEnable(GL_DEPTH_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	}
+	if (window == NULL && options.frame_count == 0)
+		options.frame_count = HEADLESS_FRAME_COUNT;
 
-	VertexAttribute attributes[] = {
-		{ .name = "a_position", .format = FORMAT_FLOAT3 },
-		{ .name = "a_uv", .format = FORMAT_FLOAT2 },
-	};
-	Buffer *vertex_buffer = gl_renderer->buffer_create(gl_renderer, BUFFER_TYPE_VERTEX, sizeof(vertices), vertices);
-	gl_renderer->buffer_set_layout(gl_renderer, vertex_buffer, attributes, 2);
-	Buffer *index_buffer = gl_renderer->buffer_create(gl_renderer, BUFFER_TYPE_INDEX, sizeof(indices), indices);
+	uint8_t *capture_pixels = NULL;
+	if (offscreen && options.png_directory)
+		capture_pixels = malloc(WINDOW_WIDTH * WINDOW_HEIGHT * 4);
+
+	Renderer *renderer = renderer_create(options.backend);
+	if (window) {
+		glfwSetWindowUserPointer(window, renderer);
+		glfwSetWindowSizeCallback(window, window_resize);
+	}
+
+	FILE *record_file = NULL;
+	if (options.record_path && options.backend == BACKEND_API_NONE) {
+		record_file = fopen(options.record_path, "w");
+		if (record_file == NULL)
+			LOG_ERROR("Can't open [ %s ] for recording", options.record_path);
+		null_renderer_record(renderer, record_file);
+	}
+
+	JobSystem *jobs = job_system_create(options.thread_count);
+
+	// Terrain, either the heightmap or a voxel world
+	Terrain *terrain = NULL;
+	VoxelWorld *voxel_world = NULL;
+	if (options.voxel_world) {
+		fnl_state noise = voxel_noise();
+		const uint32_t size[3] = { options.voxel_world, VOXEL_WORLD_LAYERS, options.voxel_world };
+		voxel_world = voxel_world_create(renderer, jobs, size, VOXEL_BLOCK_SIZE, &noise, VOXEL_HEIGHT_SCALE);
+	} else {
+		terrain = terrain_create(renderer, jobs, VIEW_DISTANCE, options.terrain_vertices);
+		terrain_set_mesh_cache(terrain, options.mesh_cache);
+	}
 
 	// Textures
+	renderer->texture_cache_set(renderer, options.texture_cache);
+	// One array holds every terrain texture, so the terrain draws with a single texture binding
 	const char *paths[] = { "assets/textures/container.jpg", "assets/textures/awesomeface.png" };
-	Texture *texture0 = gl_renderer->texture_load(gl_renderer, paths[0]);
-	Texture *texture1 = gl_renderer->texture_load(gl_renderer, paths[1]);
+	Texture *terrain_textures = renderer->texture_array_load_async(renderer, jobs, paths, 2, TEXTURE_LAYER_SIZE, TEXTURE_LAYER_SIZE);
 
 	// Shader
-	Shader *shader = gl_renderer->shader_from_file("assets/shaders/vertex_shader.glsl", "assets/shaders/fragment_shader.glsl", NULL);
-	gl_renderer->shader_activate(shader);
-	gl_renderer->shader_seti(shader, "u_texture_1", 0);
-	gl_renderer->shader_seti(shader, "u_texture_2", 1);
+	const char *vertex_shader_path = voxel_world ? "assets/shaders/voxel_vertex_shader.glsl" : "assets/shaders/vertex_shader.glsl";
+	Shader *shader = renderer->shader_from_file(vertex_shader_path, "assets/shaders/fragment_shader.glsl", NULL);
+	renderer->shader_activate(shader);
+	renderer->shader_seti(shader, "u_textures", 0);
+	Uniform u_model = renderer->shader_uniform(shader, "u_model");
+
+	UniformBuffer *frame_uniform_buffer = renderer->uniform_buffer_create(renderer, sizeof(FrameUniforms), FRAME_UNIFORM_BINDING);
 
 	// MVP matrices
 	mat4 model;
 	glm_mat4_identity(model);
 
+	// Draws are recorded into the queue and issued sorted once per frame
+	RenderQueue *render_queue = render_queue_create(renderer, VIEW_DISTANCE * 2);
+	RenderPacket terrain_material = {
+		.pass = RENDER_PASS_OPAQUE,
+		.shader = shader,
+		.textures = { terrain_textures },
+		.model_uniform = u_model,
+		.model = (float *)model,
+	};
+
 	// Camera
 	Camera *camera = camera_create();
-	camera_set_perspective(camera, glm_rad(45.0f), 0.1f, (PLANE_SIZE * 3));
+	camera_set_perspective(camera, glm_rad(45.0f), 0.1f, (VIEW_DISTANCE * 2));
 
 	vec3 camera_position = { 0.f, 5.f, 100.0f }, camera_target = { 0.0f, 0.0f, 0.0f };
 	float yaw = 0.0f, pitch = 45.0f;
@@ -83,55 +202,407 @@ int main(void) {
 	float delta_time = 0.0f;
 	float last_frame = 0.0f;
 
-	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
+	// What the camera points at, and the --ray-batch rays
+	PickStats pick_stats = { 0 };
 
-		float current_frame = glfwGetTime();
+	// Scratch memory that only lives for the frame it's allocated in
+	Arena *frame_arena = arena_create(FRAME_ARENA_SIZE);
+	HeapStats heap_stats = { 0 };
+	count_heap_allocations(renderer, frame_arena, 0, &heap_stats);
+
+	// Runs with a fixed frame count report stats over all of them
+	Profiler *profiler = profiler_create(renderer, options.frame_count ? options.frame_count : PROFILER_WINDOW);
+	profiler_capture(profiler, options.profile_path != NULL);
+
+	uint32_t frame_index = 0;
+
+	while (window ? !glfwWindowShouldClose(window) : true) {
+		if (options.frame_count && frame_index == options.frame_count)
+			break;
+
+		profiler_frame_begin(profiler);
+		arena_reset(frame_arena);
+		float current_frame = window ? glfwGetTime() : frame_index * HEADLESS_DELTA_TIME;
 		delta_time = current_frame - last_frame;
 		last_frame = current_frame;
 
-		float x_offset = 0.0f, y_offset = 0.0f;
-		get_mouse_offset(window, &x_offset, &y_offset);
+		renderer->frame_begin(renderer);
+		PROFILE_ZONE(profiler, "Texture stream") {
+			renderer->texture_stream(renderer, TEXTURE_UPLOAD_BUDGET);
+		}
 
-		yaw += x_offset * delta_time * camera_sensitivity;
-		yaw = yaw > 360.f ? 0.f : yaw < 0.0f ? 360.f
-											 : yaw;
-		pitch += y_offset * delta_time * camera_sensitivity;
-		pitch = Max(5.0f, Min(105.0f, pitch));
+		if (window) {
+			float x_offset = 0.0f, y_offset = 0.0f;
+			glfwPollEvents();
+			get_mouse_offset(window, &x_offset, &y_offset);
+
+			yaw += x_offset * delta_time * camera_sensitivity;
+			yaw = yaw > 360.f ? 0.f : yaw < 0.0f ? 360.f
+												 : yaw;
+			pitch += y_offset * delta_time * camera_sensitivity;
+			pitch = Max(5.0f, Min(105.0f, pitch));
+		} else {
+			scripted_camera(current_frame, &yaw, &pitch);
+		}
 
-		camera_position[0] = (PLANE_SIZE * 1.25f) * cos(glm_rad(yaw)) * sin(glm_rad(pitch));
-		camera_position[1] = (PLANE_SIZE * 1.25f) * cos(glm_rad(pitch));
-		camera_position[2] = (PLANE_SIZE * 1.25f) * sin(glm_rad(yaw)) * sin(glm_rad(pitch));
+		camera_position[0] = ORBIT_RADIUS * cos(glm_rad(yaw)) * sin(glm_rad(pitch));
+		camera_position[1] = ORBIT_RADIUS * cos(glm_rad(pitch));
+		camera_position[2] = ORBIT_RADIUS * sin(glm_rad(yaw)) * sin(glm_rad(pitch));
 
 		glm_vec3_scale(camera_target, 0, camera_target);
 		glm_vec3_sub(camera_target, camera_position, camera_target);
 		camera_update(camera, camera_position, camera_target, (vec3){ 0.0f, 1.0f, 0.0f });
+		PROFILE_ZONE(profiler, "Terrain update") {
+			if (voxel_world) {
+				if (frame_index % VOXEL_EDIT_INTERVAL == VOXEL_EDIT_INTERVAL - 1)
+					voxel_scripted_edit(voxel_world, options.voxel_world, frame_index / VOXEL_EDIT_INTERVAL);
+				voxel_world_update(voxel_world, camera_position);
+			} else {
+				terrain_update(terrain, camera_position);
+			}
+		}
+		PROFILE_ZONE(profiler, "Pick") {
+			pick(camera, terrain, voxel_world, frame_arena, options.ray_batch, &pick_stats);
+		}
+
+		profiler_gpu_zone_begin(profiler, "Scene");
+		if (options.backend == BACKEND_API_OPENGL) {
+			glClearColor(0.95f, .95f, .95f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+
+		FrameUniforms frame_uniforms = {
+			.camera_position = { camera_position[0], camera_position[1], camera_position[2], 1.f },
+			.time = current_frame,
+			.delta_time = delta_time,
+		};
+		memcpy(frame_uniforms.view, camera_get_view(camera), sizeof(frame_uniforms.view));
+		memcpy(frame_uniforms.projection, camera_get_projection(camera), sizeof(frame_uniforms.projection));
+		memcpy(frame_uniforms.view_projection, camera_get_view_projection(camera), sizeof(frame_uniforms.view_projection));
+		renderer->uniform_buffer_update(renderer, frame_uniform_buffer, &frame_uniforms, 0, sizeof(FrameUniforms));
+
+		PROFILE_ZONE(profiler, "Terrain draw") {
+			Frustum frustum;
+			camera_get_frustum(camera, &frustum);
+			if (voxel_world)
+				voxel_world_draw(voxel_world, &frustum, render_queue, &terrain_material);
+			else
+				terrain_draw(terrain, &frustum, render_queue, &terrain_material);
+		}
 
-		glClearColor(0.95f, .95f, .95f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		RenderQueueStats render_stats;
+		PROFILE_ZONE(profiler, "Render queue submit") {
+			render_queue_submit(render_queue, &render_stats);
+		}
+		profiler_gpu_zone_end(profiler);
+		LOG_TRACE("%u draws, binds skipped: %u shader, %u texture, %u buffer", render_stats.packets, render_stats.shader_binds_skipped,
+				  render_stats.texture_binds_skipped, render_stats.buffer_binds_skipped);
+
+		renderer->frame_end(renderer);
+
+		// Nothing presents offscreen, so wait for the GPU to time the whole frame rather than just its submission
+		if (offscreen)
+			glFinish();
+
+		profiler_frame_end(profiler);
+		count_heap_allocations(renderer, frame_arena, frame_index, &heap_stats);
+		frame_index++;
+		if (window && frame_index % PROFILER_LOG_INTERVAL == 0)
+			log_frame_stats(profiler);
+
+		bool last_frame_reached = frame_index == options.frame_count;
+		if (capture_pixels && (frame_index % options.png_interval == 0 || last_frame_reached)) {
+			char path[512];
+			snprintf(path, sizeof(path), "%s/frame_%05u.png", options.png_directory, frame_index);
+			opengl_offscreen_read_pixels(offscreen, capture_pixels);
+			if (!png_write_rgba(path, WINDOW_WIDTH, WINDOW_HEIGHT, capture_pixels, true))
+				LOG_ERROR("Can't write frame capture [ %s ]", path);
+		}
 
-		gl_renderer->shader_activate(shader);
-		gl_renderer->shader_set4fm(shader, "u_model", (float *)model);
-		gl_renderer->shader_set4fm(shader, "u_view", camera_get_view(camera));
-		gl_renderer->shader_set4fm(shader, "u_projection", camera_get_projection(camera));
+		if (window)
+			glfwSwapBuffers(window);
+	}
 
-		gl_renderer->texture_activate(gl_renderer, texture0, 0);
-		gl_renderer->texture_activate(gl_renderer, texture1, 1);
-		gl_renderer->draw_indexed(gl_renderer, vertex_buffer, index_buffer, ((SUB_DIVISION + 1) * (SUB_DIVISION + 1)) * 6);
+	if (frame_index > 0)
+		log_frame_stats(profiler);
+	if (options.profile_path) {
+		size_t length = strlen(options.profile_path);
+		if (length >= 5 && strcmp(options.profile_path + length - 5, ".json") == 0)
+			profiler_write_trace(profiler, options.profile_path);
+		else
+			profiler_write_csv(profiler, options.profile_path);
+	}
+	if (frame_index > 0) {
+		RendererStats stats;
+		renderer->get_stats(renderer, &stats);
+		LOG_INFO("Per frame: %.1f draws, %.0f triangles, %.0f bytes uploaded, %.1f shader / %.1f texture / %.1f buffer binds, %.1f uniform sets",
+				 (double)stats.draw_calls / frame_index, (double)stats.triangles / frame_index, (double)stats.bytes_uploaded / frame_index,
+				 (double)stats.shader_binds / frame_index, (double)stats.texture_binds / frame_index, (double)stats.buffer_binds / frame_index,
+				 (double)stats.uniform_sets / frame_index);
+		if (heap_stats.frames)
+			LOG_INFO("Allocators: %llu renderer objects, %llu heap allocations in %u of %u frames, none after frame %u", (unsigned long long)stats.object_allocations,
+					 (unsigned long long)heap_stats.heap_allocations, heap_stats.frames, frame_index, heap_stats.last_frame);
+		else
+			LOG_INFO("Allocators: %llu renderer objects, no heap allocations during the %u frames", (unsigned long long)stats.object_allocations, frame_index);
+	}
+	if (voxel_world) {
+		VoxelWorldStats stats;
+		voxel_world_get_stats(voxel_world, &stats);
+		LOG_INFO("Voxel re-meshing: %llu batches, %llu chunks, %llu sections, %.2f ms average / %.2f ms max per batch, %llu buffer rewrites, %llu buffer swaps",
+				 (unsigned long long)stats.batches, (unsigned long long)stats.chunks_remeshed, (unsigned long long)stats.sections_remeshed,
+				 stats.batches ? stats.remesh_seconds / stats.batches * 1e3 : 0.0, stats.max_remesh_seconds * 1e3, (unsigned long long)stats.buffer_updates,
+				 (unsigned long long)stats.buffer_swaps);
+	}
 
-		glfwSwapBuffers(window);
+	if (pick_stats.picks > 0) {
+		LOG_INFO("Picking: %.2f us average / %.2f us max per camera ray, %llu of %llu hit", pick_stats.seconds / pick_stats.picks * 1e6, pick_stats.max_seconds * 1e6,
+				 (unsigned long long)pick_stats.hits, (unsigned long long)pick_stats.picks);
+	}
+	if (pick_stats.batch_rays > 0) {
+		LOG_INFO("Batched rays: %llu in %.1f ms, %.2f M rays/s, %llu hit", (unsigned long long)pick_stats.batch_rays, pick_stats.batch_seconds * 1e3,
+				 pick_stats.batch_rays / pick_stats.batch_seconds * 1e-6, (unsigned long long)pick_stats.batch_hits);
 	}
 
-	gl_renderer->shader_destroy(shader);
-	gl_renderer->buffer_destroy(gl_renderer, vertex_buffer);
-	gl_renderer->texture_destroy(gl_renderer, texture0);
-	gl_renderer->texture_destroy(gl_renderer, texture1);
-	renderer_destroy(gl_renderer);
-	glfwDestroyWindow(window);
-	glfwTerminate();
+	profiler_destroy(profiler);
+	render_queue_destroy(render_queue);
+	renderer->shader_destroy(shader);
+	renderer->uniform_buffer_destroy(renderer, frame_uniform_buffer);
+	terrain_destroy(terrain);
+	voxel_world_destroy(voxel_world);
+	renderer->texture_destroy(renderer, terrain_textures);
+	renderer_destroy(renderer);
+	job_system_destroy(jobs);
+	free(capture_pixels);
+	arena_destroy(frame_arena);
+	if (record_file)
+		fclose(record_file);
+	opengl_offscreen_destroy(offscreen);
+	if (window) {
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
 	return 0;
 }
 
+Options parse_options(int argc, char **argv) {
+	Options options = { .thread_count = 0, .backend = BACKEND_API_OPENGL, .png_interval = PNG_INTERVAL, .texture_cache = TEXTURE_CACHE_DIRECTORY, .mesh_cache = MESH_CACHE_DIRECTORY, .terrain_vertices = TERRAIN_VERTEX_QUANTIZED };
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			options.thread_count = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			options.frame_count = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			options.record_path = argv[++i];
+		else if (strcmp(argv[i], "--offscreen") == 0)
+			options.offscreen = true;
+		else if (strcmp(argv[i], "--png") == 0 && i + 1 < argc)
+			options.png_directory = argv[++i];
+		else if (strcmp(argv[i], "--png-interval") == 0 && i + 1 < argc)
+			options.png_interval = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			options.profile_path = argv[++i];
+		else if (strcmp(argv[i], "--texture-cache") == 0 && i + 1 < argc) {
+			const char *directory = argv[++i];
+			options.texture_cache = strcmp(directory, "none") == 0 ? NULL : directory;
+		} else if (strcmp(argv[i], "--mesh-cache") == 0 && i + 1 < argc) {
+			const char *directory = argv[++i];
+			options.mesh_cache = strcmp(directory, "none") == 0 ? NULL : directory;
+		} else if (strcmp(argv[i], "--terrain-vertices") == 0 && i + 1 < argc) {
+			const char *layout = argv[++i];
+			if (strcmp(layout, "quantized") == 0)
+				options.terrain_vertices = TERRAIN_VERTEX_QUANTIZED;
+			else if (strcmp(layout, "float") == 0)
+				options.terrain_vertices = TERRAIN_VERTEX_FLOAT;
+			else
+				LOG_WARN("Unknown terrain vertex layout [ %s ], using quantized", layout);
+		} else if (strcmp(argv[i], "--voxel-world") == 0 && i + 1 < argc)
+			options.voxel_world = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--voxel-benchmark") == 0 && i + 1 < argc)
+			options.voxel_benchmark = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--ray-batch") == 0 && i + 1 < argc)
+			options.ray_batch = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+			const char *backend = argv[++i];
+			if (strcmp(backend, "opengl") == 0)
+				options.backend = BACKEND_API_OPENGL;
+			else if (strcmp(backend, "none") == 0)
+				options.backend = BACKEND_API_NONE;
+			else
+				LOG_WARN("Unknown backend [ %s ], using opengl", backend);
+		} else
+			LOG_WARN("Unknown argument [ %s ]", argv[i]);
+	}
+
+	if (options.png_interval == 0)
+		options.png_interval = PNG_INTERVAL;
+
+	return options;
+}
+
+// The terrain's noise settings
+fnl_state voxel_noise(void) {
+	fnl_state noise = fnlCreateState();
+	noise.noise_type = FNL_NOISE_PERLIN;
+	noise.fractal_type = FNL_FRACTAL_RIDGED;
+	noise.octaves = 3;
+	return noise;
+}
+
+// Digs a sphere out of the surface, walking a spiral around the world centre from one edit to the next
+void voxel_scripted_edit(VoxelWorld *world, uint32_t columns, uint32_t edit_index) {
+	const int32_t extent = (int32_t)(columns * VOXEL_CHUNK_SIZE), height = VOXEL_WORLD_LAYERS * VOXEL_CHUNK_SIZE;
+	float angle = edit_index * .7f, distance = fmodf(edit_index * 3.f, extent * .45f);
+	int32_t x = extent / 2 + (int32_t)(cosf(angle) * distance), z = extent / 2 + (int32_t)(sinf(angle) * distance);
+
+	int32_t y = height - 1;
+	while (y > 0 && voxel_world_get_block(world, x, y, z) == BLOCK_AIR)
+		y--;
+
+	for (int32_t dz = -VOXEL_EDIT_RADIUS; dz <= VOXEL_EDIT_RADIUS; dz++) {
+		for (int32_t dy = -VOXEL_EDIT_RADIUS; dy <= VOXEL_EDIT_RADIUS; dy++) {
+			for (int32_t dx = -VOXEL_EDIT_RADIUS; dx <= VOXEL_EDIT_RADIUS; dx++) {
+				if (dx * dx + dy * dy + dz * dz <= VOXEL_EDIT_RADIUS * VOXEL_EDIT_RADIUS)
+					voxel_world_set_block(world, x + dx, y + dy, z + dz, BLOCK_AIR);
+			}
+		}
+	}
+}
+
+// Generates a columns x columns x VOXEL_WORLD_LAYERS world, then meshes every chunk with both meshers on this thread
+void voxel_benchmark(uint32_t columns) {
+	fnl_state noise = voxel_noise();
+
+	const uint32_t chunk_count = columns * columns * VOXEL_WORLD_LAYERS;
+	VoxelChunk **chunks = malloc(sizeof(VoxelChunk *) * chunk_count);
+
+	double start = clock_seconds();
+	size_t palette_memory = 0;
+	for (uint32_t i = 0; i < chunk_count; i++) {
+		uint32_t x = i % columns, y = i / columns % VOXEL_WORLD_LAYERS, z = i / (columns * VOXEL_WORLD_LAYERS);
+		chunks[i] = voxel_chunk_create();
+		voxel_chunk_generate(chunks[i], &noise, (int32_t)x, (int32_t)y, (int32_t)z, VOXEL_HEIGHT_SCALE);
+		palette_memory += voxel_chunk_memory(chunks[i]);
+	}
+	double generate_time = clock_seconds() - start;
+
+	VoxelMesher *mesher = voxel_mesher_create();
+	uint64_t quad_counts[2] = { 0 };
+	double mesh_times[2] = { 0 };
+	for (uint32_t mesher_index = 0; mesher_index < 2; mesher_index++) {
+		start = clock_seconds();
+		for (uint32_t i = 0; i < chunk_count; i++) {
+			int32_t x = (int32_t)(i % columns), y = (int32_t)(i / columns % VOXEL_WORLD_LAYERS), z = (int32_t)(i / (columns * VOXEL_WORLD_LAYERS));
+			const int32_t offsets[VOXEL_FACE_COUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+			const VoxelChunk *neighbours[VOXEL_FACE_COUNT];
+			for (uint32_t face = 0; face < VOXEL_FACE_COUNT; face++) {
+				int32_t nx = x + offsets[face][0], ny = y + offsets[face][1], nz = z + offsets[face][2];
+				bool inside = nx >= 0 && nx < (int32_t)columns && ny >= 0 && ny < VOXEL_WORLD_LAYERS && nz >= 0 && nz < (int32_t)columns;
+				neighbours[face] = inside ? chunks[nx + (ny + nz * VOXEL_WORLD_LAYERS) * columns] : NULL;
+			}
+
+			VoxelMesh mesh;
+			if (mesher_index == 0)
+				voxel_mesh_greedy(mesher, chunks[i], neighbours, &mesh);
+			else
+				voxel_mesh_naive(mesher, chunks[i], neighbours, &mesh);
+			quad_counts[mesher_index] += mesh.quad_count;
+		}
+		mesh_times[mesher_index] = clock_seconds() - start;
+	}
+
+	const double voxels = (double)chunk_count * VOXEL_CHUNK_VOLUME;
+	LOG_INFO("Voxel benchmark: %u chunks of %u^3, generated in %.1f ms", chunk_count, VOXEL_CHUNK_SIZE, generate_time * 1e3);
+	LOG_INFO("Greedy: %.1f ms, %.1f M voxels/s, %llu quads", mesh_times[0] * 1e3, voxels / mesh_times[0] * 1e-6,
+			 (unsigned long long)quad_counts[0]);
+	LOG_INFO("Naive: %.1f ms, %.1f M voxels/s, %llu quads (%.1fx the greedy count)", mesh_times[1] * 1e3, voxels / mesh_times[1] * 1e-6,
+			 (unsigned long long)quad_counts[1], quad_counts[0] ? (double)quad_counts[1] / quad_counts[0] : 0.0);
+	LOG_INFO("Block storage: %.1f KiB with palettes, %.1f KiB dense", palette_memory / 1024.0, voxels * sizeof(BlockId) / 1024.0);
+
+	voxel_mesher_destroy(mesher);
+	for (uint32_t i = 0; i < chunk_count; i++)
+		voxel_chunk_destroy(chunks[i]);
+	free(chunks);
+}
+
+// Casts the camera ray into the terrain or the voxel world, then batch_count rays from the camera at a grid of points on
+// the ground around the origin, the way line of sight checks for many agents would
+void pick(Camera *camera, Terrain *terrain, VoxelWorld *voxel_world, Arena *frame_arena, uint32_t batch_count, PickStats *stats) {
+	Ray ray;
+	camera_get_ray(camera, &ray);
+
+	double start = clock_seconds();
+	RayHit hit;
+	bool found;
+	if (voxel_world) {
+		VoxelRayHit voxel_hit;
+		found = voxel_world_raycast(voxel_world, &ray, PICK_DISTANCE, &voxel_hit);
+		hit = voxel_hit.hit;
+	} else {
+		found = terrain_raycast(terrain, &ray, PICK_DISTANCE, &hit);
+	}
+	double seconds = clock_seconds() - start;
+
+	stats->picks++;
+	stats->hits += found;
+	stats->seconds += seconds;
+	stats->max_seconds = seconds > stats->max_seconds ? seconds : stats->max_seconds;
+	if (found)
+		LOG_TRACE("Looking at (%.1f, %.1f, %.1f), %.1f units away", hit.position[0], hit.position[1], hit.position[2], hit.distance);
+
+	if (batch_count == 0)
+		return;
+
+	Ray *batch_rays = arena_alloc(frame_arena, sizeof(Ray) * batch_count);
+	void *batch_hits = arena_alloc(frame_arena, (voxel_world ? sizeof(VoxelRayHit) : sizeof(RayHit)) * batch_count);
+
+	const uint32_t side = (uint32_t)ceilf(sqrtf((float)batch_count));
+	for (uint32_t i = 0; i < batch_count; i++) {
+		vec3 target = { ((i % side + .5f) / side - .5f) * VIEW_DISTANCE, 0.f, ((i / side + .5f) / side - .5f) * VIEW_DISTANCE };
+		glm_vec3_copy(ray.origin, batch_rays[i].origin);
+		glm_vec3_sub(target, ray.origin, batch_rays[i].direction);
+		glm_vec3_normalize(batch_rays[i].direction);
+	}
+
+	start = clock_seconds();
+	if (voxel_world)
+		stats->batch_hits += voxel_world_raycast_batch(voxel_world, batch_rays, batch_count, PICK_DISTANCE, batch_hits);
+	else
+		stats->batch_hits += terrain_raycast_batch(terrain, batch_rays, batch_count, PICK_DISTANCE, batch_hits);
+	stats->batch_seconds += clock_seconds() - start;
+	stats->batch_rays += batch_count;
+}
+
+// Frame 0 takes what was allocated before the loop, so renderer setup shows up as frame 0 too
+void count_heap_allocations(Renderer *renderer, const Arena *frame_arena, uint32_t frame_index, HeapStats *stats) {
+	RendererStats renderer_stats;
+	ArenaStats arena_stats;
+	renderer->get_stats(renderer, &renderer_stats);
+	arena_get_stats(frame_arena, &arena_stats);
+
+	uint64_t heap_allocations = renderer_stats.heap_allocations + arena_stats.heap_allocations;
+	if (heap_allocations > stats->heap_allocations) {
+		if (stats->last_frame != frame_index || stats->frames == 0)
+			stats->frames++;
+		stats->heap_allocations = heap_allocations;
+		stats->last_frame = frame_index;
+	}
+}
+
+// Orbits at a constant rate while the pitch sways between 25 and 65 degrees, the same path on every run
+void scripted_camera(float time, float *yaw, float *pitch) {
+	*yaw = fmodf(time * HEADLESS_ORBIT_SPEED, 360.f);
+	*pitch = 45.f + 20.f * sinf(time * 0.5f);
+}
+
+void log_frame_stats(Profiler *profiler) {
+	ProfilerFrameStats stats;
+	profiler_frame_stats(profiler, &stats);
+	LOG_INFO("Last %u frames: %.3f ms min, %.3f ms average, %.3f ms p99, %.3f ms max. Last frame: %llu draws, %llu triangles, %llu bytes uploaded",
+			 stats.frames, stats.min * 1e3, stats.average * 1e3, stats.p99 * 1e3, stats.max * 1e3, (unsigned long long)stats.counters.draw_calls,
+			 (unsigned long long)stats.counters.triangles, (unsigned long long)stats.counters.bytes_uploaded);
+}
+
 void window_resize(GLFWwindow *window, int width, int height) {
 	Renderer *renderer = (Renderer *)glfwGetWindowUserPointer(window);
 
@@ -158,39 +629,3 @@ void get_mouse_offset(GLFWwindow *window, float *x_offset, float *y_offset) {
 	last_position_x = current_position_x;
 	last_position_y = current_position_y;
 }
-
-void generate_plane_vertices(float size, uint32_t sub_division, float *vertices, uint32_t *indices) {
-	uint32_t rows, columns, quad_count;
-	rows = columns = 2 + sub_division;
-	quad_count = sub_division + 1;
-	uint32_t vertices_ptr = 0, indices_ptr = 0;
-
-	fnl_state noise_parameters = fnlCreateState();
-	noise_parameters.noise_type = FNL_NOISE_PERLIN;
-	noise_parameters.fractal_type = FNL_FRACTAL_RIDGED;
-	noise_parameters.octaves = 3;
-
-	for (uint32_t z = 0; z < rows; z++) {
-		for (uint32_t x = 0; x < columns; x++) {
-			uint32_t index = x + z * columns;
-			// Position
-			vertices[vertices_ptr++] = -size / 2.f + x * ((float)size / quad_count);
-			vertices[vertices_ptr++] = (fnlGetNoise2D(&noise_parameters, x * .5f, z * .5f)) * 200;
-			vertices[vertices_ptr++] = -size / 2.f + z * ((float)size / quad_count);
-
-			// UV
-			vertices[vertices_ptr++] = (float)x / quad_count;
-			vertices[vertices_ptr++] = (float)z / quad_count;
-
-			if (x < columns - 1 && z < rows - 1) {
-				indices[indices_ptr++] = index + 1;
-				indices[indices_ptr++] = index;
-				indices[indices_ptr++] = index + columns;
-
-				indices[indices_ptr++] = index + 1;
-				indices[indices_ptr++] = index + columns;
-				indices[indices_ptr++] = index + columns + 1;
-			}
-		}
-	}
-}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "renderer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROFILER_ZONE_DEPTH		32 // Deepest CPU zone nesting that gets recorded
+#define PROFILER_GPU_ZONE_LIMIT 16 // Distinct GPU zone names
+#define PROFILER_GPU_LATENCY	2 // Timers per GPU zone, a result is read PROFILER_GPU_LATENCY frames after it was issued
+
+typedef struct _profiler Profiler;
+
+typedef struct {
+	uint64_t draw_calls, triangles, bytes_uploaded;
+} ProfilerCounters;
+
+// Frame times in seconds over the last window frames
+typedef struct {
+	uint32_t frames;
+	double min, average, p99, max;
+	ProfilerCounters counters; // Of the last finished frame
+	uint32_t gpu_samples_dropped; // GPU zone results that weren't ready in time and were skipped instead of waited on
+} ProfilerFrameStats;
+
+/**
+ * ===========================================================================================
+ * -------- Profiler
+ * ===========================================================================================
+ **/
+
+// Times frames and zones on the thread that calls it, which has to be the one that owns the renderer.
+// window is the number of frames the rolling frame time stats cover
+Profiler *profiler_create(Renderer *renderer, uint32_t window);
+void profiler_destroy(Profiler *profiler);
+
+// While capturing every frame and zone is kept for profiler_write_trace and profiler_write_csv
+void profiler_capture(Profiler *profiler, bool enabled);
+
+void profiler_frame_begin(Profiler *profiler);
+void profiler_frame_end(Profiler *profiler);
+
+// Zone names are not copied, pass string literals
+void profiler_zone_begin(Profiler *profiler, const char *name);
+void profiler_zone_end(Profiler *profiler);
+
+// GPU zones time the commands issued between begin and end with the renderer's GPU timers. They can't nest and each
+// name is meant to be used once per frame. Results show up PROFILER_GPU_LATENCY frames later, so reading them never stalls
+void profiler_gpu_zone_begin(Profiler *profiler, const char *name);
+void profiler_gpu_zone_end(Profiler *profiler);
+
+// Scoped zones for a block, leaving the block through break, goto or return skips the end of the zone
+#define PROFILE_ZONE(profiler, name) \
+	for (int _zone_once = (profiler_zone_begin(profiler, name), 1); _zone_once; _zone_once = (profiler_zone_end(profiler), 0))
+#define PROFILE_GPU_ZONE(profiler, name) \
+	for (int _gpu_zone_once = (profiler_gpu_zone_begin(profiler, name), 1); _gpu_zone_once; _gpu_zone_once = (profiler_gpu_zone_end(profiler), 0))
+
+void profiler_frame_stats(Profiler *profiler, ProfilerFrameStats *stats);
+
+// Chrome trace event JSON (chrome://tracing, ui.perfetto.dev): CPU zones on one track, GPU zones on another, placed at
+// the time they were issued, and the counters per frame
+bool profiler_write_trace(Profiler *profiler, const char *path);
+// One row per captured frame: frame time, counters and the total milliseconds of every zone name
+bool profiler_write_csv(Profiler *profiler, const char *path);
@@ -0,0 +1,386 @@
+#include "profiler.h"
+#include "base.h"
+#include "base/clock.h"
+#include "base/darray.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSV_COLUMN_LIMIT 64 // Distinct zone names written to a CSV, later ones are left out
+
+typedef struct {
+	const char *name;
+	uint64_t start, duration; // Nanoseconds, start relative to profiler_create
+	uint32_t frame;
+	uint16_t depth;
+	bool gpu;
+} ProfilerEvent;
+
+typedef struct {
+	uint32_t index;
+	uint64_t start, duration;
+	ProfilerCounters counters;
+} ProfilerFrame;
+
+typedef struct {
+	const char *name;
+	GpuTimer *timers[PROFILER_GPU_LATENCY];
+	uint64_t issued_at[PROFILER_GPU_LATENCY];
+	uint32_t issued_frame[PROFILER_GPU_LATENCY];
+	bool pending[PROFILER_GPU_LATENCY];
+} GpuZone;
+
+struct _profiler {
+	Renderer *renderer;
+	uint64_t origin;
+	bool capturing;
+
+	uint32_t frame_index;
+	uint64_t frame_start;
+	RendererStats last_stats;
+	ProfilerCounters last_counters;
+
+	struct {
+		const char *name;
+		uint64_t start;
+	} zones[PROFILER_ZONE_DEPTH];
+	uint32_t zone_depth; // May exceed PROFILER_ZONE_DEPTH, the zones past it aren't recorded
+
+	GpuZone gpu_zones[PROFILER_GPU_ZONE_LIMIT];
+	uint32_t gpu_zone_count;
+	GpuZone *active_gpu_zone;
+	uint32_t gpu_samples_dropped;
+
+	// Rolling frame times, a ring of window entries
+	double *frame_times, *frame_times_sorted;
+	uint32_t window, frame_time_count, frame_time_next;
+
+	ProfilerEvent *events; // darray, filled while capturing
+	ProfilerFrame *frames; // darray, filled while capturing
+};
+
+static uint64_t profiler_now(Profiler *profiler);
+static void gpu_zone_collect(Profiler *profiler, GpuZone *zone, uint32_t slot);
+static void write_json_string(FILE *file, const char *string);
+static int compare_double(const void *a, const void *b);
+
+Profiler *profiler_create(Renderer *renderer, uint32_t window) {
+	Profiler *profiler = malloc(sizeof(Profiler));
+
+	memset(profiler, 0, sizeof(Profiler));
+	profiler->renderer = renderer;
+	profiler->origin = clock_nanoseconds();
+	profiler->window = window ? window : 1;
+	profiler->frame_times = malloc(sizeof(double) * profiler->window);
+	profiler->frame_times_sorted = malloc(sizeof(double) * profiler->window);
+	profiler->events = darray_create(sizeof(ProfilerEvent), 1024);
+	profiler->frames = darray_create(sizeof(ProfilerFrame), 256);
+
+	renderer->get_stats(renderer, &profiler->last_stats);
+	return profiler;
+}
+
+void profiler_destroy(Profiler *profiler) {
+	if (profiler == NULL)
+		return;
+
+	for (uint32_t i = 0; i < profiler->gpu_zone_count; i++) {
+		for (uint32_t slot = 0; slot < PROFILER_GPU_LATENCY; slot++)
+			profiler->renderer->gpu_timer_destroy(profiler->renderer, profiler->gpu_zones[i].timers[slot]);
+	}
+
+	free(profiler->frame_times);
+	free(profiler->frame_times_sorted);
+	darray_free(profiler->events);
+	darray_free(profiler->frames);
+	free(profiler);
+}
+
+void profiler_capture(Profiler *profiler, bool enabled) {
+	profiler->capturing = enabled;
+}
+
+void profiler_frame_begin(Profiler *profiler) {
+	profiler->frame_start = profiler_now(profiler);
+
+	// Pick up whatever GPU results arrived since last frame
+	for (uint32_t i = 0; i < profiler->gpu_zone_count; i++) {
+		for (uint32_t slot = 0; slot < PROFILER_GPU_LATENCY; slot++)
+			gpu_zone_collect(profiler, &profiler->gpu_zones[i], slot);
+	}
+}
+
+void profiler_frame_end(Profiler *profiler) {
+	uint64_t duration = profiler_now(profiler) - profiler->frame_start;
+
+	if (profiler->zone_depth != 0) {
+		LOG_WARN("%u profiler zone(s) still open at the end of frame %u", profiler->zone_depth, profiler->frame_index);
+		profiler->zone_depth = 0;
+	}
+
+	RendererStats stats;
+	profiler->renderer->get_stats(profiler->renderer, &stats);
+	profiler->last_counters = (ProfilerCounters){
+		.draw_calls = stats.draw_calls - profiler->last_stats.draw_calls,
+		.triangles = stats.triangles - profiler->last_stats.triangles,
+		.bytes_uploaded = stats.bytes_uploaded - profiler->last_stats.bytes_uploaded,
+	};
+	profiler->last_stats = stats;
+
+	profiler->frame_times[profiler->frame_time_next] = duration * 1e-9;
+	profiler->frame_time_next = (profiler->frame_time_next + 1) % profiler->window;
+	if (profiler->frame_time_count < profiler->window)
+		profiler->frame_time_count++;
+
+	if (profiler->capturing) {
+		ProfilerFrame frame = { .index = profiler->frame_index, .start = profiler->frame_start, .duration = duration, .counters = profiler->last_counters };
+		darray_push(profiler->frames, frame);
+	}
+
+	profiler->frame_index++;
+}
+
+void profiler_zone_begin(Profiler *profiler, const char *name) {
+	if (profiler->zone_depth < PROFILER_ZONE_DEPTH) {
+		profiler->zones[profiler->zone_depth].name = name;
+		profiler->zones[profiler->zone_depth].start = profiler_now(profiler);
+	}
+	profiler->zone_depth++;
+}
+
+void profiler_zone_end(Profiler *profiler) {
+	if (profiler->zone_depth == 0) {
+		LOG_WARN("profiler_zone_end without a matching profiler_zone_begin");
+		return;
+	}
+
+	uint32_t depth = --profiler->zone_depth;
+	if (depth >= PROFILER_ZONE_DEPTH || !profiler->capturing)
+		return;
+
+	uint64_t start = profiler->zones[depth].start;
+	ProfilerEvent event = {
+		.name = profiler->zones[depth].name,
+		.start = start,
+		.duration = profiler_now(profiler) - start,
+		.frame = profiler->frame_index,
+		.depth = (uint16_t)depth,
+	};
+	darray_push(profiler->events, event);
+}
+
+void profiler_gpu_zone_begin(Profiler *profiler, const char *name) {
+	Renderer *renderer = profiler->renderer;
+	if (profiler->active_gpu_zone) {
+		LOG_WARN("GPU zone [ %s ] can't start inside [ %s ]", name, profiler->active_gpu_zone->name);
+		return;
+	}
+
+	GpuZone *zone = NULL;
+	for (uint32_t i = 0; i < profiler->gpu_zone_count && zone == NULL; i++) {
+		if (strcmp(profiler->gpu_zones[i].name, name) == 0)
+			zone = &profiler->gpu_zones[i];
+	}
+
+	if (zone == NULL) {
+		if (profiler->gpu_zone_count == PROFILER_GPU_ZONE_LIMIT) {
+			LOG_WARN("Out of GPU zones, [ %s ] isn't timed", name);
+			return;
+		}
+
+		zone = &profiler->gpu_zones[profiler->gpu_zone_count++];
+		*zone = (GpuZone){ .name = name };
+		for (uint32_t slot = 0; slot < PROFILER_GPU_LATENCY; slot++)
+			zone->timers[slot] = renderer->gpu_timer_create(renderer);
+	}
+
+	// Reusing the timer of PROFILER_GPU_LATENCY frames ago, if its result still isn't in it's dropped rather than waited on
+	uint32_t slot = profiler->frame_index % PROFILER_GPU_LATENCY;
+	gpu_zone_collect(profiler, zone, slot);
+	if (zone->pending[slot]) {
+		zone->pending[slot] = false;
+		profiler->gpu_samples_dropped++;
+	}
+
+	renderer->gpu_timer_begin(renderer, zone->timers[slot]);
+	zone->issued_at[slot] = profiler_now(profiler);
+	zone->issued_frame[slot] = profiler->frame_index;
+	profiler->active_gpu_zone = zone;
+}
+
+void profiler_gpu_zone_end(Profiler *profiler) {
+	GpuZone *zone = profiler->active_gpu_zone;
+	if (zone == NULL)
+		return;
+
+	uint32_t slot = profiler->frame_index % PROFILER_GPU_LATENCY;
+	profiler->renderer->gpu_timer_end(profiler->renderer, zone->timers[slot]);
+	zone->pending[slot] = true;
+	profiler->active_gpu_zone = NULL;
+}
+
+void profiler_frame_stats(Profiler *profiler, ProfilerFrameStats *stats) {
+	uint32_t count = profiler->frame_time_count;
+	*stats = (ProfilerFrameStats){
+		.frames = count,
+		.counters = profiler->last_counters,
+		.gpu_samples_dropped = profiler->gpu_samples_dropped,
+	};
+	if (count == 0)
+		return;
+
+	double total = 0.0;
+	memcpy(profiler->frame_times_sorted, profiler->frame_times, sizeof(double) * count);
+	for (uint32_t i = 0; i < count; i++)
+		total += profiler->frame_times_sorted[i];
+	qsort(profiler->frame_times_sorted, count, sizeof(double), compare_double);
+
+	stats->min = profiler->frame_times_sorted[0];
+	stats->average = total / count;
+	stats->p99 = profiler->frame_times_sorted[(uint32_t)((count - 1) * 0.99)];
+	stats->max = profiler->frame_times_sorted[count - 1];
+}
+
+bool profiler_write_trace(Profiler *profiler, const char *path) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		LOG_ERROR("Can't open [ %s ] for the profiler trace", path);
+		return false;
+	}
+
+	// Chrome traces are in microseconds
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+	uint32_t frame_count = darray_length(profiler->frames);
+	for (uint32_t i = 0; i < frame_count; i++) {
+		const ProfilerFrame *frame = &profiler->frames[i];
+		fprintf(file, ",\n{\"name\":\"Frame %u\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", frame->index,
+				frame->start * 1e-3, frame->duration * 1e-3);
+		fprintf(file, ",\n{\"name\":\"Counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"draw_calls\":%llu,\"triangles\":%llu,\"bytes_uploaded\":%llu}}",
+				frame->start * 1e-3, (unsigned long long)frame->counters.draw_calls, (unsigned long long)frame->counters.triangles,
+				(unsigned long long)frame->counters.bytes_uploaded);
+	}
+
+	uint32_t event_count = darray_length(profiler->events);
+	for (uint32_t i = 0; i < event_count; i++) {
+		const ProfilerEvent *event = &profiler->events[i];
+		fprintf(file, ",\n{\"name\":");
+		write_json_string(file, event->name);
+		fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}", event->gpu ? "gpu" : "cpu",
+				event->gpu ? 2 : 1, event->start * 1e-3, event->duration * 1e-3, event->frame);
+	}
+
+	fprintf(file, "\n]}\n");
+	bool written = ferror(file) == 0;
+	fclose(file);
+
+	LOG_INFO("Wrote profiler trace [ %s ] with %u frames and %u zones", path, frame_count, event_count);
+	return written;
+}
+
+bool profiler_write_csv(Profiler *profiler, const char *path) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		LOG_ERROR("Can't open [ %s ] for the profiler CSV", path);
+		return false;
+	}
+
+	uint32_t frame_count = darray_length(profiler->frames);
+	uint32_t event_count = darray_length(profiler->events);
+
+	// A column per distinct zone name, CPU and GPU zones of the same name apart
+	struct {
+		const char *name;
+		bool gpu;
+	} columns[CSV_COLUMN_LIMIT];
+	uint32_t column_count = 0;
+	uint16_t *event_columns = malloc(sizeof(uint16_t) * (event_count ? event_count : 1));
+
+	for (uint32_t i = 0; i < event_count; i++) {
+		const ProfilerEvent *event = &profiler->events[i];
+		uint32_t column = 0;
+		while (column < column_count && (columns[column].gpu != event->gpu || strcmp(columns[column].name, event->name) != 0))
+			column++;
+
+		if (column == column_count && column_count < CSV_COLUMN_LIMIT) {
+			columns[column_count].name = event->name;
+			columns[column_count].gpu = event->gpu;
+			column_count++;
+		}
+		event_columns[i] = (uint16_t)column;
+	}
+
+	// Zone milliseconds summed per frame, events store absolute frame indices and frames are captured in order
+	double *totals = calloc((size_t)frame_count * column_count + 1, sizeof(double));
+	uint32_t first_frame = frame_count ? profiler->frames[0].index : 0;
+	for (uint32_t i = 0; i < event_count; i++) {
+		const ProfilerEvent *event = &profiler->events[i];
+		if (event_columns[i] < column_count && event->frame >= first_frame && event->frame - first_frame < frame_count)
+			totals[(size_t)(event->frame - first_frame) * column_count + event_columns[i]] += event->duration * 1e-6;
+	}
+
+	fprintf(file, "frame,frame_ms,draw_calls,triangles,bytes_uploaded");
+	for (uint32_t column = 0; column < column_count; column++)
+		fprintf(file, ",%s%s_ms", columns[column].name, columns[column].gpu ? " (GPU)" : "");
+	fputc('\n', file);
+
+	for (uint32_t i = 0; i < frame_count; i++) {
+		const ProfilerFrame *frame = &profiler->frames[i];
+		fprintf(file, "%u,%.4f,%llu,%llu,%llu", frame->index, frame->duration * 1e-6, (unsigned long long)frame->counters.draw_calls,
+				(unsigned long long)frame->counters.triangles, (unsigned long long)frame->counters.bytes_uploaded);
+		for (uint32_t column = 0; column < column_count; column++)
+			fprintf(file, ",%.4f", totals[(size_t)i * column_count + column]);
+		fputc('\n', file);
+	}
+
+	bool written = ferror(file) == 0;
+	fclose(file);
+	free(totals);
+	free(event_columns);
+
+	LOG_INFO("Wrote profiler CSV [ %s ] with %u frames and %u zone columns", path, frame_count, column_count);
+	return written;
+}
+
+uint64_t profiler_now(Profiler *profiler) {
+	return clock_nanoseconds() - profiler->origin;
+}
+
+// Records the result of a GPU zone slot if the GPU delivered it, never waits
+void gpu_zone_collect(Profiler *profiler, GpuZone *zone, uint32_t slot) {
+	uint64_t nanoseconds;
+	if (!zone->pending[slot] || !profiler->renderer->gpu_timer_result(profiler->renderer, zone->timers[slot], &nanoseconds))
+		return;
+
+	zone->pending[slot] = false;
+	if (!profiler->capturing)
+		return;
+
+	ProfilerEvent event = {
+		.name = zone->name,
+		.start = zone->issued_at[slot],
+		.duration = nanoseconds,
+		.frame = zone->issued_frame[slot],
+		.gpu = true,
+	};
+	darray_push(profiler->events, event);
+}
+
+void write_json_string(FILE *file, const char *string) {
+	fputc('"', file);
+	for (const char *c = string; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			fputc('\\', file);
+		if ((unsigned char)*c >= 0x20)
+			fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+int compare_double(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "base/job_system.h"
+
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -13,7 +16,8 @@ typedef enum {
 
 typedef enum {
 	BUFFER_TYPE_VERTEX,
-	BUFFER_TYPE_INDEX,
+	BUFFER_TYPE_INDEX, // 32-bit indices
+	BUFFER_TYPE_INDEX16, // 16-bit indices, half the index bandwidth for meshes with up to 65536 vertices
 
 	BUFFER_TYPE_COUNT
 } BufferType;
@@ -24,12 +28,26 @@ typedef enum {
 	FORMAT_FLOAT3,
 	FORMAT_FLOAT4,
 
+	// Read as floats by the shader, see the vertex_pack_* helpers for the encodings
+	FORMAT_HALF2,
+	FORMAT_HALF4,
+	FORMAT_UNORM8x4, // [0, 1]
+	FORMAT_SNORM16x2, // [-1, 1]
+	FORMAT_SNORM16x4,
+	FORMAT_INT_2_10_10_10_REV, // Normalized, xyz in [-1, 1] with 10 bits each, w in {-1, 0, 1}
+
+	// Read as integers (uvec/uint in the shader)
+	FORMAT_UINT8x4,
+	FORMAT_UINT16x2,
+	FORMAT_UINT32,
+
 	FORMAT_COUNT
 } AttributeFormat;
 
 typedef struct {
 	const char *name;
 	AttributeFormat format;
+	uint32_t divisor; // 0 advances per vertex, n advances once every n instances
 } VertexAttribute;
 
 typedef enum {
@@ -38,10 +56,64 @@ typedef enum {
 	PROJECTION_FRUSTUM
 } ProjectionType;
 
+typedef int32_t Uniform; // Resolved uniform handle, UNIFORM_INVALID if the shader has no such active uniform
+#define UNIFORM_INVALID -1
+
 typedef void Shader;
 typedef void Buffer;
+typedef void UniformBuffer;
 typedef void Texture;
+typedef void GpuTimer;
 typedef struct _camera Camera;
+typedef struct _render_queue RenderQueue;
+
+typedef struct {
+	float min[3], max[3];
+} BoundingBox;
+
+typedef struct {
+	float origin[3];
+	float direction[3]; // Unit length
+} Ray;
+
+typedef struct {
+	float position[3];
+	float normal[3]; // Of the surface the ray hit, zero when the ray starts inside it
+	float distance; // Along the ray
+} RayHit;
+
+// Vertex packing, values outside the range of a normalized format are clamped
+uint16_t vertex_pack_half(float value);
+int16_t vertex_pack_snorm16(float value);
+uint8_t vertex_pack_unorm8(float value);
+uint32_t vertex_pack_2_10_10_10(const float xyz[3], int32_t w);
+
+// Per-frame data every shader can read through the FRAME_UNIFORMS_BLOCK block, laid out to match std140
+#define FRAME_UNIFORMS_BLOCK  "FrameUniforms"
+#define FRAME_UNIFORM_BINDING 0
+
+typedef struct {
+	float view[16], projection[16], view_projection[16];
+	float camera_position[4]; // w unused
+	float time, delta_time;
+	float padding[2];
+} FrameUniforms;
+
+// Cumulative since the renderer was created. The OpenGL shader entries get no renderer, so shader binds, uniform
+// sets and shader objects are only counted by the null backend
+typedef struct {
+	uint64_t frames;
+	uint64_t draw_calls, triangles;
+	uint64_t bytes_uploaded; // Buffer, uniform buffer and texture data handed to the backend
+	uint64_t shader_binds, texture_binds, buffer_binds; // Buffer binds count vertex buffer switches between draws
+	uint64_t uniform_sets;
+	uint64_t object_allocations; // Buffers, uniform buffers, textures, timers and shaders handed out by the backend's pools
+	uint64_t heap_allocations; // malloc calls the pools made for them, flat once they've grown to the peak object count
+} RendererStats;
+
+typedef struct {
+	float planes[6][4]; // Left, right, bottom, top, near, far. xyz = normal pointing inside, w = distance
+} Frustum;
 
 /*
  * ===========================================================================================
@@ -54,20 +126,57 @@ typedef struct _renderer {
 
 	void (*frame_begin)(struct _renderer *self);
 	void (*frame_end)(struct _renderer *self);
+	void (*get_stats)(struct _renderer *self, RendererStats *stats);
 
 	void (*draw)(struct _renderer *self, Buffer *vertex_buffer, uint32_t vertex_count);
 	void (*draw_indexed)(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, uint32_t element_count);
+	// instance_buffer (may be NULL) is a vertex buffer whose attributes take the shader locations after the ones of
+	// vertex_buffer, give them a divisor to step them per instance
+	void (*draw_instanced)(struct _renderer *self, Buffer *vertex_buffer, Buffer *instance_buffer, uint32_t vertex_count, uint32_t instance_count);
+	void (*draw_indexed_instanced)(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, Buffer *instance_buffer, uint32_t element_count, uint32_t instance_count);
 
 	// Buffers
 	Buffer *(*buffer_create)(struct _renderer *self, BufferType type, size_t size, void *data);
+	// Dynamic buffers hold a separate size byte region per frame in flight, rotated by frame_begin. Write them every
+	// frame through buffer_map or buffer_update, vertex buffers need a size that's a multiple of the layout stride
+	Buffer *(*buffer_create_dynamic)(struct _renderer *self, BufferType type, size_t size);
+	void *(*buffer_map)(struct _renderer *self, Buffer *buffer);
+	// Rewriting a whole static buffer never waits on the GPU, a partial update of one may wait for the draws reading it
+	void (*buffer_update)(struct _renderer *self, Buffer *buffer, const void *data, size_t offset, size_t size);
 	void (*buffer_set_layout)(struct _renderer *self, Buffer *buffer, VertexAttribute *attributes, uint32_t attribute_count);
 	void (*buffer_destroy)(struct _renderer *self, Buffer *buffer);
 
 	void (*buffer_activate)(struct _renderer *self, const Buffer *buffer);
 	void (*buffer_deactivate)(struct _renderer *self, const Buffer *buffer);
 
+	// Uniform buffers stay bound to their binding point, every shader block using that binding sees updates
+	UniformBuffer *(*uniform_buffer_create)(struct _renderer *self, size_t size, uint32_t binding);
+	void (*uniform_buffer_update)(struct _renderer *self, UniformBuffer *buffer, const void *data, size_t offset, size_t size);
+	void (*uniform_buffer_destroy)(struct _renderer *self, UniformBuffer *buffer);
+
+	// GPU timers measure how long the GPU spends on the commands between begin and end, timers can't overlap.
+	// gpu_timer_result never waits, it returns false until the GPU finished the timed commands
+	GpuTimer *(*gpu_timer_create)(struct _renderer *self);
+	void (*gpu_timer_begin)(struct _renderer *self, GpuTimer *timer);
+	void (*gpu_timer_end)(struct _renderer *self, GpuTimer *timer);
+	bool (*gpu_timer_result)(struct _renderer *self, GpuTimer *timer, uint64_t *nanoseconds);
+	void (*gpu_timer_destroy)(struct _renderer *self, GpuTimer *timer);
+
 	// Textures
-	Texture *(*texture_load)(struct _renderer *self, const char *texture_path);
+	Texture *(*texture_load)(struct _renderer *self, const char *texture_path); // NULL if the image can't be loaded
+	// Returns a placeholder right away and decodes the image on jobs, texture_stream later uploads it into the same handle.
+	// The handle can be drawn with and destroyed while it's loading, an image that fails to load leaves a magenta texture
+	Texture *(*texture_load_async)(struct _renderer *self, JobSystem *jobs, const char *texture_path);
+	// Uploads decoded images until budget_seconds ran out (at least one per call), call once per frame on the render
+	// thread. Returns how many textures are still loading
+	uint32_t (*texture_stream)(struct _renderer *self, double budget_seconds);
+	// One texture of layer_count width x height layers, sampled as a sampler2DArray with the layer as third coordinate, so
+	// a whole tile set needs a single binding. Layer i is decoded from paths[i] the same way texture_load_async does and
+	// resized to width x height if it doesn't match
+	Texture *(*texture_array_load_async)(struct _renderer *self, JobSystem *jobs, const char **paths, uint32_t layer_count, uint32_t width, uint32_t height);
+	// Async loads started afterwards cook their image into a compressed mip chain cached in directory on first use, and map
+	// the cached file instead of decoding on later runs. Arrays need sizes that are multiples of 4. NULL turns the cache off
+	void (*texture_cache_set)(struct _renderer *self, const char *directory);
 	void (*texture_destroy)(struct _renderer *self, Texture *texture);
 
 	void (*texture_activate)(struct _renderer *self, Texture *texture, uint32_t texture_unit);
@@ -87,6 +196,15 @@ typedef struct _renderer {
 	void (*shader_set4fv)(Shader *shader, const char *name, float *value);
 	void (*shader_set4fm)(Shader *shader, const char *name, float *value);
 
+	// Resolve once with shader_uniform, then set through the handle to skip the name lookup on hot paths
+	Uniform (*shader_uniform)(Shader *shader, const char *name);
+	void (*shader_uniform_seti)(Shader *shader, Uniform uniform, int32_t value);
+	void (*shader_uniform_setf)(Shader *shader, Uniform uniform, float value);
+	void (*shader_uniform_set2fv)(Shader *shader, Uniform uniform, float *value);
+	void (*shader_uniform_set3fv)(Shader *shader, Uniform uniform, float *value);
+	void (*shader_uniform_set4fv)(Shader *shader, Uniform uniform, float *value);
+	void (*shader_uniform_set4fm)(Shader *shader, Uniform uniform, float *value);
+
 	RendererAPI backend;
 } Renderer;
 
@@ -110,3 +228,57 @@ void camera_update(Camera *camera, float camera_position[3], float camera_front[
 
 float *camera_get_view(Camera *camera);
 float *camera_get_projection(Camera *camera);
+float *camera_get_view_projection(Camera *camera);
+
+// Planes of the view volume as of the last camera_update
+void camera_get_frustum(Camera *camera, Frustum *frustum);
+// From the camera position along the front vector, as of the last camera_update
+void camera_get_ray(Camera *camera, Ray *ray);
+
+bool frustum_test_sphere(const Frustum *frustum, const float center[3], float radius);
+bool frustum_test_aabb(const Frustum *frustum, const BoundingBox *box);
+// Tests boxes four at a time, writes 1 to visible[i] for every box that intersects the frustum and returns how many did
+uint32_t frustum_test_aabbs(const Frustum *frustum, const BoundingBox *boxes, uint32_t count, uint8_t *visible);
+
+/**
+ * ===========================================================================================
+ * -------- Render queue
+ * ===========================================================================================
+ **/
+
+#define RENDER_QUEUE_TEXTURE_UNITS 2
+
+typedef enum {
+	RENDER_PASS_OPAQUE, // Front to back
+	RENDER_PASS_TRANSPARENT, // Back to front
+
+	RENDER_PASS_COUNT
+} RenderPass;
+
+typedef struct {
+	RenderPass pass;
+	float depth; // Distance to the camera
+
+	Shader *shader;
+	Texture *textures[RENDER_QUEUE_TEXTURE_UNITS]; // Bound to units 0..n, NULL leaves the unit as is
+	Uniform model_uniform;
+	const float *model; // Optional, set to model_uniform before the draw and has to stay valid until submit
+
+	Buffer *vertex_buffer, *index_buffer, *instance_buffer; // Index and instance buffers may be NULL
+	uint32_t count; // Vertex count, or element count when indexed
+	uint32_t instance_count; // 0 for a non-instanced draw
+} RenderPacket;
+
+typedef struct {
+	uint32_t packets;
+	uint32_t shader_binds, texture_binds, buffer_binds;
+	uint32_t shader_binds_skipped, texture_binds_skipped, buffer_binds_skipped; // Buffer binds are counted by the backend
+} RenderQueueStats;
+
+// depth_range is the largest depth packets are expected to use (the far plane), deeper ones share the last sort bucket
+RenderQueue *render_queue_create(Renderer *renderer, float depth_range);
+void render_queue_destroy(RenderQueue *queue);
+
+void render_queue_push(RenderQueue *queue, const RenderPacket *packet);
+// Sorts the packets by pass, shader, texture and depth, issues them without redundant binds and empties the queue
+void render_queue_submit(RenderQueue *queue, RenderQueueStats *stats);
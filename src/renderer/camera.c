@@ -1,30 +1,50 @@
 #include "base.h"
+#include "base/pool.h"
 #include "renderer.h"
 
 #include <cglm/cam.h>
 #include <cglm/cglm.h>
 #include <cglm/mat4.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 struct _camera {
 	float frustum, near, far; // Frustum = fov in perspective, Frustum = box_size in orthographic
 	uint32_t projection_type, projection_dirty; // Camera projection: CAMERA_PERSPECTIVE or CAMERA_ORTHOGRAPHIC
-	mat4 view_matrix, projection_matrix;
+	mat4 view_matrix, projection_matrix, view_projection_matrix;
+	vec3 position, front; // Front is normalized
 };
 
+// Cameras are created without a renderer, so they share one pool. It's freed with the last camera
+static Pool *g_camera_pool = NULL;
+
 Camera *camera_create() {
-	Camera *camera = malloc(sizeof(Camera));
+	if (g_camera_pool == NULL)
+		g_camera_pool = pool_create(sizeof(Camera), 4);
+
+	Camera *camera = pool_alloc(g_camera_pool, NULL);
 
 	*camera = (Camera){ .frustum = 0.f, .near = 0.f, .far = 0.f, .projection_type = PROJECTION_FRUSTUM, .projection_dirty = false };
 	glm_mat4_identity(camera->view_matrix);
 	glm_mat4_identity(camera->projection_matrix);
+	glm_mat4_identity(camera->view_projection_matrix);
+	glm_vec3_copy((vec3){ 0.f, 0.f, -1.f }, camera->front);
 
 	return camera;
 }
 void camera_destroy(Camera *camera) {
-	if (camera)
-		free(camera);
+	if (camera == NULL)
+		return;
+
+	pool_free(g_camera_pool, camera);
+
+	PoolStats stats;
+	pool_get_stats(g_camera_pool, &stats);
+	if (stats.live == 0) {
+		pool_destroy(g_camera_pool);
+		g_camera_pool = NULL;
+	}
 }
 
 void camera_set_perspective(Camera *camera, float fov, float near, float far) {
@@ -54,7 +74,10 @@ void camera_update(Camera *camera, float camera_position[3], float camera_front[
 				LOG_WARN("Camera projection not initialized!");
 			} break;
 		}
+	glm_vec3_copy(camera_position, camera->position);
+	glm_vec3_normalize_to(camera_front, camera->front);
 	glm_look(camera_position, camera_front, camera_up, camera->view_matrix);
+	glm_mat4_mul(camera->projection_matrix, camera->view_matrix, camera->view_projection_matrix);
 }
 
 float *camera_get_view(Camera *camera) {
@@ -63,3 +86,95 @@ float *camera_get_view(Camera *camera) {
 float *camera_get_projection(Camera *camera) {
 	return (float *)camera->projection_matrix;
 }
+float *camera_get_view_projection(Camera *camera) {
+	return (float *)camera->view_projection_matrix;
+}
+
+void camera_get_frustum(Camera *camera, Frustum *frustum) {
+	// Gribb/Hartmann: every plane is the w row of the clip matrix plus or minus one of the other rows (column major)
+	mat4 *clip = &camera->view_projection_matrix;
+	for (uint32_t i = 0; i < 6; i++) {
+		uint32_t row = i / 2;
+		float sign = (i % 2 == 0) ? 1.f : -1.f;
+
+		float *plane = frustum->planes[i];
+		for (uint32_t column = 0; column < 4; column++)
+			plane[column] = (*clip)[column][3] + sign * (*clip)[column][row];
+
+		float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		for (uint32_t component = 0; component < 4; component++)
+			plane[component] /= length;
+	}
+}
+
+void camera_get_ray(Camera *camera, Ray *ray) {
+	glm_vec3_copy(camera->position, ray->origin);
+	glm_vec3_copy(camera->front, ray->direction);
+}
+
+bool frustum_test_sphere(const Frustum *frustum, const float center[3], float radius) {
+	for (uint32_t i = 0; i < 6; i++) {
+		const float *plane = frustum->planes[i];
+		if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+bool frustum_test_aabb(const Frustum *frustum, const BoundingBox *box) {
+	// Only the corner furthest along the plane normal has to be checked
+	for (uint32_t i = 0; i < 6; i++) {
+		const float *plane = frustum->planes[i];
+		float x = plane[0] > 0 ? box->max[0] : box->min[0];
+		float y = plane[1] > 0 ? box->max[1] : box->min[1];
+		float z = plane[2] > 0 ? box->max[2] : box->min[2];
+
+		if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0)
+			return false;
+	}
+
+	return true;
+}
+
+uint32_t frustum_test_aabbs(const Frustum *frustum, const BoundingBox *boxes, uint32_t count, uint8_t *visible) {
+	uint32_t i = 0, visible_count = 0;
+
+#if defined(__GNUC__)
+	typedef float f32x4 __attribute__((vector_size(16)));
+	typedef int32_t i32x4 __attribute__((vector_size(16)));
+
+	// Same test as frustum_test_aabb with one box per lane, the corner selection only depends on the plane
+	for (; i + 4 <= count; i += 4) {
+		f32x4 min[3], max[3];
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				min[axis][lane] = boxes[i + lane].min[axis];
+				max[axis][lane] = boxes[i + lane].max[axis];
+			}
+		}
+
+		i32x4 outside = { 0 };
+		for (uint32_t p = 0; p < 6; p++) {
+			const float *plane = frustum->planes[p];
+			f32x4 x = plane[0] > 0 ? max[0] : min[0];
+			f32x4 y = plane[1] > 0 ? max[1] : min[1];
+			f32x4 z = plane[2] > 0 ? max[2] : min[2];
+
+			outside |= (x * plane[0] + y * plane[1] + z * plane[2] + plane[3]) < 0;
+		}
+
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			visible[i + lane] = outside[lane] == 0;
+			visible_count += visible[i + lane];
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		visible[i] = frustum_test_aabb(frustum, &boxes[i]);
+		visible_count += visible[i];
+	}
+
+	return visible_count;
+}
@@ -3,13 +3,35 @@
 
 #include <stdint.h>
 
+typedef struct _gl_offscreen OpenGLOffscreen;
+
 Renderer *opengl_renderer_create();
 void opengl_renderer_destroy(Renderer *renderer);
 
+/*
+ * ===========================================================================================
+ * -------- Offscreen
+ * ===========================================================================================
+ **/
+
+// Creates a windowless EGL context (surfaceless, or a pbuffer where that's unsupported), loads GL through it and binds
+// a width x height framebuffer to draw into. Works on Mesa llvmpipe, so no GPU or display is needed
+OpenGLOffscreen *opengl_offscreen_create(uint32_t width, uint32_t height);
+void opengl_offscreen_destroy(OpenGLOffscreen *offscreen);
+
+// Blocks until rendering finished and copies the framebuffer into rgba (width * height * 4 bytes, bottom row first)
+void opengl_offscreen_read_pixels(OpenGLOffscreen *offscreen, uint8_t *rgba);
+
 void opengl_on_resize(struct _renderer *self, int width, int height);
 
+void opengl_frame_begin(struct _renderer *self);
+void opengl_frame_end(struct _renderer *self);
+void opengl_get_stats(struct _renderer *self, RendererStats *stats);
+
 void opengl_draw(struct _renderer *self, Buffer *vertex_buffer, uint32_t vertex_count);
 void opengl_draw_indexed(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, uint32_t element_count);
+void opengl_draw_instanced(struct _renderer *self, Buffer *vertex_buffer, Buffer *instance_buffer, uint32_t vertex_count, uint32_t instance_count);
+void opengl_draw_indexed_instanced(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, Buffer *instance_buffer, uint32_t element_count, uint32_t instance_count);
 /*
  * ===========================================================================================
  * -------- Buffer
@@ -17,12 +39,31 @@ void opengl_draw_indexed(struct _renderer *self, Buffer *vertex_buffer, Buffer *
  **/
 
 Buffer *opengl_buffer_create(struct _renderer *self, BufferType type, size_t size, void *data);
+Buffer *opengl_buffer_create_dynamic(struct _renderer *self, BufferType type, size_t size);
+void *opengl_buffer_map(struct _renderer *self, Buffer *buffer);
+void opengl_buffer_update(struct _renderer *self, Buffer *buffer, const void *data, size_t offset, size_t size);
 void opengl_buffer_set_layout(struct _renderer *self, Buffer *buffer, VertexAttribute *attributes, uint32_t attribute_count);
 void opengl_buffer_destroy(struct _renderer *self, Buffer *buffer);
 
 void opengl_buffer_activate(struct _renderer *self, const Buffer *buffer);
 void opengl_buffer_deactivate(struct _renderer *self, const Buffer *buffer);
 
+UniformBuffer *opengl_uniform_buffer_create(struct _renderer *self, size_t size, uint32_t binding);
+void opengl_uniform_buffer_update(struct _renderer *self, UniformBuffer *buffer, const void *data, size_t offset, size_t size);
+void opengl_uniform_buffer_destroy(struct _renderer *self, UniformBuffer *buffer);
+
+/*
+ * ===========================================================================================
+ * -------- GPU timer
+ * ===========================================================================================
+ **/
+
+GpuTimer *opengl_gpu_timer_create(struct _renderer *self);
+void opengl_gpu_timer_begin(struct _renderer *self, GpuTimer *timer);
+void opengl_gpu_timer_end(struct _renderer *self, GpuTimer *timer);
+bool opengl_gpu_timer_result(struct _renderer *self, GpuTimer *timer, uint64_t *nanoseconds);
+void opengl_gpu_timer_destroy(struct _renderer *self, GpuTimer *timer);
+
 /*
  * ===========================================================================================
  * -------- Texture
@@ -30,6 +71,10 @@ void opengl_buffer_deactivate(struct _renderer *self, const Buffer *buffer);
  **/
 
 Texture *opengl_texture_load(struct _renderer *self, const char *texture_path);
+Texture *opengl_texture_load_async(struct _renderer *self, JobSystem *jobs, const char *texture_path);
+uint32_t opengl_texture_stream(struct _renderer *self, double budget_seconds);
+void opengl_texture_cache_set(struct _renderer *self, const char *directory);
+Texture *opengl_texture_array_load_async(struct _renderer *self, JobSystem *jobs, const char **paths, uint32_t layer_count, uint32_t width, uint32_t height);
 void opengl_texture_destroy(struct _renderer *self, Texture *texture);
 
 void opengl_texture_activate(struct _renderer *self, Texture *texture, uint32_t texture_unit);
@@ -53,3 +98,11 @@ void opengl_shader_set2fv(Shader *shader, const char *name, float *value);
 void opengl_shader_set3fv(Shader *shader, const char *name, float *value);
 void opengl_shader_set4fv(Shader *shader, const char *name, float *value);
 void opengl_shader_set4fm(Shader *shader, const char *name, float *value);
+
+Uniform opengl_shader_uniform(Shader *shader, const char *name);
+void opengl_shader_uniform_seti(Shader *shader, Uniform uniform, int32_t value);
+void opengl_shader_uniform_setf(Shader *shader, Uniform uniform, float value);
+void opengl_shader_uniform_set2fv(Shader *shader, Uniform uniform, float *value);
+void opengl_shader_uniform_set3fv(Shader *shader, Uniform uniform, float *value);
+void opengl_shader_uniform_set4fv(Shader *shader, Uniform uniform, float *value);
+void opengl_shader_uniform_set4fm(Shader *shader, Uniform uniform, float *value);
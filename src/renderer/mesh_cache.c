@@ -0,0 +1,143 @@
+#include "renderer/mesh_cache.h"
+#include "base.h"
+#include "base/file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_CACHE_MAGIC	 0x4853454D // "MESH"
+#define MESH_CACHE_VERSION	 1
+#define MESH_CACHE_ALIGNMENT 16 // Blobs start on this boundary so the mapping can be read as floats directly
+
+typedef struct {
+	char name[MESH_CACHE_ATTRIBUTE_NAME_LENGTH];
+	uint32_t format, divisor;
+} MeshFileAttribute;
+
+typedef struct {
+	uint32_t magic, version;
+	uint64_t key;
+	uint32_t attribute_count;
+	MeshFileAttribute attributes[MESH_CACHE_MAX_ATTRIBUTES];
+	BoundingBox bounds;
+	uint64_t vertices_offset, vertices_size;
+	uint64_t indices_offset, indices_size;
+} MeshFileHeader;
+
+static uint64_t align_offset(uint64_t offset);
+
+uint64_t mesh_cache_hash(uint64_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+	return hash;
+}
+
+uint64_t mesh_cache_hash_layout(uint64_t hash, const VertexAttribute *attributes, uint32_t attribute_count) {
+	for (uint32_t i = 0; i < attribute_count; i++) {
+		uint32_t format = attributes[i].format, divisor = attributes[i].divisor;
+		hash = mesh_cache_hash(hash, attributes[i].name, strlen(attributes[i].name));
+		hash = mesh_cache_hash(hash, &format, sizeof(format));
+		hash = mesh_cache_hash(hash, &divisor, sizeof(divisor));
+	}
+
+	return hash;
+}
+
+void mesh_cache_path(const char *directory, uint64_t key, char *path, size_t path_size) {
+	snprintf(path, path_size, "%s/%016llx.mesh", directory, (unsigned long long)key);
+}
+
+bool mesh_cache_write(const char *path, uint64_t key, const CachedMesh *mesh) {
+	if (mesh->attribute_count > MESH_CACHE_MAX_ATTRIBUTES) {
+		LOG_ERROR("Can't cache a mesh with %u attributes", mesh->attribute_count);
+		return false;
+	}
+
+	MeshFileHeader header = {
+		.magic = MESH_CACHE_MAGIC,
+		.version = MESH_CACHE_VERSION,
+		.key = key,
+		.attribute_count = mesh->attribute_count,
+		.bounds = mesh->bounds,
+	};
+	for (uint32_t i = 0; i < mesh->attribute_count; i++) {
+		snprintf(header.attributes[i].name, MESH_CACHE_ATTRIBUTE_NAME_LENGTH, "%s", mesh->attributes[i].name);
+		header.attributes[i].format = mesh->attributes[i].format;
+		header.attributes[i].divisor = mesh->attributes[i].divisor;
+	}
+
+	header.vertices_offset = align_offset(sizeof(MeshFileHeader));
+	header.vertices_size = mesh->vertices_size;
+	header.indices_offset = align_offset(header.vertices_offset + header.vertices_size);
+	header.indices_size = mesh->indices ? mesh->indices_size : 0;
+
+	size_t size = header.indices_offset + header.indices_size;
+	uint8_t *data = calloc(1, size);
+	memcpy(data, &header, sizeof(header));
+	memcpy(data + header.vertices_offset, mesh->vertices, header.vertices_size);
+	if (header.indices_size)
+		memcpy(data + header.indices_offset, mesh->indices, header.indices_size);
+
+	bool written = file_write_atomic(path, data, size);
+	free(data);
+	if (!written)
+		LOG_ERROR("Failed to write cached mesh [ %s ]", path);
+
+	return written;
+}
+
+bool mesh_cache_map(const char *path, uint64_t key, CachedMesh *mesh) {
+	*mesh = (CachedMesh){ 0 };
+
+	size_t size;
+	const uint8_t *mapping = file_map(path, &size);
+	if (mapping == NULL)
+		return false;
+
+	const MeshFileHeader *header = (const MeshFileHeader *)mapping;
+	bool valid = size >= sizeof(MeshFileHeader) && header->magic == MESH_CACHE_MAGIC && header->version == MESH_CACHE_VERSION &&
+				 header->key == key && header->attribute_count <= MESH_CACHE_MAX_ATTRIBUTES &&
+				 header->vertices_offset <= size && header->vertices_size <= size - header->vertices_offset &&
+				 header->indices_offset <= size && header->indices_size <= size - header->indices_offset;
+	for (uint32_t i = 0; valid && i < header->attribute_count; i++)
+		valid = header->attributes[i].format < FORMAT_COUNT && memchr(header->attributes[i].name, '\0', MESH_CACHE_ATTRIBUTE_NAME_LENGTH);
+
+	if (!valid) {
+		LOG_WARN("Cached mesh [ %s ] is invalid or outdated", path);
+		file_unmap(mapping, size);
+		return false;
+	}
+
+	mesh->attribute_count = header->attribute_count;
+	for (uint32_t i = 0; i < header->attribute_count; i++) {
+		mesh->attributes[i] = (VertexAttribute){
+			.name = header->attributes[i].name,
+			.format = header->attributes[i].format,
+			.divisor = header->attributes[i].divisor,
+		};
+	}
+	mesh->bounds = header->bounds;
+
+	mesh->vertices = mapping + header->vertices_offset;
+	mesh->vertices_size = header->vertices_size;
+	if (header->indices_size) {
+		mesh->indices = mapping + header->indices_offset;
+		mesh->indices_size = header->indices_size;
+	}
+	mesh->mapping = mapping;
+	mesh->mapping_size = size;
+
+	return true;
+}
+
+void mesh_cache_unmap(CachedMesh *mesh) {
+	file_unmap(mesh->mapping, mesh->mapping_size);
+	*mesh = (CachedMesh){ 0 };
+}
+
+uint64_t align_offset(uint64_t offset) {
+	return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(uint64_t)(MESH_CACHE_ALIGNMENT - 1);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "renderer.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cached meshes: the vertex layout, bounds and the raw vertex and index blobs of a generated mesh in one versioned file,
+ * named after a hash of whatever the mesh was generated from. Loading one is a mmap, the blobs go to buffer_create as they
+ * are, with nothing parsed or copied on the way.
+ */
+
+#define MESH_CACHE_HASH_SEED			 14695981039346656037ull
+#define MESH_CACHE_MAX_ATTRIBUTES		 8
+#define MESH_CACHE_ATTRIBUTE_NAME_LENGTH 32
+
+typedef struct {
+	VertexAttribute attributes[MESH_CACHE_MAX_ATTRIBUTES]; // Names point into the mapping once mapped
+	uint32_t attribute_count;
+	BoundingBox bounds;
+
+	const void *vertices;
+	size_t vertices_size;
+	const void *indices; // NULL for meshes drawn without an index buffer
+	size_t indices_size;
+
+	const void *mapping;
+	size_t mapping_size;
+} CachedMesh;
+
+// FNV-1a over size bytes of data, continuing from hash (MESH_CACHE_HASH_SEED to start). Chain it over every generator
+// parameter to get the key of a mesh
+uint64_t mesh_cache_hash(uint64_t hash, const void *data, size_t size);
+// Hashes the layout, so changing a vertex format also changes the key
+uint64_t mesh_cache_hash_layout(uint64_t hash, const VertexAttribute *attributes, uint32_t attribute_count);
+// Writes the cache file name for key to path
+void mesh_cache_path(const char *directory, uint64_t key, char *path, size_t path_size);
+
+bool mesh_cache_write(const char *path, uint64_t key, const CachedMesh *mesh);
+// Fails if the file is missing, was written by another version or for another key
+bool mesh_cache_map(const char *path, uint64_t key, CachedMesh *mesh);
+void mesh_cache_unmap(CachedMesh *mesh);
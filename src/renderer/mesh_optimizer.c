@@ -0,0 +1,192 @@
+#include "renderer/mesh_optimizer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_DECAY_POWER	1.5f
+#define LAST_TRIANGLE_SCORE	0.75f
+#define VALENCE_BOOST_SCALE	2.f
+#define VALENCE_BOOST_POWER	0.5f
+
+typedef struct {
+	int32_t cache_position; // -1 if not in the cache
+	uint32_t live_triangles; // Triangles not emitted yet
+	uint32_t first_triangle; // Into the adjacency list
+	float score;
+} ForsythVertex;
+
+static float forsyth_vertex_score(const ForsythVertex *vertex);
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation". Triangles are emitted greedily by the sum of their vertex scores,
+// the vertices score high while they're in the modelled cache and when few triangles are left to use them
+void mesh_optimize_vertex_cache(uint32_t *indices, uint32_t index_count, uint32_t vertex_count) {
+	uint32_t triangle_count = index_count / 3;
+	if (triangle_count == 0 || vertex_count == 0)
+		return;
+
+	ForsythVertex *vertices = calloc(vertex_count, sizeof(ForsythVertex));
+	uint32_t *adjacency = malloc(sizeof(uint32_t) * index_count);
+	uint32_t *adjacency_fill = calloc(vertex_count, sizeof(uint32_t));
+	bool *emitted = calloc(triangle_count, sizeof(bool));
+	uint32_t *output = malloc(sizeof(uint32_t) * index_count);
+
+	for (uint32_t i = 0; i < index_count; i++)
+		vertices[indices[i]].live_triangles++;
+
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < vertex_count; i++) {
+		vertices[i].first_triangle = offset;
+		vertices[i].cache_position = -1;
+		offset += vertices[i].live_triangles;
+	}
+	for (uint32_t i = 0; i < index_count; i++) {
+		ForsythVertex *vertex = &vertices[indices[i]];
+		adjacency[vertex->first_triangle + adjacency_fill[indices[i]]++] = i / 3;
+	}
+
+	for (uint32_t i = 0; i < vertex_count; i++)
+		vertices[i].score = forsyth_vertex_score(&vertices[i]);
+
+	// One spare slot per vertex of the emitted triangle, they're pushed in front before the tail is dropped
+	uint32_t cache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+	uint32_t cache_count = 0, output_count = 0, scan_cursor = 0;
+	int64_t best_triangle = -1;
+
+	while (output_count < index_count) {
+		// Nothing in the cache touches a live triangle, restart from the first remaining one in input order. The cursor only
+		// moves forward, so restarts cost nothing extra, where a best-score search would walk every remaining triangle
+		if (best_triangle < 0) {
+			while (emitted[scan_cursor])
+				scan_cursor++;
+			best_triangle = scan_cursor;
+		}
+
+		uint32_t triangle = (uint32_t)best_triangle;
+		emitted[triangle] = true;
+
+		uint32_t new_cache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+		uint32_t new_count = 0;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t index = indices[triangle * 3 + corner];
+			output[output_count++] = index;
+			new_cache[new_count++] = index;
+
+			// Drop the triangle from the vertex's live list
+			ForsythVertex *vertex = &vertices[index];
+			uint32_t *triangles = adjacency + vertex->first_triangle;
+			for (uint32_t i = 0; i < vertex->live_triangles; i++) {
+				if (triangles[i] == triangle) {
+					triangles[i] = triangles[--vertex->live_triangles];
+					break;
+				}
+			}
+		}
+		for (uint32_t i = 0; i < cache_count; i++) {
+			uint32_t index = cache[i];
+			if (index != new_cache[0] && index != new_cache[1] && index != new_cache[2])
+				new_cache[new_count++] = index;
+		}
+
+		// Rescore everything that was or is in the cache, and the triangles around it
+		for (uint32_t i = 0; i < new_count; i++) {
+			ForsythVertex *vertex = &vertices[new_cache[i]];
+			vertex->cache_position = i < MESH_OPTIMIZER_CACHE_SIZE ? (int32_t)i : -1;
+			vertex->score = forsyth_vertex_score(vertex);
+		}
+
+		best_triangle = -1;
+		float best_score = -1.f;
+		for (uint32_t i = 0; i < new_count; i++) {
+			const ForsythVertex *vertex = &vertices[new_cache[i]];
+			const uint32_t *triangles = adjacency + vertex->first_triangle;
+			for (uint32_t j = 0; j < vertex->live_triangles; j++) {
+				uint32_t live = triangles[j];
+				float score = vertices[indices[live * 3]].score + vertices[indices[live * 3 + 1]].score + vertices[indices[live * 3 + 2]].score;
+				if (score > best_score) {
+					best_score = score;
+					best_triangle = live;
+				}
+			}
+		}
+
+		cache_count = new_count < MESH_OPTIMIZER_CACHE_SIZE ? new_count : MESH_OPTIMIZER_CACHE_SIZE;
+		memcpy(cache, new_cache, sizeof(uint32_t) * cache_count);
+	}
+
+	memcpy(indices, output, sizeof(uint32_t) * index_count);
+
+	free(vertices);
+	free(adjacency);
+	free(adjacency_fill);
+	free(emitted);
+	free(output);
+}
+
+uint32_t mesh_vertex_fetch_remap(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count, uint32_t *remap) {
+	memset(remap, 0xFF, sizeof(uint32_t) * vertex_count);
+
+	uint32_t next = 0;
+	for (uint32_t i = 0; i < index_count; i++) {
+		if (remap[indices[i]] == UINT32_MAX)
+			remap[indices[i]] = next++;
+	}
+
+	uint32_t referenced = next;
+	for (uint32_t i = 0; i < vertex_count; i++) {
+		if (remap[i] == UINT32_MAX)
+			remap[i] = next++;
+	}
+
+	return referenced;
+}
+
+void mesh_remap_indices(uint32_t *indices, uint32_t index_count, const uint32_t *remap) {
+	for (uint32_t i = 0; i < index_count; i++)
+		indices[i] = remap[indices[i]];
+}
+
+float mesh_acmr(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count) {
+	if (index_count < 3)
+		return 0.f;
+
+	// Timestamps instead of a real FIFO: a vertex is cached if it was pushed within the last MESH_ACMR_CACHE_SIZE misses
+	uint32_t *pushed_at = calloc(vertex_count, sizeof(uint32_t));
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < index_count; i++) {
+		uint32_t index = indices[i];
+		if (pushed_at[index] == 0 || misses - pushed_at[index] >= MESH_ACMR_CACHE_SIZE) {
+			misses++;
+			pushed_at[index] = misses;
+		}
+	}
+	free(pushed_at);
+
+	return (float)misses / (index_count / 3);
+}
+
+bool mesh_indices_fit_16(uint32_t vertex_count) {
+	return vertex_count <= UINT16_MAX + 1u;
+}
+
+void mesh_indices_to_16(const uint32_t *indices, uint32_t index_count, uint16_t *out) {
+	// Front to back, so a 16-bit write never lands on a 32-bit index that wasn't read yet
+	for (uint32_t i = 0; i < index_count; i++)
+		out[i] = (uint16_t)indices[i];
+}
+
+float forsyth_vertex_score(const ForsythVertex *vertex) {
+	if (vertex->live_triangles == 0)
+		return -1.f;
+
+	float score = 0.f;
+	if (vertex->cache_position >= 0) {
+		// The last triangle's vertices get a fixed score so the next triangle doesn't just reuse its edge
+		if (vertex->cache_position < 3)
+			score = LAST_TRIANGLE_SCORE;
+		else
+			score = powf(1.f - (float)(vertex->cache_position - 3) / (MESH_OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+	}
+
+	return score + VALENCE_BOOST_SCALE * powf((float)vertex->live_triangles, -VALENCE_BOOST_POWER);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Index and vertex reordering for indexed triangle lists. The vertex cache pass reorders triangles so vertices get reused
+ * while they're still in the post-transform cache (Forsyth's linear-speed algorithm), the vertex fetch pass then reorders
+ * vertices into the order the triangles first use them, so fetches walk the vertex buffer front to back.
+ */
+
+#define MESH_OPTIMIZER_CACHE_SIZE 32 // Modelled LRU cache entries for the vertex cache pass
+#define MESH_ACMR_CACHE_SIZE	  16 // FIFO entries of the cache mesh_acmr simulates
+
+// Reorders the triangles of indices in place
+void mesh_optimize_vertex_cache(uint32_t *indices, uint32_t index_count, uint32_t vertex_count);
+// Writes remap[old vertex] = new vertex, in the order indices first reference them, and returns how many vertices are
+// referenced. Unreferenced vertices go to the end
+uint32_t mesh_vertex_fetch_remap(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count, uint32_t *remap);
+void mesh_remap_indices(uint32_t *indices, uint32_t index_count, const uint32_t *remap);
+
+// Average cache miss ratio, vertex shader invocations per triangle with a MESH_ACMR_CACHE_SIZE entry FIFO.
+// 0.5 is the floor for a regular grid, 3 means no reuse at all
+float mesh_acmr(const uint32_t *indices, uint32_t index_count, uint32_t vertex_count);
+
+// True if every index fits in 16 bits, so the mesh can use a BUFFER_TYPE_INDEX16 buffer
+bool mesh_indices_fit_16(uint32_t vertex_count);
+// Narrows indices to 16 bits, out may alias indices
+void mesh_indices_to_16(const uint32_t *indices, uint32_t index_count, uint16_t *out);
@@ -0,0 +1,548 @@
+#include "renderer/null_renderer.h"
+#include "base.h"
+#include "base/pool.h"
+
+#include <stb/stb_image.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	Renderer base;
+	RendererStats stats;
+	FILE *stream; // Command recording, NULL when off
+	uint32_t next_id; // Handles are numbered in creation order so recordings are reproducible
+	const void *bound_vertex_buffer;
+
+	Pool *buffer_pool, *uniform_buffer_pool, *timer_pool, *texture_pool, *shader_pool;
+} NullRenderer;
+
+typedef struct {
+	uint32_t id;
+	BufferType type;
+	size_t size;
+	uint32_t stride;
+	uint8_t *mapped; // Backing memory of dynamic buffers
+} NullBuffer;
+
+typedef struct {
+	uint32_t id;
+	size_t size;
+} NullUniformBuffer;
+
+typedef struct {
+	uint32_t id;
+	int32_t width, height, channels;
+} NullTexture;
+
+typedef struct {
+	uint32_t id;
+} NullShader;
+
+typedef struct {
+	uint32_t id;
+} NullGpuTimer;
+
+// Shader entries don't receive the renderer, they report to the live null renderer
+static NullRenderer *g_null_renderer = NULL;
+
+static void null_record(NullRenderer *renderer, const char *format, ...);
+static uint32_t attribute_format_to_bytes(AttributeFormat format);
+
+static void null_on_resize(struct _renderer *self, int width, int height) {
+	null_record((NullRenderer *)self, "resize %d %d", width, height);
+}
+
+static void null_frame_begin(struct _renderer *self) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	null_record(renderer, "frame_begin %llu", (unsigned long long)renderer->stats.frames);
+}
+
+static void null_frame_end(struct _renderer *self) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	null_record(renderer, "frame_end %llu", (unsigned long long)renderer->stats.frames);
+	renderer->stats.frames++;
+}
+
+static void null_get_stats(struct _renderer *self, RendererStats *stats) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	*stats = renderer->stats;
+
+	Pool *pools[] = { renderer->buffer_pool, renderer->uniform_buffer_pool, renderer->timer_pool, renderer->texture_pool, renderer->shader_pool };
+	for (uint32_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+		PoolStats pool_stats;
+		pool_get_stats(pools[i], &pool_stats);
+		stats->object_allocations += pool_stats.allocations;
+		stats->heap_allocations += pool_stats.heap_allocations;
+	}
+}
+
+static void null_count_draw(NullRenderer *renderer, const Buffer *vertex_buffer, uint32_t vertex_count, uint32_t instance_count) {
+	renderer->stats.draw_calls++;
+	renderer->stats.triangles += (uint64_t)(vertex_count / 3) * instance_count;
+
+	if (renderer->bound_vertex_buffer != vertex_buffer) {
+		renderer->bound_vertex_buffer = vertex_buffer;
+		renderer->stats.buffer_binds++;
+	}
+}
+
+static void null_draw(struct _renderer *self, Buffer *vertex_buffer, uint32_t vertex_count) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	null_count_draw(renderer, vertex_buffer, vertex_count, 1);
+	null_record(renderer, "draw %u %u", ((NullBuffer *)vertex_buffer)->id, vertex_count);
+}
+
+static void null_draw_indexed(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, uint32_t element_count) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	null_count_draw(renderer, vertex_buffer, element_count, 1);
+	null_record(renderer, "draw_indexed %u %u %u", ((NullBuffer *)vertex_buffer)->id, ((NullBuffer *)index_buffer)->id, element_count);
+}
+
+static void null_draw_instanced(struct _renderer *self, Buffer *vertex_buffer, Buffer *instance_buffer, uint32_t vertex_count, uint32_t instance_count) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	null_count_draw(renderer, vertex_buffer, vertex_count, instance_count);
+	null_record(renderer, "draw_instanced %u %u %u %u", ((NullBuffer *)vertex_buffer)->id,
+				instance_buffer ? ((NullBuffer *)instance_buffer)->id : 0, vertex_count, instance_count);
+}
+
+static void null_draw_indexed_instanced(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, Buffer *instance_buffer, uint32_t element_count, uint32_t instance_count) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	null_count_draw(renderer, vertex_buffer, element_count, instance_count);
+	null_record(renderer, "draw_indexed_instanced %u %u %u %u %u", ((NullBuffer *)vertex_buffer)->id, ((NullBuffer *)index_buffer)->id,
+				instance_buffer ? ((NullBuffer *)instance_buffer)->id : 0, element_count, instance_count);
+}
+
+/*
+ * ===========================================================================================
+ * -------- Buffer
+ * ===========================================================================================
+ **/
+
+static Buffer *null_buffer_create(struct _renderer *self, BufferType type, size_t size, void *data) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullBuffer *buffer = pool_alloc(renderer->buffer_pool, NULL);
+
+	*buffer = (NullBuffer){ .id = ++renderer->next_id, .type = type, .size = size };
+	if (data)
+		renderer->stats.bytes_uploaded += size;
+
+	null_record(renderer, "buffer_create %u %d %zu", buffer->id, type, size);
+	return buffer;
+}
+
+static Buffer *null_buffer_create_dynamic(struct _renderer *self, BufferType type, size_t size) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullBuffer *buffer = pool_alloc(renderer->buffer_pool, NULL);
+
+	*buffer = (NullBuffer){ .id = ++renderer->next_id, .type = type, .size = size, .mapped = calloc(1, size) };
+
+	null_record(renderer, "buffer_create_dynamic %u %d %zu", buffer->id, type, size);
+	return buffer;
+}
+
+static void *null_buffer_map(struct _renderer *self, Buffer *buffer) {
+	NullBuffer *null_buffer = (NullBuffer *)buffer;
+	if (buffer == NULL || null_buffer->mapped == NULL) {
+		LOG_ERROR("Only dynamic buffers can be mapped!");
+		return NULL;
+	}
+
+	// The caller is going to fill the region, count it as uploaded
+	((NullRenderer *)self)->stats.bytes_uploaded += null_buffer->size;
+	return null_buffer->mapped;
+}
+
+static void null_buffer_update(struct _renderer *self, Buffer *buffer, const void *data, size_t offset, size_t size) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullBuffer *null_buffer = (NullBuffer *)buffer;
+	if (buffer == NULL || offset + size > null_buffer->size) {
+		LOG_ERROR("Invalid buffer update!");
+		return;
+	}
+
+	if (null_buffer->mapped)
+		memcpy(null_buffer->mapped + offset, data, size);
+
+	renderer->stats.bytes_uploaded += size;
+	null_record(renderer, "buffer_update %u %zu %zu", null_buffer->id, offset, size);
+}
+
+static void null_buffer_set_layout(struct _renderer *self, Buffer *buffer, VertexAttribute *attributes, uint32_t attribute_count) {
+	if (attributes == NULL || buffer == NULL) {
+		LOG_ERROR("Can't pass null arguments to buffer_set_layout!");
+		return;
+	}
+	NullBuffer *null_buffer = (NullBuffer *)buffer;
+
+	null_buffer->stride = 0;
+	for (uint32_t i = 0; i < attribute_count; i++)
+		null_buffer->stride += attribute_format_to_bytes(attributes[i].format);
+
+	null_record((NullRenderer *)self, "buffer_set_layout %u %u %u", null_buffer->id, attribute_count, null_buffer->stride);
+}
+
+static void null_buffer_destroy(struct _renderer *self, Buffer *buffer) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullBuffer *null_buffer = (NullBuffer *)buffer;
+
+	if (buffer) {
+		if (renderer->bound_vertex_buffer == buffer)
+			renderer->bound_vertex_buffer = NULL;
+
+		null_record(renderer, "buffer_destroy %u", null_buffer->id);
+		free(null_buffer->mapped);
+		pool_free(renderer->buffer_pool, null_buffer);
+	}
+}
+
+static void null_buffer_activate(struct _renderer *self, const Buffer *buffer) {
+	null_record((NullRenderer *)self, "buffer_activate %u", ((const NullBuffer *)buffer)->id);
+}
+
+static void null_buffer_deactivate(struct _renderer *self, const Buffer *buffer) {
+	null_record((NullRenderer *)self, "buffer_deactivate %u", ((const NullBuffer *)buffer)->id);
+}
+
+static UniformBuffer *null_uniform_buffer_create(struct _renderer *self, size_t size, uint32_t binding) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullUniformBuffer *buffer = pool_alloc(renderer->uniform_buffer_pool, NULL);
+
+	*buffer = (NullUniformBuffer){ .id = ++renderer->next_id, .size = size };
+
+	null_record(renderer, "uniform_buffer_create %u %zu %u", buffer->id, size, binding);
+	return buffer;
+}
+
+static void null_uniform_buffer_update(struct _renderer *self, UniformBuffer *buffer, const void *data, size_t offset, size_t size) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullUniformBuffer *uniform_buffer = (NullUniformBuffer *)buffer;
+	if (buffer == NULL || offset + size > uniform_buffer->size) {
+		LOG_ERROR("Invalid uniform buffer update!");
+		return;
+	}
+
+	renderer->stats.bytes_uploaded += size;
+	null_record(renderer, "uniform_buffer_update %u %zu %zu", uniform_buffer->id, offset, size);
+}
+
+static void null_uniform_buffer_destroy(struct _renderer *self, UniformBuffer *buffer) {
+	if (buffer) {
+		null_record((NullRenderer *)self, "uniform_buffer_destroy %u", ((NullUniformBuffer *)buffer)->id);
+		pool_free(((NullRenderer *)self)->uniform_buffer_pool, buffer);
+	}
+}
+
+/*
+ * ===========================================================================================
+ * -------- GPU timer
+ * ===========================================================================================
+ **/
+
+// There's no GPU time to measure, timers are recorded but never produce a result
+static GpuTimer *null_gpu_timer_create(struct _renderer *self) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullGpuTimer *timer = pool_alloc(renderer->timer_pool, NULL);
+
+	*timer = (NullGpuTimer){ .id = ++renderer->next_id };
+
+	null_record(renderer, "gpu_timer_create %u", timer->id);
+	return timer;
+}
+
+static void null_gpu_timer_begin(struct _renderer *self, GpuTimer *timer) {
+	null_record((NullRenderer *)self, "gpu_timer_begin %u", ((NullGpuTimer *)timer)->id);
+}
+
+static void null_gpu_timer_end(struct _renderer *self, GpuTimer *timer) {
+	null_record((NullRenderer *)self, "gpu_timer_end %u", ((NullGpuTimer *)timer)->id);
+}
+
+static bool null_gpu_timer_result(struct _renderer *self, GpuTimer *timer, uint64_t *nanoseconds) {
+	return false;
+}
+
+static void null_gpu_timer_destroy(struct _renderer *self, GpuTimer *timer) {
+	if (timer) {
+		null_record((NullRenderer *)self, "gpu_timer_destroy %u", ((NullGpuTimer *)timer)->id);
+		pool_free(((NullRenderer *)self)->timer_pool, timer);
+	}
+}
+
+/*
+ * ===========================================================================================
+ * -------- Texture
+ * ===========================================================================================
+ **/
+
+static Texture *null_texture_load(struct _renderer *self, const char *texture_path) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullTexture *texture = pool_alloc(renderer->texture_pool, NULL);
+
+	*texture = (NullTexture){ .id = ++renderer->next_id };
+
+	// Only the header is read, enough to account for the upload the real backends would do
+	if (stbi_info(texture_path, &texture->width, &texture->height, &texture->channels))
+		renderer->stats.bytes_uploaded += (uint64_t)texture->width * texture->height * texture->channels;
+	else
+		LOG_WARN("Texture path [ %s ] not found", texture_path);
+
+	null_record(renderer, "texture_load %u %s", texture->id, texture_path);
+	return texture;
+}
+
+// Nothing is decoded, so there's nothing to wait for either
+static Texture *null_texture_load_async(struct _renderer *self, JobSystem *jobs, const char *texture_path) {
+	return null_texture_load(self, texture_path);
+}
+
+static Texture *null_texture_array_load_async(struct _renderer *self, JobSystem *jobs, const char **paths, uint32_t layer_count, uint32_t width, uint32_t height) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	NullTexture *texture = pool_alloc(renderer->texture_pool, NULL);
+
+	*texture = (NullTexture){ .id = ++renderer->next_id, .width = width, .height = height, .channels = 4 };
+	renderer->stats.bytes_uploaded += (uint64_t)width * height * 4 * layer_count;
+
+	null_record(renderer, "texture_array_load %u %u %u %u", texture->id, layer_count, width, height);
+	return texture;
+}
+
+static uint32_t null_texture_stream(struct _renderer *self, double budget_seconds) {
+	return 0;
+}
+
+// Nothing is cooked either, the directory only shows up in the recording
+static void null_texture_cache_set(struct _renderer *self, const char *directory) {
+	null_record((NullRenderer *)self, "texture_cache_set %s", directory ? directory : "none");
+}
+
+static void null_texture_destroy(struct _renderer *self, Texture *texture) {
+	if (texture) {
+		null_record((NullRenderer *)self, "texture_destroy %u", ((NullTexture *)texture)->id);
+		pool_free(((NullRenderer *)self)->texture_pool, texture);
+	}
+}
+
+static void null_texture_activate(struct _renderer *self, Texture *texture, uint32_t texture_unit) {
+	NullRenderer *renderer = (NullRenderer *)self;
+	if (texture == NULL) {
+		LOG_ERROR("Null texture passed to texture_activate!");
+		exit(1);
+	}
+
+	renderer->stats.texture_binds++;
+	null_record(renderer, "texture_activate %u %u", ((NullTexture *)texture)->id, texture_unit);
+}
+
+/*
+ * ===========================================================================================
+ * -------- Shader
+ * ===========================================================================================
+ **/
+
+static Shader *null_shader_from_string(const char *vertex_shader_source, const char *fragment_shader_source, const char *geometry_shader_source) {
+	NullShader *shader = pool_alloc(g_null_renderer->shader_pool, NULL);
+
+	*shader = (NullShader){ .id = ++g_null_renderer->next_id };
+
+	null_record(g_null_renderer, "shader_create %u", shader->id);
+	return shader;
+}
+
+static Shader *null_shader_from_file(const char *vertex_shader_path, const char *fragment_shader_path, const char *geometry_shader_path) {
+	return null_shader_from_string(vertex_shader_path, fragment_shader_path, geometry_shader_path);
+}
+
+static void null_shader_destroy(Shader *shader) {
+	if (shader) {
+		null_record(g_null_renderer, "shader_destroy %u", ((NullShader *)shader)->id);
+		pool_free(g_null_renderer->shader_pool, shader);
+	}
+}
+
+static void null_shader_activate(Shader *shader) {
+	g_null_renderer->stats.shader_binds++;
+	null_record(g_null_renderer, "shader_activate %u", ((NullShader *)shader)->id);
+}
+
+static void null_shader_deactivate(Shader *shader) {
+	null_record(g_null_renderer, "shader_deactivate");
+}
+
+static void null_shader_seti(Shader *shader, const char *name, int32_t value) {
+	g_null_renderer->stats.uniform_sets++;
+	null_record(g_null_renderer, "uniform %s %d", name, value);
+}
+static void null_shader_setf(Shader *shader, const char *name, float value) {
+	g_null_renderer->stats.uniform_sets++;
+	null_record(g_null_renderer, "uniform %s %g", name, value);
+}
+static void null_shader_setfv(Shader *shader, const char *name, float *value) {
+	g_null_renderer->stats.uniform_sets++;
+	null_record(g_null_renderer, "uniform %s", name);
+}
+
+// Handles are a hash of the name, stable and unique enough for a recording
+static Uniform null_shader_uniform(Shader *shader, const char *name) {
+	uint32_t hash = 2166136261u;
+	for (const char *c = name; *c; c++)
+		hash = (hash ^ (uint8_t)*c) * 16777619u;
+
+	return (Uniform)(hash & 0x7FFFFFFF);
+}
+
+static void null_shader_uniform_seti(Shader *shader, Uniform uniform, int32_t value) {
+	g_null_renderer->stats.uniform_sets++;
+	null_record(g_null_renderer, "uniform_handle %d %d", uniform, value);
+}
+static void null_shader_uniform_setf(Shader *shader, Uniform uniform, float value) {
+	g_null_renderer->stats.uniform_sets++;
+	null_record(g_null_renderer, "uniform_handle %d %g", uniform, value);
+}
+static void null_shader_uniform_setfv(Shader *shader, Uniform uniform, float *value) {
+	g_null_renderer->stats.uniform_sets++;
+	null_record(g_null_renderer, "uniform_handle %d", uniform);
+}
+
+Renderer *null_renderer_create() {
+	if (g_null_renderer) {
+		LOG_ERROR("Only one null renderer can exist at a time!");
+		return NULL;
+	}
+
+	NullRenderer *renderer = malloc(sizeof(NullRenderer));
+	*renderer = (NullRenderer){ 0 };
+	renderer->base.backend = BACKEND_API_NONE;
+	g_null_renderer = renderer;
+
+	renderer->buffer_pool = pool_create(sizeof(NullBuffer), 64);
+	renderer->uniform_buffer_pool = pool_create(sizeof(NullUniformBuffer), 8);
+	renderer->timer_pool = pool_create(sizeof(NullGpuTimer), 16);
+	renderer->texture_pool = pool_create(sizeof(NullTexture), 16);
+	renderer->shader_pool = pool_create(sizeof(NullShader), 16);
+
+	// Draw
+	renderer->base.draw = null_draw;
+	renderer->base.draw_indexed = null_draw_indexed;
+	renderer->base.draw_instanced = null_draw_instanced;
+	renderer->base.draw_indexed_instanced = null_draw_indexed_instanced;
+
+	renderer->base.on_resize = null_on_resize;
+	renderer->base.frame_begin = null_frame_begin;
+	renderer->base.frame_end = null_frame_end;
+	renderer->base.get_stats = null_get_stats;
+
+	// Buffer -----------------------------------------------------
+	renderer->base.buffer_create = null_buffer_create;
+	renderer->base.buffer_create_dynamic = null_buffer_create_dynamic;
+	renderer->base.buffer_map = null_buffer_map;
+	renderer->base.buffer_update = null_buffer_update;
+	renderer->base.buffer_destroy = null_buffer_destroy;
+	renderer->base.buffer_set_layout = null_buffer_set_layout;
+	renderer->base.buffer_activate = null_buffer_activate;
+	renderer->base.buffer_deactivate = null_buffer_deactivate;
+
+	renderer->base.uniform_buffer_create = null_uniform_buffer_create;
+	renderer->base.uniform_buffer_update = null_uniform_buffer_update;
+	renderer->base.uniform_buffer_destroy = null_uniform_buffer_destroy;
+
+	renderer->base.gpu_timer_create = null_gpu_timer_create;
+	renderer->base.gpu_timer_begin = null_gpu_timer_begin;
+	renderer->base.gpu_timer_end = null_gpu_timer_end;
+	renderer->base.gpu_timer_result = null_gpu_timer_result;
+	renderer->base.gpu_timer_destroy = null_gpu_timer_destroy;
+
+	// Texture ----------------------------------------------------
+	renderer->base.texture_load = null_texture_load;
+	renderer->base.texture_load_async = null_texture_load_async;
+	renderer->base.texture_stream = null_texture_stream;
+	renderer->base.texture_array_load_async = null_texture_array_load_async;
+	renderer->base.texture_cache_set = null_texture_cache_set;
+	renderer->base.texture_destroy = null_texture_destroy;
+	renderer->base.texture_activate = null_texture_activate;
+
+	// Shader -----------------------------------------------------
+	renderer->base.shader_from_file = null_shader_from_file;
+	renderer->base.shader_from_string = null_shader_from_string;
+	renderer->base.shader_destroy = null_shader_destroy;
+
+	renderer->base.shader_activate = null_shader_activate;
+	renderer->base.shader_deactivate = null_shader_deactivate;
+
+	renderer->base.shader_seti = null_shader_seti;
+	renderer->base.shader_setf = null_shader_setf;
+	renderer->base.shader_set2fv = null_shader_setfv;
+	renderer->base.shader_set3fv = null_shader_setfv;
+	renderer->base.shader_set4fv = null_shader_setfv;
+	renderer->base.shader_set4fm = null_shader_setfv;
+
+	renderer->base.shader_uniform = null_shader_uniform;
+	renderer->base.shader_uniform_seti = null_shader_uniform_seti;
+	renderer->base.shader_uniform_setf = null_shader_uniform_setf;
+	renderer->base.shader_uniform_set2fv = null_shader_uniform_setfv;
+	renderer->base.shader_uniform_set3fv = null_shader_uniform_setfv;
+	renderer->base.shader_uniform_set4fv = null_shader_uniform_setfv;
+	renderer->base.shader_uniform_set4fm = null_shader_uniform_setfv;
+
+	return &renderer->base;
+}
+
+void null_renderer_destroy(Renderer *renderer) {
+	NullRenderer *null_renderer = (NullRenderer *)renderer;
+	if (renderer == &g_null_renderer->base)
+		g_null_renderer = NULL;
+
+	// Whatever is still live goes with its pool
+	Pool *pools[] = { null_renderer->buffer_pool, null_renderer->uniform_buffer_pool, null_renderer->timer_pool, null_renderer->texture_pool, null_renderer->shader_pool };
+	const char *names[] = { "buffer", "uniform buffer", "GPU timer", "texture", "shader" };
+	for (uint32_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+		PoolStats stats;
+		pool_get_stats(pools[i], &stats);
+		if (stats.live)
+			LOG_WARN("%u %s(s) weren't destroyed before the renderer", stats.live, names[i]);
+		pool_destroy(pools[i]);
+	}
+}
+
+void null_renderer_record(Renderer *renderer, FILE *stream) {
+	((NullRenderer *)renderer)->stream = stream;
+}
+
+void null_record(NullRenderer *renderer, const char *format, ...) {
+	if (renderer->stream == NULL)
+		return;
+
+	va_list arguments;
+	va_start(arguments, format);
+	vfprintf(renderer->stream, format, arguments);
+	va_end(arguments);
+	fputc('\n', renderer->stream);
+}
+
+uint32_t attribute_format_to_bytes(AttributeFormat format) {
+	switch (format) {
+		case FORMAT_FLOAT:
+			return sizeof(float);
+		case FORMAT_FLOAT2:
+			return sizeof(float) * 2;
+		case FORMAT_FLOAT3:
+			return sizeof(float) * 3;
+		case FORMAT_FLOAT4:
+			return sizeof(float) * 4;
+		case FORMAT_HALF2:
+		case FORMAT_SNORM16x2:
+		case FORMAT_UINT16x2:
+			return sizeof(uint16_t) * 2;
+		case FORMAT_HALF4:
+		case FORMAT_SNORM16x4:
+			return sizeof(uint16_t) * 4;
+		case FORMAT_UNORM8x4:
+		case FORMAT_UINT8x4:
+		case FORMAT_INT_2_10_10_10_REV:
+		case FORMAT_UINT32:
+			return sizeof(uint32_t);
+		default: {
+			LOG_ERROR("Unkown attribute format type provided!");
+			return 0;
+		} break;
+	}
+}
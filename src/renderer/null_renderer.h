@@ -0,0 +1,16 @@
+#pragma once
+#include "renderer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Renderer without a GPU: every vtable entry is implemented on the CPU, draws only update counters.
+ * Lets the CPU side of a frame (streaming, culling, sorting, uniform setup) run and be measured anywhere.
+ */
+
+Renderer *null_renderer_create();
+void null_renderer_destroy(Renderer *renderer);
+
+// Writes every command to stream as a line of text, NULL stops recording
+void null_renderer_record(Renderer *renderer, FILE *stream);
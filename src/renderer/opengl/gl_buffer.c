@@ -9,6 +9,14 @@
 static inline size_t attribute_format_to_bytes(AttributeFormat attribute_format);
 static inline uint32_t attribute_format_to_count(AttributeFormat attribute_format);
 static inline GLenum attribute_format_to_gl_type(AttributeFormat attribute_format);
+static inline bool attribute_format_is_normalized(AttributeFormat attribute_format);
+static inline bool attribute_format_is_integer(AttributeFormat attribute_format);
+static void opengl_bind_vertex_array(OpenGLRenderer *renderer, uint32_t vao);
+static void opengl_bind_draw_buffers(OpenGLRenderer *renderer, OpenGLBuffer *vertex_buffer, const OpenGLBuffer *index_buffer, const OpenGLBuffer *instance_buffer);
+static size_t opengl_buffer_region_offset(const OpenGLRenderer *renderer, const OpenGLBuffer *buffer);
+static uint32_t opengl_buffer_base_element(const OpenGLRenderer *renderer, const OpenGLBuffer *buffer);
+static void opengl_attach_layout(const OpenGLVertexLayout *layout, uint32_t buffer_id, uint32_t first_location);
+static void opengl_count_draw(OpenGLRenderer *renderer, uint32_t vertex_count, uint32_t instance_count);
 
 void opengl_draw(struct _renderer *self, Buffer *vertex_buffer, uint32_t vertex_count) {
 	if (vertex_buffer == NULL) {
@@ -17,28 +25,15 @@ void opengl_draw(struct _renderer *self, Buffer *vertex_buffer, uint32_t vertex_
 	}
 	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)vertex_buffer;
 
-	if (gl_buffer->layout.attributes == NULL) {
+	if (gl_buffer->vao == 0) {
 		LOG_ERROR("Can't draw buffer without layout!");
 		return;
 	}
 
-	self->buffer_activate(self, vertex_buffer);
-	const OpenGLVertexLayout *layout = &gl_buffer->layout;
-	for (uint32_t i = 0; i < layout->count; i++) {
-		const OpenGLVertexAttribute *attribute = &layout->attributes[i];
-		GLenum type = attribute_format_to_gl_type(attribute->format);
-		uint32_t count = attribute_format_to_count(attribute->format);
-
-		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, count, type, GL_FALSE, layout->stride, (void *)(uintptr_t)attribute->offset);
-	}
-
-	glDrawArrays(GL_TRIANGLES, 0, vertex_count);
-
-	for (uint32_t i = 0; i < layout->count; i++) {
-		glDisableVertexAttribArray(i);
-	}
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	opengl_bind_draw_buffers(renderer, gl_buffer, NULL, NULL);
+	glDrawArrays(GL_TRIANGLES, opengl_buffer_base_element(renderer, gl_buffer), vertex_count);
+	opengl_count_draw(renderer, vertex_count, 1);
 }
 
 void opengl_draw_indexed(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, uint32_t element_count) {
@@ -48,55 +43,167 @@ void opengl_draw_indexed(struct _renderer *self, Buffer *vertex_buffer, Buffer *
 	}
 	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)vertex_buffer;
 
-	if (gl_buffer->layout.attributes == NULL) {
+	if (gl_buffer->vao == 0) {
 		LOG_ERROR("Can't use vertex buffer without layout!");
 		return;
 	}
 
-	self->buffer_activate(self, vertex_buffer);
-	const OpenGLVertexLayout *layout = &gl_buffer->layout;
-	for (uint32_t i = 0; i < layout->count; i++) {
-		const OpenGLVertexAttribute *attribute = &layout->attributes[i];
-		GLenum type = attribute_format_to_gl_type(attribute->format);
-		uint32_t count = attribute_format_to_count(attribute->format);
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	OpenGLBuffer *gl_index_buffer = (OpenGLBuffer *)index_buffer;
+	opengl_bind_draw_buffers(renderer, gl_buffer, gl_index_buffer, NULL);
 
-		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, count, type, GL_FALSE, layout->stride, (void *)(uintptr_t)attribute->offset);
+	void *indices = (void *)(uintptr_t)opengl_buffer_region_offset(renderer, gl_index_buffer);
+	glDrawElementsBaseVertex(GL_TRIANGLES, element_count, gl_index_buffer->index_type, indices, opengl_buffer_base_element(renderer, gl_buffer));
+	opengl_count_draw(renderer, element_count, 1);
+}
+
+void opengl_draw_instanced(struct _renderer *self, Buffer *vertex_buffer, Buffer *instance_buffer, uint32_t vertex_count, uint32_t instance_count) {
+	if (vertex_buffer == NULL) {
+		LOG_ERROR("Invalid buffer passed to draw_instanced function!");
+		return;
 	}
+	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)vertex_buffer;
+	OpenGLBuffer *gl_instance_buffer = (OpenGLBuffer *)instance_buffer;
 
-	self->buffer_activate(self, index_buffer);
+	if (gl_buffer->vao == 0 || (gl_instance_buffer && gl_instance_buffer->layout.count == 0)) {
+		LOG_ERROR("Can't draw buffer(s) without layout!");
+		return;
+	}
 
-	glDrawElements(GL_TRIANGLES, element_count, GL_UNSIGNED_INT, NULL);
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	opengl_bind_draw_buffers(renderer, gl_buffer, NULL, gl_instance_buffer);
 
-	for (uint32_t i = 0; i < layout->count; i++) {
-		glDisableVertexAttribArray(i);
+	uint32_t first = opengl_buffer_base_element(renderer, gl_buffer);
+	uint32_t base_instance = gl_instance_buffer ? opengl_buffer_base_element(renderer, gl_instance_buffer) : 0;
+	glDrawArraysInstancedBaseInstance(GL_TRIANGLES, first, vertex_count, instance_count, base_instance);
+	opengl_count_draw(renderer, vertex_count, instance_count);
+}
+
+void opengl_draw_indexed_instanced(struct _renderer *self, Buffer *vertex_buffer, Buffer *index_buffer, Buffer *instance_buffer, uint32_t element_count, uint32_t instance_count) {
+	if (vertex_buffer == NULL || index_buffer == NULL) {
+		LOG_ERROR("Invalid buffer(s) passed to draw_indexed_instanced function!");
+		return;
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)vertex_buffer;
+	OpenGLBuffer *gl_instance_buffer = (OpenGLBuffer *)instance_buffer;
+
+	if (gl_buffer->vao == 0 || (gl_instance_buffer && gl_instance_buffer->layout.count == 0)) {
+		LOG_ERROR("Can't draw buffer(s) without layout!");
+		return;
+	}
+
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	OpenGLBuffer *gl_index_buffer = (OpenGLBuffer *)index_buffer;
+	opengl_bind_draw_buffers(renderer, gl_buffer, gl_index_buffer, gl_instance_buffer);
+
+	void *indices = (void *)(uintptr_t)opengl_buffer_region_offset(renderer, gl_index_buffer);
+	uint32_t base_vertex = opengl_buffer_base_element(renderer, gl_buffer);
+	uint32_t base_instance = gl_instance_buffer ? opengl_buffer_base_element(renderer, gl_instance_buffer) : 0;
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, element_count, gl_index_buffer->index_type, indices, instance_count, base_vertex, base_instance);
+	opengl_count_draw(renderer, element_count, instance_count);
 }
 
 Buffer *opengl_buffer_create(struct _renderer *self, BufferType type, size_t size, void *data) {
-	OpenGLBuffer *gl_buffer = malloc(sizeof(OpenGLBuffer));
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	OpenGLBuffer *gl_buffer = pool_alloc(renderer->buffer_pool, NULL);
 
 	*gl_buffer = (OpenGLBuffer){ 0 };
 	gl_buffer->type = type == BUFFER_TYPE_VERTEX ? GL_ARRAY_BUFFER : GL_ELEMENT_ARRAY_BUFFER;
+	gl_buffer->index_type = type == BUFFER_TYPE_INDEX16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	gl_buffer->serial = ++renderer->buffer_serial;
+	gl_buffer->size = size;
 
+	opengl_bind_vertex_array(renderer, renderer->vao);
 	glGenBuffers(1, &gl_buffer->id);
 	glBindBuffer(gl_buffer->type, gl_buffer->id);
 	glBufferData(gl_buffer->type, size, data, GL_STATIC_DRAW);
 	glBindBuffer(gl_buffer->type, 0);
 
+	if (data)
+		renderer->stats.bytes_uploaded += size;
 	return gl_buffer;
 }
 
+Buffer *opengl_buffer_create_dynamic(struct _renderer *self, BufferType type, size_t size) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	OpenGLBuffer *gl_buffer = pool_alloc(renderer->buffer_pool, NULL);
+
+	*gl_buffer = (OpenGLBuffer){ 0 };
+	gl_buffer->type = type == BUFFER_TYPE_VERTEX ? GL_ARRAY_BUFFER : GL_ELEMENT_ARRAY_BUFFER;
+	gl_buffer->index_type = type == BUFFER_TYPE_INDEX16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	gl_buffer->serial = ++renderer->buffer_serial;
+	gl_buffer->size = size;
+	gl_buffer->dynamic = true;
+
+	// One region per frame in flight, the fences in frame_begin keep the CPU off the regions the GPU still reads
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	opengl_bind_vertex_array(renderer, renderer->vao);
+	glGenBuffers(1, &gl_buffer->id);
+	glBindBuffer(gl_buffer->type, gl_buffer->id);
+	glBufferStorage(gl_buffer->type, size * OPENGL_FRAMES_IN_FLIGHT, NULL, flags);
+	gl_buffer->mapped = glMapBufferRange(gl_buffer->type, 0, size * OPENGL_FRAMES_IN_FLIGHT, flags);
+	glBindBuffer(gl_buffer->type, 0);
+
+	if (gl_buffer->mapped == NULL) {
+		LOG_ERROR("Failed to map dynamic buffer of %zu bytes!", size);
+		glDeleteBuffers(1, &gl_buffer->id);
+		pool_free(renderer->buffer_pool, gl_buffer);
+		return NULL;
+	}
+
+	return gl_buffer;
+}
+
+void *opengl_buffer_map(struct _renderer *self, Buffer *buffer) {
+	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)buffer;
+	if (buffer == NULL || !gl_buffer->dynamic) {
+		LOG_ERROR("Only dynamic buffers can be mapped!");
+		return NULL;
+	}
+
+	// The caller is going to fill the region, count it as uploaded
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	renderer->stats.bytes_uploaded += gl_buffer->size;
+	return gl_buffer->mapped + opengl_buffer_region_offset(renderer, gl_buffer);
+}
+
+void opengl_buffer_update(struct _renderer *self, Buffer *buffer, const void *data, size_t offset, size_t size) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)buffer;
+	if (buffer == NULL || offset + size > gl_buffer->size) {
+		LOG_ERROR("Invalid buffer update!");
+		return;
+	}
+	renderer->stats.bytes_uploaded += size;
+
+	if (gl_buffer->dynamic) {
+		memcpy(gl_buffer->mapped + opengl_buffer_region_offset(renderer, gl_buffer) + offset, data, size);
+		return;
+	}
+
+	// Full rewrites of static buffers orphan the storage so the driver doesn't wait on draws still reading it. Partial
+	// ones get a plain sub-data upload, which may stall if the GPU is still reading them
+	opengl_bind_vertex_array(renderer, renderer->vao);
+	glBindBuffer(gl_buffer->type, gl_buffer->id);
+	if (offset == 0 && size == gl_buffer->size)
+		glBufferData(gl_buffer->type, size, data, GL_STATIC_DRAW);
+	else
+		glBufferSubData(gl_buffer->type, offset, size, data);
+	glBindBuffer(gl_buffer->type, 0);
+}
+
 void opengl_buffer_set_layout(struct _renderer *self, Buffer *buffer, VertexAttribute *attributes, uint32_t attribute_count) {
 	if (attributes == NULL || buffer == NULL) {
 		LOG_ERROR("Can't pass null arguments to buffer_set_layout!");
 		return;
 	}
+	if (attribute_count > OPENGL_MAX_VERTEX_ATTRIBUTES) {
+		LOG_ERROR("Layout has %u attributes, at most %u are supported!", attribute_count, OPENGL_MAX_VERTEX_ATTRIBUTES);
+		return;
+	}
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
 	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)buffer;
 
-	gl_buffer->layout.attributes = malloc(sizeof(OpenGLVertexAttribute) * attribute_count);
 	gl_buffer->layout.count = attribute_count;
 
 	uint32_t offset = 0;
@@ -106,41 +213,194 @@ void opengl_buffer_set_layout(struct _renderer *self, Buffer *buffer, VertexAttr
 			.name = attribute.name,
 			.offset = offset,
 			.format = attribute.format,
-			.location = attribute_index
+			.location = attribute_index,
+			.divisor = attribute.divisor
 		};
 		offset += attribute_format_to_bytes(attribute.format);
 	}
 	gl_buffer->layout.stride = offset;
+
+	if (gl_buffer->dynamic && gl_buffer->size % gl_buffer->layout.stride != 0) {
+		LOG_ERROR("Dynamic buffer size %zu isn't a multiple of its vertex stride %u!", gl_buffer->size, gl_buffer->layout.stride);
+		return;
+	}
+
+	// Bake the layout into a vertex array once, draws then only have to bind it
+	if (gl_buffer->vao == 0)
+		glGenVertexArrays(1, &gl_buffer->vao);
+	opengl_bind_vertex_array(renderer, gl_buffer->vao);
+	opengl_attach_layout(&gl_buffer->layout, gl_buffer->id, 0);
+	opengl_bind_vertex_array(renderer, renderer->vao);
 }
 
 void opengl_buffer_destroy(struct _renderer *self, Buffer *buffer) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
 	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)buffer;
 
 	if (buffer) {
+		if (gl_buffer->vao) {
+			// Deleting the bound vertex array reverts the binding to 0
+			if (renderer->bound_vao == gl_buffer->vao)
+				renderer->bound_vao = 0;
+			glDeleteVertexArrays(1, &gl_buffer->vao);
+		}
+
 		glDeleteBuffers(1, &gl_buffer->id);
-		free(gl_buffer);
+		pool_free(renderer->buffer_pool, gl_buffer);
 	}
 }
 
 void opengl_buffer_activate(struct _renderer *self, const Buffer *buffer) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
 	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)buffer;
 	if (!buffer) {
 		LOG_ERROR("Invalid buffer passed to buffer_activate function!");
 		exit(1);
 	}
 
+	opengl_bind_vertex_array(renderer, renderer->vao);
 	glBindBuffer(gl_buffer->type, gl_buffer->id);
 }
 void opengl_buffer_deactivate(struct _renderer *self, const Buffer *buffer) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
 	OpenGLBuffer *gl_buffer = (OpenGLBuffer *)buffer;
 	if (!buffer) {
 		LOG_ERROR("Invalid buffer passed to buffer_deactivate function!");
 		exit(1);
 	}
 
+	opengl_bind_vertex_array(renderer, renderer->vao);
 	glBindBuffer(gl_buffer->type, 0);
 }
 
+UniformBuffer *opengl_uniform_buffer_create(struct _renderer *self, size_t size, uint32_t binding) {
+	OpenGLUniformBuffer *uniform_buffer = pool_alloc(((OpenGLRenderer *)self)->uniform_buffer_pool, NULL);
+	*uniform_buffer = (OpenGLUniformBuffer){ .binding = binding, .size = size };
+
+	glGenBuffers(1, &uniform_buffer->id);
+	glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer->id);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, uniform_buffer->id);
+	return uniform_buffer;
+}
+
+void opengl_uniform_buffer_update(struct _renderer *self, UniformBuffer *buffer, const void *data, size_t offset, size_t size) {
+	OpenGLUniformBuffer *uniform_buffer = (OpenGLUniformBuffer *)buffer;
+	if (buffer == NULL || offset + size > uniform_buffer->size) {
+		LOG_ERROR("Invalid uniform buffer update!");
+		return;
+	}
+	((OpenGLRenderer *)self)->stats.bytes_uploaded += size;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer->id);
+	// Orphan on full rewrites so the driver doesn't wait on draws still reading last frame's contents
+	if (offset == 0 && size == uniform_buffer->size)
+		glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+	else
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void opengl_uniform_buffer_destroy(struct _renderer *self, UniformBuffer *buffer) {
+	OpenGLUniformBuffer *uniform_buffer = (OpenGLUniformBuffer *)buffer;
+
+	if (buffer) {
+		glDeleteBuffers(1, &uniform_buffer->id);
+		pool_free(((OpenGLRenderer *)self)->uniform_buffer_pool, uniform_buffer);
+	}
+}
+
+void opengl_bind_draw_buffers(OpenGLRenderer *renderer, OpenGLBuffer *vertex_buffer, const OpenGLBuffer *index_buffer, const OpenGLBuffer *instance_buffer) {
+	if (renderer->bound_vao != vertex_buffer->vao)
+		renderer->stats.buffer_binds++;
+	opengl_bind_vertex_array(renderer, vertex_buffer->vao);
+
+	// The element array binding is part of the vertex array state, so it only changes when the pairing does
+	if (index_buffer && vertex_buffer->element_serial != index_buffer->serial) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer->id);
+		vertex_buffer->element_serial = index_buffer->serial;
+	}
+
+	// Same for the instance attributes, which sit in the locations after the vertex attributes
+	uint32_t instance_serial = instance_buffer ? instance_buffer->serial : 0;
+	if (vertex_buffer->instance_serial != instance_serial) {
+		for (uint32_t i = 0; i < vertex_buffer->instance_attribute_count; i++)
+			glDisableVertexAttribArray(vertex_buffer->layout.count + i);
+
+		if (instance_buffer)
+			opengl_attach_layout(&instance_buffer->layout, instance_buffer->id, vertex_buffer->layout.count);
+
+		vertex_buffer->instance_serial = instance_serial;
+		vertex_buffer->instance_attribute_count = instance_buffer ? instance_buffer->layout.count : 0;
+	}
+}
+
+// Points the attributes of layout at buffer_id in the bound vertex array, starting from first_location
+void opengl_attach_layout(const OpenGLVertexLayout *layout, uint32_t buffer_id, uint32_t first_location) {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+	for (uint32_t i = 0; i < layout->count; i++) {
+		const OpenGLVertexAttribute *attribute = &layout->attributes[i];
+		GLenum type = attribute_format_to_gl_type(attribute->format);
+		uint32_t count = attribute_format_to_count(attribute->format);
+		uint32_t location = first_location + attribute->location;
+
+		glEnableVertexAttribArray(location);
+		if (attribute_format_is_integer(attribute->format))
+			glVertexAttribIPointer(location, count, type, layout->stride, (void *)(uintptr_t)attribute->offset);
+		else
+			glVertexAttribPointer(location, count, type, attribute_format_is_normalized(attribute->format), layout->stride, (void *)(uintptr_t)attribute->offset);
+		glVertexAttribDivisor(location, attribute->divisor);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void opengl_frame_begin(struct _renderer *self) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	renderer->frame_index = (renderer->frame_index + 1) % OPENGL_FRAMES_IN_FLIGHT;
+
+	// Wait for the GPU to finish the frame that last wrote this frame's regions
+	GLsync fence = renderer->frame_fences[renderer->frame_index];
+	if (fence) {
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED)
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+		glDeleteSync(fence);
+		renderer->frame_fences[renderer->frame_index] = NULL;
+	}
+}
+
+void opengl_frame_end(struct _renderer *self) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	renderer->frame_fences[renderer->frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	renderer->stats.frames++;
+}
+
+void opengl_count_draw(OpenGLRenderer *renderer, uint32_t vertex_count, uint32_t instance_count) {
+	renderer->stats.draw_calls++;
+	renderer->stats.triangles += (uint64_t)(vertex_count / 3) * instance_count;
+}
+
+// Byte offset of the region the current frame reads and writes, always 0 for static buffers
+size_t opengl_buffer_region_offset(const OpenGLRenderer *renderer, const OpenGLBuffer *buffer) {
+	return buffer->dynamic ? renderer->frame_index * buffer->size : 0;
+}
+
+// The current region in elements of the buffer layout, used as base vertex or base instance
+uint32_t opengl_buffer_base_element(const OpenGLRenderer *renderer, const OpenGLBuffer *buffer) {
+	return buffer->dynamic ? (uint32_t)(opengl_buffer_region_offset(renderer, buffer) / buffer->layout.stride) : 0;
+}
+
+void opengl_bind_vertex_array(OpenGLRenderer *renderer, uint32_t vao) {
+	if (renderer->bound_vao == vao)
+		return;
+
+	glBindVertexArray(vao);
+	renderer->bound_vao = vao;
+}
+
 size_t attribute_format_to_bytes(AttributeFormat attribute_format) {
 	switch (attribute_format) {
 		case FORMAT_FLOAT:
@@ -151,6 +411,24 @@ size_t attribute_format_to_bytes(AttributeFormat attribute_format) {
 			return sizeof(float) * 3;
 		case FORMAT_FLOAT4:
 			return sizeof(float) * 4;
+		case FORMAT_HALF2:
+			return sizeof(uint16_t) * 2;
+		case FORMAT_HALF4:
+			return sizeof(uint16_t) * 4;
+		case FORMAT_UNORM8x4:
+			return sizeof(uint8_t) * 4;
+		case FORMAT_SNORM16x2:
+			return sizeof(int16_t) * 2;
+		case FORMAT_SNORM16x4:
+			return sizeof(int16_t) * 4;
+		case FORMAT_INT_2_10_10_10_REV:
+			return sizeof(uint32_t);
+		case FORMAT_UINT8x4:
+			return sizeof(uint8_t) * 4;
+		case FORMAT_UINT16x2:
+			return sizeof(uint16_t) * 2;
+		case FORMAT_UINT32:
+			return sizeof(uint32_t);
 		default: {
 			LOG_ERROR("Unkown attribute format type provided!");
 			return 0;
@@ -161,12 +439,21 @@ size_t attribute_format_to_bytes(AttributeFormat attribute_format) {
 uint32_t attribute_format_to_count(AttributeFormat attribute_format) {
 	switch (attribute_format) {
 		case FORMAT_FLOAT:
+		case FORMAT_UINT32:
 			return 1;
 		case FORMAT_FLOAT2:
+		case FORMAT_HALF2:
+		case FORMAT_SNORM16x2:
+		case FORMAT_UINT16x2:
 			return 2;
 		case FORMAT_FLOAT3:
 			return 3;
 		case FORMAT_FLOAT4:
+		case FORMAT_HALF4:
+		case FORMAT_UNORM8x4:
+		case FORMAT_SNORM16x4:
+		case FORMAT_INT_2_10_10_10_REV:
+		case FORMAT_UINT8x4:
 			return 4;
 		default: {
 			LOG_ERROR("Unkown attribute format type provided!");
@@ -181,9 +468,34 @@ GLenum attribute_format_to_gl_type(AttributeFormat attribute_format) {
 		case FORMAT_FLOAT3:
 		case FORMAT_FLOAT4:
 			return GL_FLOAT;
+		case FORMAT_HALF2:
+		case FORMAT_HALF4:
+			return GL_HALF_FLOAT;
+		case FORMAT_UNORM8x4:
+		case FORMAT_UINT8x4:
+			return GL_UNSIGNED_BYTE;
+		case FORMAT_SNORM16x2:
+		case FORMAT_SNORM16x4:
+			return GL_SHORT;
+		case FORMAT_INT_2_10_10_10_REV:
+			return GL_INT_2_10_10_10_REV;
+		case FORMAT_UINT16x2:
+			return GL_UNSIGNED_SHORT;
+		case FORMAT_UINT32:
+			return GL_UNSIGNED_INT;
 		default: {
 			LOG_ERROR("Unkown attribute format type provided!");
 			return 0;
 		} break;
 	}
 }
+
+bool attribute_format_is_normalized(AttributeFormat attribute_format) {
+	return attribute_format == FORMAT_UNORM8x4 || attribute_format == FORMAT_SNORM16x2 || attribute_format == FORMAT_SNORM16x4 ||
+		attribute_format == FORMAT_INT_2_10_10_10_REV;
+}
+
+// Integer formats go through glVertexAttribIPointer so the shader sees the values unconverted
+bool attribute_format_is_integer(AttributeFormat attribute_format) {
+	return attribute_format == FORMAT_UINT8x4 || attribute_format == FORMAT_UINT16x2 || attribute_format == FORMAT_UINT32;
+}
@@ -0,0 +1,144 @@
+#include "base.h"
+#include "gl_types.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/gl.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct _gl_offscreen {
+	EGLDisplay display;
+	EGLContext context;
+	EGLSurface surface; // EGL_NO_SURFACE when the context is surfaceless
+	uint32_t framebuffer, color_buffer, depth_buffer;
+	uint32_t width, height;
+};
+
+static EGLDisplay offscreen_get_display(void);
+static void offscreen_release(OpenGLOffscreen *offscreen);
+
+OpenGLOffscreen *opengl_offscreen_create(uint32_t width, uint32_t height) {
+	OpenGLOffscreen *offscreen = malloc(sizeof(OpenGLOffscreen));
+	*offscreen = (OpenGLOffscreen){ .display = EGL_NO_DISPLAY, .context = EGL_NO_CONTEXT, .surface = EGL_NO_SURFACE, .width = width, .height = height };
+
+	offscreen->display = offscreen_get_display();
+	EGLint major, minor;
+	if (offscreen->display == EGL_NO_DISPLAY || !eglInitialize(offscreen->display, &major, &minor)) {
+		LOG_ERROR("Failed to initialize EGL (0x%x)", eglGetError());
+		offscreen_release(offscreen);
+		return NULL;
+	}
+
+	const EGLint config_attributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint config_count = 0;
+	if (!eglChooseConfig(offscreen->display, config_attributes, &config, 1, &config_count) || config_count == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+		LOG_ERROR("No EGL config supports desktop OpenGL (0x%x)", eglGetError());
+		offscreen_release(offscreen);
+		return NULL;
+	}
+
+	const EGLint context_attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	offscreen->context = eglCreateContext(offscreen->display, config, EGL_NO_CONTEXT, context_attributes);
+	if (offscreen->context == EGL_NO_CONTEXT) {
+		LOG_ERROR("Failed to create an OpenGL 4.5 core EGL context (0x%x)", eglGetError());
+		offscreen_release(offscreen);
+		return NULL;
+	}
+
+	// Everything is drawn into the framebuffer below, the surface only exists when the context can't go without one
+	const char *extensions = eglQueryString(offscreen->display, EGL_EXTENSIONS);
+	if (extensions == NULL || strstr(extensions, "EGL_KHR_surfaceless_context") == NULL) {
+		const EGLint surface_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		offscreen->surface = eglCreatePbufferSurface(offscreen->display, config, surface_attributes);
+	}
+
+	if (!eglMakeCurrent(offscreen->display, offscreen->surface, offscreen->surface, offscreen->context)) {
+		LOG_ERROR("Failed to make the EGL context current (0x%x)", eglGetError());
+		offscreen_release(offscreen);
+		return NULL;
+	}
+
+	gladLoadGL((GLADloadfunc)eglGetProcAddress);
+	LOG_INFO("Offscreen OpenGL context: %s, %s", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	glGenFramebuffers(1, &offscreen->framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen->framebuffer);
+
+	glGenRenderbuffers(1, &offscreen->color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen->color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen->color_buffer);
+
+	glGenRenderbuffers(1, &offscreen->depth_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen->depth_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreen->depth_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR("Offscreen framebuffer is incomplete");
+		offscreen_release(offscreen);
+		return NULL;
+	}
+
+	glViewport(0, 0, width, height);
+	return offscreen;
+}
+
+void opengl_offscreen_destroy(OpenGLOffscreen *offscreen) {
+	if (offscreen)
+		offscreen_release(offscreen);
+}
+
+void opengl_offscreen_read_pixels(OpenGLOffscreen *offscreen, uint8_t *rgba) {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, offscreen->framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, offscreen->width, offscreen->height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+// Prefers a display that needs no window system at all, falls back to the default one
+EGLDisplay offscreen_get_display(void) {
+	const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (client_extensions && strstr(client_extensions, "EGL_MESA_platform_surfaceless")) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (get_platform_display) {
+			EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if (display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+void offscreen_release(OpenGLOffscreen *offscreen) {
+	if (offscreen->context != EGL_NO_CONTEXT && eglGetCurrentContext() == offscreen->context) {
+		glDeleteFramebuffers(1, &offscreen->framebuffer);
+		glDeleteRenderbuffers(1, &offscreen->color_buffer);
+		glDeleteRenderbuffers(1, &offscreen->depth_buffer);
+		eglMakeCurrent(offscreen->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+
+	if (offscreen->surface != EGL_NO_SURFACE)
+		eglDestroySurface(offscreen->display, offscreen->surface);
+	if (offscreen->context != EGL_NO_CONTEXT)
+		eglDestroyContext(offscreen->display, offscreen->context);
+	if (offscreen->display != EGL_NO_DISPLAY)
+		eglTerminate(offscreen->display);
+
+	free(offscreen);
+}
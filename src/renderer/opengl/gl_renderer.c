@@ -1,40 +1,100 @@
+#include "base.h"
 #include "renderer/gl_renderer.h"
+#include "gl_types.h"
 #include "renderer.h"
 
 #include <glad/gl.h>
 #include <stdlib.h>
 
-typedef struct _gl_renderer {
-	Renderer base;
-	uint32_t vao;
-} OpenGLRenderer;
+#define POOL_COUNT 5
+
+static const char *pool_names[POOL_COUNT] = { "buffer", "uniform buffer", "GPU timer", "texture", "texture load" };
+
+// Same order as pool_names
+static void opengl_renderer_pools(OpenGLRenderer *renderer, Pool *pools[POOL_COUNT]) {
+	pools[0] = renderer->buffer_pool;
+	pools[1] = renderer->uniform_buffer_pool;
+	pools[2] = renderer->timer_pool;
+	pools[3] = renderer->texture_pool;
+	pools[4] = renderer->texture_load_pool;
+}
 
 void opengl_on_resize(struct _renderer *self, int width, int height) {
 	glViewport(0, 0, width, height);
 }
 
+void opengl_get_stats(struct _renderer *self, RendererStats *stats) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	*stats = renderer->stats;
+
+	Pool *pools[POOL_COUNT];
+	opengl_renderer_pools(renderer, pools);
+	for (uint32_t i = 0; i < POOL_COUNT; i++) {
+		PoolStats pool_stats;
+		pool_get_stats(pools[i], &pool_stats);
+		stats->object_allocations += pool_stats.allocations;
+		stats->heap_allocations += pool_stats.heap_allocations;
+	}
+}
+
 Renderer *opengl_renderer_create() {
 	OpenGLRenderer *renderer = malloc(sizeof(OpenGLRenderer));
+	*renderer = (OpenGLRenderer){ 0 };
 	renderer->base.backend = BACKEND_API_OPENGL;
 
 	glGenVertexArrays(1, &renderer->vao);
 	glBindVertexArray(renderer->vao);
+	renderer->bound_vao = renderer->vao;
+	renderer->frame_index = OPENGL_FRAMES_IN_FLIGHT - 1; // The first frame_begin moves to region 0
+
+	// Every compressed texture path goes through the texture cache, texture_cache_set turns it down without S3TC
+	renderer->s3tc = GLAD_GL_EXT_texture_compression_s3tc;
+	if (!renderer->s3tc)
+		LOG_WARN("GL_EXT_texture_compression_s3tc isn't supported, textures will stay RGBA8");
+
+	renderer->buffer_pool = pool_create(sizeof(OpenGLBuffer), 64);
+	renderer->uniform_buffer_pool = pool_create(sizeof(OpenGLUniformBuffer), 8);
+	renderer->timer_pool = pool_create(sizeof(OpenGLGpuTimer), 16);
+	renderer->texture_pool = pool_create(sizeof(OpenGLTexture), 16);
+	renderer->texture_load_pool = pool_create(sizeof(OpenGLTextureLoad), 16);
 
 	// Drwa
 	renderer->base.draw = opengl_draw;
 	renderer->base.draw_indexed = opengl_draw_indexed;
+	renderer->base.draw_instanced = opengl_draw_instanced;
+	renderer->base.draw_indexed_instanced = opengl_draw_indexed_instanced;
 
 	renderer->base.on_resize = opengl_on_resize;
+	renderer->base.frame_begin = opengl_frame_begin;
+	renderer->base.frame_end = opengl_frame_end;
+	renderer->base.get_stats = opengl_get_stats;
 
 	// Buffer -----------------------------------------------------
 	renderer->base.buffer_create = opengl_buffer_create;
+	renderer->base.buffer_create_dynamic = opengl_buffer_create_dynamic;
+	renderer->base.buffer_map = opengl_buffer_map;
+	renderer->base.buffer_update = opengl_buffer_update;
 	renderer->base.buffer_destroy = opengl_buffer_destroy;
 	renderer->base.buffer_set_layout = opengl_buffer_set_layout;
 	renderer->base.buffer_activate = opengl_buffer_activate;
 	renderer->base.buffer_deactivate = opengl_buffer_deactivate;
 
+	renderer->base.uniform_buffer_create = opengl_uniform_buffer_create;
+	renderer->base.uniform_buffer_update = opengl_uniform_buffer_update;
+	renderer->base.uniform_buffer_destroy = opengl_uniform_buffer_destroy;
+
+	renderer->base.gpu_timer_create = opengl_gpu_timer_create;
+	renderer->base.gpu_timer_begin = opengl_gpu_timer_begin;
+	renderer->base.gpu_timer_end = opengl_gpu_timer_end;
+	renderer->base.gpu_timer_result = opengl_gpu_timer_result;
+	renderer->base.gpu_timer_destroy = opengl_gpu_timer_destroy;
+
 	// Shader -----------------------------------------------------
 	renderer->base.texture_load = opengl_texture_load;
+	renderer->base.texture_load_async = opengl_texture_load_async;
+	renderer->base.texture_stream = opengl_texture_stream;
+	renderer->base.texture_array_load_async = opengl_texture_array_load_async;
+	renderer->base.texture_cache_set = opengl_texture_cache_set;
 	renderer->base.texture_destroy = opengl_texture_destroy;
 	renderer->base.texture_activate = opengl_texture_activate;
 
@@ -53,9 +113,38 @@ Renderer *opengl_renderer_create() {
 	renderer->base.shader_set4fv = opengl_shader_set4fv;
 	renderer->base.shader_set4fm = opengl_shader_set4fm;
 
+	renderer->base.shader_uniform = opengl_shader_uniform;
+	renderer->base.shader_uniform_seti = opengl_shader_uniform_seti;
+	renderer->base.shader_uniform_setf = opengl_shader_uniform_setf;
+	renderer->base.shader_uniform_set2fv = opengl_shader_uniform_set2fv;
+	renderer->base.shader_uniform_set3fv = opengl_shader_uniform_set3fv;
+	renderer->base.shader_uniform_set4fv = opengl_shader_uniform_set4fv;
+	renderer->base.shader_uniform_set4fm = opengl_shader_uniform_set4fm;
+
 	return &renderer->base;
 }
 
 void opengl_renderer_destroy(Renderer *renderer) {
-	return;
+	OpenGLRenderer *gl_renderer = (OpenGLRenderer *)renderer;
+
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &gl_renderer->vao);
+
+	opengl_texture_loads_destroy(gl_renderer);
+
+	// Whatever is still live goes with its pool
+	Pool *pools[POOL_COUNT];
+	opengl_renderer_pools(gl_renderer, pools);
+	for (uint32_t i = 0; i < POOL_COUNT; i++) {
+		PoolStats stats;
+		pool_get_stats(pools[i], &stats);
+		if (stats.live)
+			LOG_WARN("%u %s(s) weren't destroyed before the renderer", stats.live, pool_names[i]);
+		pool_destroy(pools[i]);
+	}
+
+	for (uint32_t i = 0; i < OPENGL_FRAMES_IN_FLIGHT; i++) {
+		if (gl_renderer->frame_fences[i])
+			glDeleteSync(gl_renderer->frame_fences[i]);
+	}
 }
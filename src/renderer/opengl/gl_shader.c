@@ -6,6 +6,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+static void opengl_shader_reflect_uniforms(OpenGLShader *shader);
+static void opengl_shader_insert_uniform(OpenGLShader *shader, const char *name, uint32_t length, int32_t location);
+static int32_t opengl_shader_find_uniform(const OpenGLShader *shader, const char *name);
+static uint32_t uniform_name_hash(const char *name, uint32_t length);
+static uint32_t uniform_array_base_length(const char *name, int32_t length);
+
+// Shader entries don't receive the renderer, so every shader shares one pool. It's freed with the last shader
+static Pool *g_shader_pool = NULL;
+
 Shader *opengl_shader_from_file(const char *vertex_shader_path, const char *fragment_shader_path, const char *geometry_shader_path) {
 	// Vertex shader
 	FILE *file_ptr = fopen(vertex_shader_path, "r");
@@ -41,7 +50,6 @@ Shader *opengl_shader_from_file(const char *vertex_shader_path, const char *frag
 }
 
 Shader *opengl_shader_from_string(const char *vertex_shader_source, const char *fragment_shader_source, const char *geometry_shader_source) {
-	OpenGLShader *shader = malloc(sizeof(OpenGLShader));
 	uint32_t vertex_shader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertex_shader, 1, &vertex_shader_source, NULL);
 	glCompileShader(vertex_shader);
@@ -79,16 +87,35 @@ Shader *opengl_shader_from_string(const char *vertex_shader_source, const char *
 		return NULL;
 	}
 
-	shader->id = program;
+	if (g_shader_pool == NULL)
+		g_shader_pool = pool_create(sizeof(OpenGLShader), 16);
+
+	OpenGLShader *shader = pool_alloc(g_shader_pool, NULL);
+	*shader = (OpenGLShader){ .id = program };
 	glDeleteShader(vertex_shader);
 	glDeleteShader(fragment_shader);
 
+	opengl_shader_reflect_uniforms(shader);
+
+	// Shaders without an explicit layout(binding) still read the frame block from its fixed binding point
+	uint32_t frame_block = glGetUniformBlockIndex(program, FRAME_UNIFORMS_BLOCK);
+	if (frame_block != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, frame_block, FRAME_UNIFORM_BINDING);
+
 	return shader;
 }
 void opengl_shader_destroy(Shader *shader) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
 	glDeleteProgram(gl_shader->id);
-	free(shader);
+	arena_destroy(gl_shader->arena);
+	pool_free(g_shader_pool, gl_shader);
+
+	PoolStats stats;
+	pool_get_stats(g_shader_pool, &stats);
+	if (stats.live == 0) {
+		pool_destroy(g_shader_pool);
+		g_shader_pool = NULL;
+	}
 }
 
 void opengl_shader_activate(Shader *shader) {
@@ -101,25 +128,161 @@ void opengl_shader_deactivate(Shader *shader) {
 
 void opengl_shader_seti(Shader *shader, const char *name, int32_t value) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
-	glUniform1i(glGetUniformLocation(gl_shader->id, name), value);
+	glUniform1i(opengl_shader_find_uniform(gl_shader, name), value);
 }
 void opengl_shader_setf(Shader *shader, const char *name, float value) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
-	glUniform1f(glGetUniformLocation(gl_shader->id, name), value);
+	glUniform1f(opengl_shader_find_uniform(gl_shader, name), value);
 }
 void opengl_shader_set2fv(Shader *shader, const char *name, float *value) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
-	glUniform2fv(glGetUniformLocation(gl_shader->id, name), 1, value);
+	glUniform2fv(opengl_shader_find_uniform(gl_shader, name), 1, value);
 }
 void opengl_shader_set3fv(Shader *shader, const char *name, float *value) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
-	glUniform3fv(glGetUniformLocation(gl_shader->id, name), 1, value);
+	glUniform3fv(opengl_shader_find_uniform(gl_shader, name), 1, value);
 }
 void opengl_shader_set4fv(Shader *shader, const char *name, float *value) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
-	glUniform4fv(glGetUniformLocation(gl_shader->id, name), 1, value);
+	glUniform4fv(opengl_shader_find_uniform(gl_shader, name), 1, value);
 }
 void opengl_shader_set4fm(Shader *shader, const char *name, float *value) {
 	OpenGLShader *gl_shader = (OpenGLShader *)shader;
-	glUniformMatrix4fv(glGetUniformLocation(gl_shader->id, name), 1, GL_FALSE, value);
+	glUniformMatrix4fv(opengl_shader_find_uniform(gl_shader, name), 1, GL_FALSE, value);
+}
+
+Uniform opengl_shader_uniform(Shader *shader, const char *name) {
+	OpenGLShader *gl_shader = (OpenGLShader *)shader;
+	int32_t location = opengl_shader_find_uniform(gl_shader, name);
+	if (location < 0)
+		LOG_WARN("Shader %u has no active uniform %s", gl_shader->id, name);
+
+	return location < 0 ? UNIFORM_INVALID : location;
+}
+
+// Handles are the uniform locations, GL ignores writes to -1 just like it does for unknown names
+void opengl_shader_uniform_seti(Shader *shader, Uniform uniform, int32_t value) {
+	glUniform1i(uniform, value);
+}
+void opengl_shader_uniform_setf(Shader *shader, Uniform uniform, float value) {
+	glUniform1f(uniform, value);
+}
+void opengl_shader_uniform_set2fv(Shader *shader, Uniform uniform, float *value) {
+	glUniform2fv(uniform, 1, value);
+}
+void opengl_shader_uniform_set3fv(Shader *shader, Uniform uniform, float *value) {
+	glUniform3fv(uniform, 1, value);
+}
+void opengl_shader_uniform_set4fv(Shader *shader, Uniform uniform, float *value) {
+	glUniform4fv(uniform, 1, value);
+}
+void opengl_shader_uniform_set4fm(Shader *shader, Uniform uniform, float *value) {
+	glUniformMatrix4fv(uniform, 1, GL_FALSE, value);
+}
+
+void opengl_shader_reflect_uniforms(OpenGLShader *shader) {
+	int32_t uniform_count = 0, max_name_length = 0;
+	glGetProgramiv(shader->id, GL_ACTIVE_UNIFORMS, &uniform_count);
+	glGetProgramiv(shader->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+	// Arrays take one slot per element plus one for the bare name, so count exactly what the loop below inserts first
+	char name[max_name_length + 16];
+	uint32_t entry_count = 0;
+	for (int32_t i = 0; i < uniform_count; i++) {
+		int32_t size, length;
+		uint32_t type;
+		glGetActiveUniform(shader->id, i, max_name_length, &length, &size, &type, name);
+		if (glGetUniformLocation(shader->id, name) >= 0)
+			entry_count += uniform_array_base_length(name, length) ? size + 1 : 1;
+	}
+
+	if (entry_count == 0)
+		return;
+
+	// Keep the table at most half full so probe sequences stay short
+	shader->uniform_capacity = 16;
+	while (shader->uniform_capacity < entry_count * 2)
+		shader->uniform_capacity *= 2;
+
+	// The table and every name fit in the first block, so a shader costs one allocation however many uniforms it has
+	size_t table_size = sizeof(OpenGLUniform) * shader->uniform_capacity;
+	shader->arena = arena_create(table_size + (size_t)entry_count * (max_name_length + 16 + 16));
+	shader->uniforms = arena_alloc(shader->arena, table_size);
+	memset(shader->uniforms, 0, table_size);
+
+	for (int32_t i = 0; i < uniform_count; i++) {
+		int32_t size, length;
+		uint32_t type;
+		glGetActiveUniform(shader->id, i, max_name_length, &length, &size, &type, name);
+
+		// Block members have no location, they are set through their buffer
+		int32_t location = glGetUniformLocation(shader->id, name);
+		if (location < 0)
+			continue;
+
+		// Arrays are reported as "name[0]", register the bare name and every element. Struct array members such as
+		// "lights[0].color" are reported one by one under their full name
+		uint32_t base_length = uniform_array_base_length(name, length);
+		if (base_length == 0) {
+			opengl_shader_insert_uniform(shader, name, length, location);
+			continue;
+		}
+
+		opengl_shader_insert_uniform(shader, name, base_length, location);
+		for (int32_t element = 0; element < size; element++) {
+			int32_t element_length = base_length + sprintf(name + base_length, "[%d]", element);
+			opengl_shader_insert_uniform(shader, name, element_length, glGetUniformLocation(shader->id, name));
+		}
+	}
+
+	LOG_DEBUG("Shader %u reflected %d active uniform(s)", shader->id, uniform_count);
+}
+
+void opengl_shader_insert_uniform(OpenGLShader *shader, const char *name, uint32_t length, int32_t location) {
+	uint32_t hash = uniform_name_hash(name, length);
+	uint32_t mask = shader->uniform_capacity - 1;
+
+	uint32_t slot = hash & mask;
+	while (shader->uniforms[slot].name)
+		slot = (slot + 1) & mask;
+
+	OpenGLUniform *uniform = &shader->uniforms[slot];
+	uniform->name = arena_alloc(shader->arena, length + 1);
+	memcpy(uniform->name, name, length);
+	uniform->name[length] = '\0';
+	uniform->hash = hash;
+	uniform->location = location;
+}
+
+int32_t opengl_shader_find_uniform(const OpenGLShader *shader, const char *name) {
+	if (shader->uniform_capacity == 0)
+		return -1;
+
+	uint32_t hash = uniform_name_hash(name, (uint32_t)strlen(name));
+	uint32_t mask = shader->uniform_capacity - 1;
+
+	for (uint32_t slot = hash & mask; shader->uniforms[slot].name; slot = (slot + 1) & mask) {
+		const OpenGLUniform *uniform = &shader->uniforms[slot];
+		if (uniform->hash == hash && strcmp(uniform->name, name) == 0)
+			return uniform->location;
+	}
+
+	return -1;
+}
+
+// FNV-1a
+uint32_t uniform_name_hash(const char *name, uint32_t length) {
+	uint32_t hash = 2166136261u;
+	for (uint32_t i = 0; i < length; i++) {
+		hash ^= (uint8_t)name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Length of name without its "[0]" suffix, 0 if it isn't an array
+uint32_t uniform_array_base_length(const char *name, int32_t length) {
+	if (length < 4 || strcmp(name + length - 3, "[0]") != 0)
+		return 0;
+	return (uint32_t)length - 3;
 }
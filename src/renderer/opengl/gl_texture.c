@@ -1,48 +1,183 @@
 #include "base.h"
+#include "base/clock.h"
+#include "base/darray.h"
+#include "base/file.h"
 #include "gl_types.h"
 
 #include <glad/gl.h>
 #include <stb/stb_image.h>
 #include <stdlib.h>
+#include <string.h>
 
-Texture *opengl_texture_load(struct _renderer *self, const char *texture_path) {
-	OpenGLTexture *texture = malloc(sizeof(OpenGLTexture));
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT	 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
 
-	glGenTextures(1, &texture->id);
+static const uint8_t placeholder_pixel[4] = { 128, 128, 128, 255 };
+static const uint8_t missing_pixel[4] = { 255, 0, 255, 255 };
 
-	// First texture
-	glBindTexture(GL_TEXTURE_2D, texture->id);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+static OpenGLTexture *opengl_texture_create(OpenGLRenderer *renderer, const uint8_t pixel[4]);
+static void opengl_texture_upload(OpenGLTexture *texture, const void *pixels, int32_t width, int32_t height, int32_t channel_count);
+static void opengl_texture_upload_load(OpenGLRenderer *renderer, OpenGLTextureLoad *load);
+static void opengl_texture_upload_cooked(OpenGLTexture *texture, const CookedTexture *cooked, uint32_t layer);
+static void opengl_texture_array_fill(OpenGLTexture *texture, uint32_t first_layer, uint32_t layer_count, const uint8_t rgba[4]);
+static GLenum texture_format_to_gl(TextureFormat format);
+static void opengl_texture_queue_load(OpenGLRenderer *renderer, JobSystem *jobs, OpenGLTexture *texture, const char *path, uint32_t layer);
+static void texture_load_free(OpenGLRenderer *renderer, OpenGLTextureLoad *load);
+static void texture_decode(void *user_data, uint32_t index);
+static void texture_decode_pixels(OpenGLTextureLoad *load, int32_t channel_count);
 
+Texture *opengl_texture_load(struct _renderer *self, const char *texture_path) {
 	stbi_set_flip_vertically_on_load(true);
 
 	int32_t width, height, channel_count;
 	uint8_t *data = stbi_load(texture_path, &width, &height, &channel_count, 0);
 	if (!data) {
 		LOG_ERROR("Texture path [ %s ] not found", texture_path);
-		exit(1);
+		return NULL;
 	}
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, channel_count == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
+	OpenGLTexture *texture = opengl_texture_create((OpenGLRenderer *)self, placeholder_pixel);
+	opengl_texture_upload(texture, data, width, height, channel_count);
 	stbi_image_free(data);
 
-	texture->width = width;
-	texture->height = height;
-	texture->channels = channel_count;
+	((OpenGLRenderer *)self)->stats.bytes_uploaded += (uint64_t)width * height * channel_count;
+	texture->path = texture_path;
+	return texture;
+}
+
+Texture *opengl_texture_load_async(struct _renderer *self, JobSystem *jobs, const char *texture_path) {
+	OpenGLTexture *texture = opengl_texture_create((OpenGLRenderer *)self, placeholder_pixel);
+
 	texture->path = texture_path;
+	opengl_texture_queue_load((OpenGLRenderer *)self, jobs, texture, texture_path, 0);
 	return texture;
 }
+
+void opengl_texture_cache_set(struct _renderer *self, const char *directory) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+
+	free(renderer->texture_cache_directory);
+	renderer->texture_cache_directory = NULL;
+	if (directory == NULL)
+		return;
+
+	if (!renderer->s3tc) {
+		LOG_WARN("Can't use texture cache [ %s ] without S3TC support, textures won't be cooked", directory);
+		return;
+	}
+	if (!file_create_directories(directory)) {
+		LOG_WARN("Can't create texture cache [ %s ], textures won't be cooked", directory);
+		return;
+	}
+	size_t size = strlen(directory) + 1;
+	renderer->texture_cache_directory = malloc(size);
+	memcpy(renderer->texture_cache_directory, directory, size);
+}
+
+Texture *opengl_texture_array_load_async(struct _renderer *self, JobSystem *jobs, const char **paths, uint32_t layer_count, uint32_t width, uint32_t height) {
+	if (paths == NULL || layer_count == 0 || width == 0 || height == 0) {
+		LOG_ERROR("Invalid arguments passed to texture_array_load_async!");
+		return NULL;
+	}
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+
+	// The storage format is fixed up front, so with a cache every layer is cooked to BC3
+	TextureFormat format = TEXTURE_FORMAT_RGBA8;
+	if (renderer->texture_cache_directory && width % 4 == 0 && height % 4 == 0)
+		format = TEXTURE_FORMAT_BC3;
+
+	OpenGLTexture *texture = pool_alloc(renderer->texture_pool, NULL);
+	*texture = (OpenGLTexture){ .target = GL_TEXTURE_2D_ARRAY, .width = width, .height = height, .channels = 4, .layer_count = layer_count, .format = format };
+
+	uint32_t largest = width > height ? width : height, level_count = 1;
+	while ((largest >> level_count) > 0)
+		level_count++;
+
+	glGenTextures(1, &texture->id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, level_count, texture_format_to_gl(format), width, height, layer_count);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	// Layers read as the placeholder until their image arrives
+	opengl_texture_array_fill(texture, 0, layer_count, placeholder_pixel);
+
+	for (uint32_t layer = 0; layer < layer_count; layer++)
+		opengl_texture_queue_load(renderer, jobs, texture, paths[layer], layer);
+
+	return texture;
+}
+
+uint32_t opengl_texture_stream(struct _renderer *self, double budget_seconds) {
+	OpenGLRenderer *renderer = (OpenGLRenderer *)self;
+	if (renderer->texture_loads == NULL)
+		return 0;
+
+	double start = clock_seconds();
+	uint32_t uploads = 0;
+
+	for (uint32_t i = 0; i < darray_length(renderer->texture_loads);) {
+		OpenGLTextureLoad *load = renderer->texture_loads[i];
+		if (!job_system_is_done(&load->counter) || (uploads > 0 && clock_seconds() - start >= budget_seconds)) {
+			i++;
+			continue;
+		}
+
+		OpenGLTexture *texture = load->texture;
+		if (texture) {
+			opengl_texture_upload_load(renderer, load);
+			uploads++;
+
+			// Uncompressed arrays rebuild their mipmaps once, after the last layer
+			if (--texture->pending_loads == 0 && texture->target == GL_TEXTURE_2D_ARRAY && texture->format == TEXTURE_FORMAT_RGBA8) {
+				glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+				glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			}
+		}
+
+		texture_load_free(renderer, load);
+		darray_remove(renderer->texture_loads, i);
+	}
+
+	return darray_length(renderer->texture_loads);
+}
+
+void opengl_texture_loads_destroy(OpenGLRenderer *renderer) {
+	// The load list only exists once a texture was loaded asynchronously, the cache directory and upload buffer don't depend on it
+	if (renderer->texture_loads) {
+		for (uint32_t i = 0; i < darray_length(renderer->texture_loads); i++) {
+			OpenGLTextureLoad *load = renderer->texture_loads[i];
+			job_system_wait(load->jobs, &load->counter);
+			texture_load_free(renderer, load);
+		}
+		darray_free(renderer->texture_loads);
+	}
+
+	if (renderer->upload_buffer)
+		glDeleteBuffers(1, &renderer->upload_buffer);
+	free(renderer->texture_cache_directory);
+}
+
 void opengl_texture_destroy(struct _renderer *self, Texture *texture) {
 	if (texture) {
+		OpenGLRenderer *renderer = (OpenGLRenderer *)self;
 		OpenGLTexture *gl_texture = (OpenGLTexture *)texture;
+
+		// Decode jobs may still be running, texture_stream frees their loads once they're done
+		for (uint32_t i = 0; gl_texture->pending_loads && i < darray_length(renderer->texture_loads); i++) {
+			if (renderer->texture_loads[i]->texture == gl_texture) {
+				renderer->texture_loads[i]->texture = NULL;
+				gl_texture->pending_loads--;
+			}
+		}
+
 		glDeleteTextures(1, &gl_texture->id);
-		free(texture);
+		pool_free(renderer->texture_pool, gl_texture);
 	}
 }
 
@@ -52,7 +187,267 @@ void opengl_texture_activate(struct _renderer *self, Texture *texture, uint32_t
 		exit(1);
 	}
 	OpenGLTexture *gl_texture = (OpenGLTexture *)texture;
+	((OpenGLRenderer *)self)->stats.texture_binds++;
 
 	glActiveTexture(GL_TEXTURE0 + texture_unit);
-	glBindTexture(GL_TEXTURE_2D, gl_texture->id);
+	glBindTexture(gl_texture->target, gl_texture->id);
+}
+
+// A texture holding a single pixel, the real image replaces it in place
+OpenGLTexture *opengl_texture_create(OpenGLRenderer *renderer, const uint8_t pixel[4]) {
+	OpenGLTexture *texture = pool_alloc(renderer->texture_pool, NULL);
+	*texture = (OpenGLTexture){ .target = GL_TEXTURE_2D, .layer_count = 1 };
+
+	glGenTextures(1, &texture->id);
+	glBindTexture(GL_TEXTURE_2D, texture->id);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	opengl_texture_upload(texture, pixel, 1, 1, 4);
+	return texture;
+}
+
+// Respecifies the image of a 2D texture and rebuilds its mipmaps, pixels is an offset into the bound unpack buffer if there is one
+void opengl_texture_upload(OpenGLTexture *texture, const void *pixels, int32_t width, int32_t height, int32_t channel_count) {
+	glBindTexture(GL_TEXTURE_2D, texture->id);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, channel_count == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	texture->width = width;
+	texture->height = height;
+	texture->channels = channel_count;
+}
+
+// Moves a decoded image into its texture (or array layer) through the unpack buffer
+void opengl_texture_upload_load(OpenGLRenderer *renderer, OpenGLTextureLoad *load) {
+	OpenGLTexture *texture = load->texture;
+
+	if (load->cooked.mapping) {
+		opengl_texture_upload_cooked(texture, &load->cooked, load->layer);
+		for (uint32_t level = 0; level < load->cooked.level_count; level++)
+			renderer->stats.bytes_uploaded += load->cooked.level_sizes[level];
+		return;
+	}
+
+	// Compressed arrays can only take cooked layers
+	if (load->pixels == NULL || (texture->target == GL_TEXTURE_2D_ARRAY && texture->format != TEXTURE_FORMAT_RGBA8)) {
+		if (load->pixels == NULL)
+			LOG_ERROR("Texture path [ %s ] not found", load->path);
+		else
+			LOG_ERROR("Texture [ %s ] couldn't be compressed for its array layer", load->path);
+		if (texture->target == GL_TEXTURE_2D_ARRAY)
+			opengl_texture_array_fill(texture, load->layer, 1, missing_pixel);
+		else
+			opengl_texture_upload(texture, missing_pixel, 1, 1, 4);
+		return;
+	}
+
+	// Copy into the unpack buffer, orphaned first so this never waits on an upload still in flight
+	size_t size = (size_t)load->width * load->height * load->channels;
+	if (renderer->upload_buffer == 0)
+		glGenBuffers(1, &renderer->upload_buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, renderer->upload_buffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+	const void *source = NULL;
+	void *staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (staging) {
+		memcpy(staging, load->pixels, size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		source = load->pixels;
+	}
+
+	if (texture->target == GL_TEXTURE_2D_ARRAY) {
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, load->layer, load->width, load->height, 1, GL_RGBA, GL_UNSIGNED_BYTE, source);
+	} else {
+		opengl_texture_upload(texture, source, load->width, load->height, load->channels);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	renderer->stats.bytes_uploaded += size;
+}
+
+// Mip levels of a cooked texture, straight from the mapped file
+void opengl_texture_upload_cooked(OpenGLTexture *texture, const CookedTexture *cooked, uint32_t layer) {
+	GLenum format = texture_format_to_gl(cooked->format);
+	uint32_t width = cooked->width, height = cooked->height;
+
+	glBindTexture(texture->target, texture->id);
+	for (uint32_t level = 0; level < cooked->level_count; level++) {
+		if (texture->target == GL_TEXTURE_2D_ARRAY)
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, format, cooked->level_sizes[level], cooked->levels[level]);
+		else
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, cooked->level_sizes[level], cooked->levels[level]);
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	if (texture->target == GL_TEXTURE_2D) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked->level_count - 1);
+		texture->width = cooked->width;
+		texture->height = cooked->height;
+		texture->channels = 4;
+	}
+}
+
+// Sets every mip level of the given layers to a single colour
+void opengl_texture_array_fill(OpenGLTexture *texture, uint32_t first_layer, uint32_t layer_count, const uint8_t rgba[4]) {
+	uint32_t width = texture->width, height = texture->height;
+	uint8_t *blocks = NULL;
+	if (texture->format != TEXTURE_FORMAT_RGBA8) {
+		uint8_t block[16];
+		uint32_t block_size = texture->format == TEXTURE_FORMAT_BC1 ? 8 : 16;
+		uint32_t block_count = texture_block_level_size(texture->format, width, height) / block_size * layer_count;
+
+		texture_block_solid(texture->format, rgba, block);
+		blocks = malloc((size_t)block_count * block_size);
+		for (uint32_t i = 0; i < block_count; i++)
+			memcpy(blocks + (size_t)i * block_size, block, block_size);
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+	for (uint32_t level = 0; width > 0 && height > 0; level++) {
+		if (blocks) {
+			uint32_t size = texture_block_level_size(texture->format, width, height) * layer_count;
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, first_layer, width, height, layer_count, texture_format_to_gl(texture->format), size, blocks);
+		} else {
+			glClearTexSubImage(texture->id, level, 0, 0, first_layer, width, height, layer_count, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+		}
+
+		if (width == 1 && height == 1)
+			break;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	free(blocks);
+}
+
+void opengl_texture_queue_load(OpenGLRenderer *renderer, JobSystem *jobs, OpenGLTexture *texture, const char *path, uint32_t layer) {
+	OpenGLTextureLoad *load = pool_alloc(renderer->texture_load_pool, NULL);
+
+	*load = (OpenGLTextureLoad){ .texture = texture, .path = path, .layer = layer, .jobs = jobs };
+	if (texture->target == GL_TEXTURE_2D_ARRAY) {
+		load->target_width = texture->width;
+		load->target_height = texture->height;
+		load->format = texture->format;
+	}
+	if (renderer->texture_cache_directory && (texture->target == GL_TEXTURE_2D || texture->format != TEXTURE_FORMAT_RGBA8))
+		texture_cache_path(renderer->texture_cache_directory, path, load->target_width, load->target_height, load->cache_path, sizeof(load->cache_path));
+	texture->pending_loads++;
+
+	if (renderer->texture_loads == NULL)
+		renderer->texture_loads = darray_create(sizeof(OpenGLTextureLoad *), 16);
+	darray_push(renderer->texture_loads, load);
+
+	// stbi's flip flag is process wide, set it here so the decode jobs only ever read it
+	stbi_set_flip_vertically_on_load(true);
+	job_system_dispatch(jobs, 1, texture_decode, load, &load->counter);
+}
+
+void texture_load_free(OpenGLRenderer *renderer, OpenGLTextureLoad *load) {
+	cooked_texture_unmap(&load->cooked);
+	if (load->resized)
+		free(load->pixels);
+	else
+		stbi_image_free(load->pixels);
+	pool_free(renderer->texture_load_pool, load);
+}
+
+// Runs on a worker, the decoded pixels (or the mapped cache file) stay in the load until texture_stream uploads them
+void texture_decode(void *user_data, uint32_t index) {
+	OpenGLTextureLoad *load = user_data;
+	if (load->cache_path[0] == '\0') {
+		texture_decode_pixels(load, load->target_width ? 4 : 0);
+		return;
+	}
+
+	// A cached layer has to match the array it goes into
+	if (texture_cache_is_fresh(load->cache_path, load->path) && cooked_texture_map(load->cache_path, &load->cooked)) {
+		if (load->target_width == 0 || (load->cooked.width == (uint32_t)load->target_width && load->cooked.height == (uint32_t)load->target_height &&
+										load->cooked.format == load->format))
+			return;
+		cooked_texture_unmap(&load->cooked);
+	}
+
+	texture_decode_pixels(load, 4);
+	if (load->pixels == NULL || load->width % 4 != 0 || load->height % 4 != 0)
+		return;
+
+	TextureFormat format = load->format != TEXTURE_FORMAT_RGBA8 ? load->format : texture_cook_format(load->pixels, load->width, load->height);
+	bool cooked = texture_cook(load->pixels, load->width, load->height, format, load->cache_path) && cooked_texture_map(load->cache_path, &load->cooked);
+
+	// 2D textures fall back to their pixels, but a compressed array only takes compressed layers
+	if (!cooked && load->format != TEXTURE_FORMAT_RGBA8) {
+		LOG_WARN("Can't cook [ %s ] into the texture cache as [ %s ], compressing it in memory", load->path, load->cache_path);
+		size_t size;
+		uint8_t *data = texture_compress(load->pixels, load->width, load->height, format, &size);
+		cooked = data && cooked_texture_from_memory(data, size, &load->cooked);
+	}
+
+	if (cooked) {
+		if (load->resized)
+			free(load->pixels);
+		else
+			stbi_image_free(load->pixels);
+		load->pixels = NULL;
+		load->resized = false;
+	}
+}
+
+// Array layers (and loads for the cache) are decoded to RGBA, layers are also resized (nearest) to the layer size
+void texture_decode_pixels(OpenGLTextureLoad *load, int32_t channel_count) {
+	if (load->target_width == 0) {
+		load->pixels = stbi_load(load->path, &load->width, &load->height, &load->channels, channel_count);
+		if (channel_count)
+			load->channels = channel_count;
+		return;
+	}
+
+	int32_t width, height, file_channel_count;
+	uint8_t *pixels = stbi_load(load->path, &width, &height, &file_channel_count, 4);
+	load->channels = 4;
+	if (pixels == NULL || (width == load->target_width && height == load->target_height)) {
+		load->pixels = pixels;
+		load->width = width;
+		load->height = height;
+		return;
+	}
+
+	uint32_t *resized = malloc(sizeof(uint32_t) * load->target_width * load->target_height);
+	for (int32_t y = 0; y < load->target_height; y++) {
+		const uint32_t *row = (const uint32_t *)pixels + (size_t)(y * height / load->target_height) * width;
+		for (int32_t x = 0; x < load->target_width; x++)
+			resized[y * load->target_width + x] = row[x * width / load->target_width];
+	}
+	stbi_image_free(pixels);
+
+	load->pixels = (uint8_t *)resized;
+	load->resized = true;
+	load->width = load->target_width;
+	load->height = load->target_height;
+}
+
+GLenum texture_format_to_gl(TextureFormat format) {
+	switch (format) {
+		case TEXTURE_FORMAT_RGBA8:
+			return GL_RGBA8;
+		case TEXTURE_FORMAT_BC1:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TEXTURE_FORMAT_BC3:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		default: {
+			LOG_ERROR("Unknown texture format provided!");
+			return 0;
+		} break;
+	}
 }
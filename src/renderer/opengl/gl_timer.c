@@ -0,0 +1,51 @@
+#include "base.h"
+#include "gl_types.h"
+
+#include <glad/gl.h>
+#include <stdlib.h>
+
+GpuTimer *opengl_gpu_timer_create(struct _renderer *self) {
+	OpenGLGpuTimer *timer = pool_alloc(((OpenGLRenderer *)self)->timer_pool, NULL);
+	*timer = (OpenGLGpuTimer){ 0 };
+
+	glGenQueries(1, &timer->query);
+	return timer;
+}
+
+void opengl_gpu_timer_begin(struct _renderer *self, GpuTimer *timer) {
+	OpenGLGpuTimer *gl_timer = (OpenGLGpuTimer *)timer;
+
+	// Restarting a query whose result wasn't read drops that result
+	gl_timer->pending = false;
+	glBeginQuery(GL_TIME_ELAPSED, gl_timer->query);
+}
+
+void opengl_gpu_timer_end(struct _renderer *self, GpuTimer *timer) {
+	glEndQuery(GL_TIME_ELAPSED);
+	((OpenGLGpuTimer *)timer)->pending = true;
+}
+
+bool opengl_gpu_timer_result(struct _renderer *self, GpuTimer *timer, uint64_t *nanoseconds) {
+	OpenGLGpuTimer *gl_timer = (OpenGLGpuTimer *)timer;
+	if (!gl_timer->pending)
+		return false;
+
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(gl_timer->query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+
+	GLuint64 elapsed;
+	glGetQueryObjectui64v(gl_timer->query, GL_QUERY_RESULT, &elapsed);
+	gl_timer->pending = false;
+
+	*nanoseconds = elapsed;
+	return true;
+}
+
+void opengl_gpu_timer_destroy(struct _renderer *self, GpuTimer *timer) {
+	if (timer) {
+		glDeleteQueries(1, &((OpenGLGpuTimer *)timer)->query);
+		pool_free(((OpenGLRenderer *)self)->timer_pool, timer);
+	}
+}
@@ -1,30 +1,110 @@
 #pragma once
+#include "base/arena.h"
+#include "base/pool.h"
 #include "renderer/gl_renderer.h"
+#include "renderer/texture_cache.h"
+
+#define OPENGL_FRAMES_IN_FLIGHT		 3 // Regions per dynamic buffer
+#define OPENGL_MAX_VERTEX_ATTRIBUTES 16 // GL_MAX_VERTEX_ATTRIBS is at least this, vertex and instance layouts share it
+
+typedef struct _gl_renderer {
+	Renderer base;
+	uint32_t vao; // Default vertex array, bound outside of draws so index buffer binds never land in a buffer's vertex array
+	uint32_t bound_vao;
+	uint32_t buffer_serial; // Incremented per created buffer, GL may recycle the ids of destroyed ones
+
+	uint32_t frame_index; // Region of the dynamic buffers used by the current frame
+	void *frame_fences[OPENGL_FRAMES_IN_FLIGHT]; // GLsync per region, signaled once the GPU is done with the frame
+
+	RendererStats stats;
+
+	struct _gl_texture_load **texture_loads; // darray of the async loads that weren't uploaded yet
+	uint32_t upload_buffer; // Pixel unpack buffer async uploads stream through
+	char *texture_cache_directory; // NULL if async loads aren't cooked
+	bool s3tc; // GL_EXT_texture_compression_s3tc is supported, cooked BC1/BC3 textures need it
+
+	// Resource objects come from pools, so streaming chunks and textures in and out doesn't go through malloc
+	Pool *buffer_pool, *uniform_buffer_pool, *timer_pool, *texture_pool, *texture_load_pool;
+} OpenGLRenderer;
+
+typedef struct {
+	char *name; // NULL for an empty slot
+	uint32_t hash;
+	int32_t location;
+} OpenGLUniform;
 
 typedef struct _gl_shader {
 	uint32_t id; // Shader program id
-	int32_t *locations; // TODO: Use this
+	Arena *arena; // Holds the uniform table and its names, NULL if the program has no active uniforms
+	OpenGLUniform *uniforms; // Open addressed name -> location table of the active uniforms, reflected at link time
+	uint32_t uniform_capacity; // Power of two
 } OpenGLShader;
 
 typedef struct _gl_vertex_attribute {
 	const char *name;
 	AttributeFormat format;
 	uint32_t location, offset;
+	uint32_t divisor;
 } OpenGLVertexAttribute;
 
 typedef struct {
-	OpenGLVertexAttribute *attributes;
-	uint32_t count, stride;
+	OpenGLVertexAttribute attributes[OPENGL_MAX_VERTEX_ATTRIBUTES];
+	uint32_t count, stride; // count is 0 until buffer_set_layout
 } OpenGLVertexLayout;
 
 typedef struct _gl_buffer {
 	uint32_t id, type; // Buffer id
+	uint32_t index_type; // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT for index buffers
+	uint32_t serial;
+	size_t size; // Bytes, per region for dynamic buffers
+	bool dynamic;
+	uint8_t *mapped; // Persistent mapping of all OPENGL_FRAMES_IN_FLIGHT regions of a dynamic buffer
 	uint32_t vertex_count, triangle_count;
 	OpenGLVertexLayout layout;
+
+	uint32_t vao; // Vertex array with the layout baked in, built by buffer_set_layout
+	uint32_t element_serial; // Serial of the index buffer bound to vao, 0 if none
+	uint32_t instance_serial; // Serial of the instance buffer attached to vao, 0 if none
+	uint32_t instance_attribute_count;
 } OpenGLBuffer;
 
+typedef struct _gl_uniform_buffer {
+	uint32_t id;
+	uint32_t binding;
+	size_t size;
+} OpenGLUniformBuffer;
+
+typedef struct _gl_gpu_timer {
+	uint32_t query; // GL_TIME_ELAPSED query
+	bool pending; // Ended but its result wasn't read yet
+} OpenGLGpuTimer;
+
 typedef struct _gl_texture {
 	uint32_t id;
+	uint32_t target; // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
 	uint32_t width, height, channels;
+	uint32_t layer_count; // 1 unless it's an array
+	TextureFormat format; // Storage format of arrays, 2D textures are respecified per load
 	const char *path;
+	uint32_t pending_loads; // Async loads of this texture that weren't uploaded yet
 } OpenGLTexture;
+
+typedef struct _gl_texture_load {
+	OpenGLTexture *texture; // NULL if the texture was destroyed before the load finished
+	const char *path;
+	uint32_t layer; // Array layer the image goes to
+	int32_t target_width, target_height; // Array layer size the image is resized to, 0 keeps the image size
+	TextureFormat format; // Cooked format the array layer needs, TEXTURE_FORMAT_RGBA8 lets the cook pick
+	char cache_path[256]; // Empty if the load isn't cooked
+	JobSystem *jobs;
+	JobCounter counter;
+
+	// Written by the decode job, read once counter is done
+	uint8_t *pixels;
+	bool resized; // pixels came from malloc rather than stbi
+	int32_t width, height, channels;
+	CookedTexture cooked; // Mapped cache file, replaces pixels when its mapping is set
+} OpenGLTextureLoad;
+
+// Waits for the decode jobs still running and frees every pending load
+void opengl_texture_loads_destroy(OpenGLRenderer *renderer);
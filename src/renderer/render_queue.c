@@ -0,0 +1,233 @@
+#include "base.h"
+#include "base/darray.h"
+#include "renderer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Sort key, most significant first:
+ * | pass 4 | shader 12 | texture 12 | depth 24 | vertex buffer 12 |
+ */
+#define SORT_ID_BITS		  12
+#define SORT_ID_LIMIT		  (1u << SORT_ID_BITS)
+#define SORT_ID_TABLE_SIZE	  (SORT_ID_LIMIT * 2) // Kept at most half full
+#define SORT_DEPTH_BITS		  24
+#define SORT_DEPTH_MAX		  ((1u << SORT_DEPTH_BITS) - 1)
+#define SORT_SHIFT_PASS		  60
+#define SORT_SHIFT_SHADER	  48
+#define SORT_SHIFT_TEXTURE	  36
+#define SORT_SHIFT_DEPTH	  12
+#define SORT_SHIFT_BUFFER	  0
+
+// Hands out small ids for pointers so they fit a sort key field, ids stay stable between frames
+typedef struct {
+	const void *pointers[SORT_ID_TABLE_SIZE];
+	uint16_t ids[SORT_ID_TABLE_SIZE];
+	uint32_t count;
+} SortIdTable;
+
+struct _render_queue {
+	Renderer *renderer;
+	float depth_range;
+
+	RenderPacket *packets; // darray, emptied by every submit
+
+	// Sort scratch, sized for the packet count
+	uint64_t *keys, *keys_scratch;
+	uint32_t *order, *order_scratch;
+	uint32_t capacity;
+
+	SortIdTable shader_ids, texture_ids, buffer_ids;
+};
+
+static uint64_t render_queue_sort_key(RenderQueue *queue, const RenderPacket *packet);
+static uint32_t sort_id(SortIdTable *table, const void *pointer);
+static const uint32_t *radix_sort(uint64_t *keys, uint32_t *order, uint64_t *keys_scratch, uint32_t *order_scratch, uint32_t count);
+
+RenderQueue *render_queue_create(Renderer *renderer, float depth_range) {
+	RenderQueue *queue = malloc(sizeof(RenderQueue));
+
+	memset(queue, 0, sizeof(RenderQueue));
+	queue->renderer = renderer;
+	queue->depth_range = depth_range;
+	queue->packets = darray_create(sizeof(RenderPacket), 256);
+
+	return queue;
+}
+
+void render_queue_destroy(RenderQueue *queue) {
+	if (queue == NULL)
+		return;
+
+	darray_free(queue->packets);
+	free(queue->keys);
+	free(queue->keys_scratch);
+	free(queue->order);
+	free(queue->order_scratch);
+	free(queue);
+}
+
+void render_queue_push(RenderQueue *queue, const RenderPacket *packet) {
+	if (packet->vertex_buffer == NULL) {
+		LOG_ERROR("Can't queue a packet without vertex buffer!");
+		return;
+	}
+
+	RenderPacket copy = *packet;
+	darray_push(queue->packets, copy);
+}
+
+void render_queue_submit(RenderQueue *queue, RenderQueueStats *stats) {
+	Renderer *renderer = queue->renderer;
+	uint32_t packet_count = darray_length(queue->packets);
+	RenderQueueStats frame_stats = { .packets = packet_count };
+
+	if (packet_count > queue->capacity) {
+		queue->capacity = packet_count * 2;
+		queue->keys = realloc(queue->keys, sizeof(uint64_t) * queue->capacity);
+		queue->keys_scratch = realloc(queue->keys_scratch, sizeof(uint64_t) * queue->capacity);
+		queue->order = realloc(queue->order, sizeof(uint32_t) * queue->capacity);
+		queue->order_scratch = realloc(queue->order_scratch, sizeof(uint32_t) * queue->capacity);
+	}
+
+	for (uint32_t i = 0; i < packet_count; i++) {
+		queue->keys[i] = render_queue_sort_key(queue, &queue->packets[i]);
+		queue->order[i] = i;
+	}
+	const uint32_t *order = radix_sort(queue->keys, queue->order, queue->keys_scratch, queue->order_scratch, packet_count);
+
+	// Nothing is known about the bound state going in, so the first packet binds everything it uses
+	Shader *shader = NULL;
+	Texture *textures[RENDER_QUEUE_TEXTURE_UNITS] = { 0 };
+
+	// The backend binds buffers inside the draw call and skips the bind itself when they're unchanged, so its own
+	// counter is read around the loop instead of guessing from adjacent packets
+	RendererStats backend_stats;
+	renderer->get_stats(renderer, &backend_stats);
+	uint64_t buffer_binds = backend_stats.buffer_binds;
+
+	for (uint32_t i = 0; i < packet_count; i++) {
+		const RenderPacket *packet = &queue->packets[order[i]];
+
+		if (packet->shader != shader) {
+			renderer->shader_activate(packet->shader);
+			shader = packet->shader;
+			frame_stats.shader_binds++;
+		} else {
+			frame_stats.shader_binds_skipped++;
+		}
+
+		for (uint32_t unit = 0; unit < RENDER_QUEUE_TEXTURE_UNITS; unit++) {
+			if (packet->textures[unit] == NULL)
+				continue;
+
+			if (packet->textures[unit] != textures[unit]) {
+				renderer->texture_activate(renderer, packet->textures[unit], unit);
+				textures[unit] = packet->textures[unit];
+				frame_stats.texture_binds++;
+			} else {
+				frame_stats.texture_binds_skipped++;
+			}
+		}
+
+		if (packet->model && packet->model_uniform != UNIFORM_INVALID)
+			renderer->shader_uniform_set4fm(packet->shader, packet->model_uniform, (float *)packet->model);
+
+		if (packet->instance_count == 0) {
+			if (packet->index_buffer)
+				renderer->draw_indexed(renderer, packet->vertex_buffer, packet->index_buffer, packet->count);
+			else
+				renderer->draw(renderer, packet->vertex_buffer, packet->count);
+		} else {
+			if (packet->index_buffer)
+				renderer->draw_indexed_instanced(renderer, packet->vertex_buffer, packet->index_buffer, packet->instance_buffer, packet->count, packet->instance_count);
+			else
+				renderer->draw_instanced(renderer, packet->vertex_buffer, packet->instance_buffer, packet->count, packet->instance_count);
+		}
+	}
+
+	renderer->get_stats(renderer, &backend_stats);
+	frame_stats.buffer_binds = (uint32_t)(backend_stats.buffer_binds - buffer_binds);
+	frame_stats.buffer_binds_skipped = packet_count - frame_stats.buffer_binds;
+
+	darray_reset(queue->packets);
+
+	if (stats)
+		*stats = frame_stats;
+}
+
+uint64_t render_queue_sort_key(RenderQueue *queue, const RenderPacket *packet) {
+	float depth = queue->depth_range > 0.f ? packet->depth / queue->depth_range : 0.f;
+	depth = depth < 0.f ? 0.f : depth > 1.f ? 1.f : depth;
+
+	uint64_t depth_bits = (uint64_t)(depth * SORT_DEPTH_MAX);
+	if (packet->pass == RENDER_PASS_TRANSPARENT)
+		depth_bits = SORT_DEPTH_MAX - depth_bits;
+
+	return (uint64_t)packet->pass << SORT_SHIFT_PASS |
+		   (uint64_t)sort_id(&queue->shader_ids, packet->shader) << SORT_SHIFT_SHADER |
+		   (uint64_t)sort_id(&queue->texture_ids, packet->textures[0]) << SORT_SHIFT_TEXTURE |
+		   depth_bits << SORT_SHIFT_DEPTH |
+		   (uint64_t)sort_id(&queue->buffer_ids, packet->vertex_buffer) << SORT_SHIFT_BUFFER;
+}
+
+uint32_t sort_id(SortIdTable *table, const void *pointer) {
+	if (pointer == NULL)
+		return 0;
+
+	uint32_t mask = SORT_ID_TABLE_SIZE - 1;
+	uint32_t slot = (uint32_t)((((uintptr_t)pointer >> 4) * 0x9E3779B97F4A7C15ull) >> 40) & mask;
+	for (; table->pointers[slot]; slot = (slot + 1) & mask) {
+		if (table->pointers[slot] == pointer)
+			return table->ids[slot];
+	}
+
+	// Out of ids, start over. Ids only group draws, so a rare regrouping is harmless
+	if (table->count == SORT_ID_LIMIT - 1) {
+		memset(table, 0, sizeof(SortIdTable));
+		return sort_id(table, pointer);
+	}
+
+	table->pointers[slot] = pointer;
+	table->ids[slot] = (uint16_t)++table->count;
+	return table->ids[slot];
+}
+
+// LSD radix sort over 8 bit digits, stable, skipping digits that are the same for every key
+const uint32_t *radix_sort(uint64_t *keys, uint32_t *order, uint64_t *keys_scratch, uint32_t *order_scratch, uint32_t count) {
+	if (count == 0)
+		return order;
+
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		uint32_t histogram[256] = { 0 };
+		for (uint32_t i = 0; i < count; i++)
+			histogram[(keys[i] >> shift) & 0xFF]++;
+
+		if (histogram[(keys[0] >> shift) & 0xFF] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < 256; digit++) {
+			uint32_t digit_count = histogram[digit];
+			histogram[digit] = offset;
+			offset += digit_count;
+		}
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+			keys_scratch[destination] = keys[i];
+			order_scratch[destination] = order[i];
+		}
+
+		uint64_t *keys_swap = keys;
+		keys = keys_scratch;
+		keys_scratch = keys_swap;
+
+		uint32_t *order_swap = order;
+		order = order_scratch;
+		order_scratch = order_swap;
+	}
+
+	return order;
+}
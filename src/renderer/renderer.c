@@ -1,7 +1,10 @@
 #include "renderer.h"
 #include "base.h"
 #include "renderer/gl_renderer.h"
+#include "renderer/null_renderer.h"
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 Renderer* renderer_create(RendererAPI backend) {
 	const char* backend_stringify[] = {
@@ -14,7 +17,9 @@ Renderer* renderer_create(RendererAPI backend) {
 		case BACKEND_API_OPENGL: {
 			return opengl_renderer_create();
 		} break;
-		case BACKEND_API_NONE:
+		case BACKEND_API_NONE: {
+			return null_renderer_create();
+		} break;
 		case BACKEND_API_VULKAN:
 		default: {
 			LOG_ERROR("Renderer %s is not supported at this moment!", backend_stringify[backend]);
@@ -35,7 +40,10 @@ void renderer_destroy(Renderer* renderer) {
 				opengl_renderer_destroy(renderer);
 				free(renderer);
 			} break;
-			case BACKEND_API_NONE:
+			case BACKEND_API_NONE: {
+				null_renderer_destroy(renderer);
+				free(renderer);
+			} break;
 			case BACKEND_API_VULKAN:
 			default: {
 				LOG_ERROR("Renderer %s is not supported at this moment!", backend_stringify[renderer->backend]);
@@ -44,3 +52,54 @@ void renderer_destroy(Renderer* renderer) {
 		};
 	}
 }
+
+// Round to nearest even, values past the half range become infinity and NaN stays NaN
+uint16_t vertex_pack_half(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint16_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+	if (exponent >= 31)
+		return sign | 0x7C00;
+	if (exponent <= 0) {
+		// Subnormal half, or zero once the value is too small
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		uint32_t shift = 14 - exponent;
+		uint32_t half = mantissa >> shift, rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+		return sign | half;
+	}
+
+	uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13), rest = mantissa & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++; // Carries into the exponent when the mantissa overflows, which is the right result
+	return sign | half;
+}
+
+int16_t vertex_pack_snorm16(float value) {
+	value = value < -1.f ? -1.f : value > 1.f ? 1.f : value;
+	return (int16_t)lrintf(value * 32767.f);
+}
+
+uint8_t vertex_pack_unorm8(float value) {
+	value = value < 0.f ? 0.f : value > 1.f ? 1.f : value;
+	return (uint8_t)lrintf(value * 255.f);
+}
+
+uint32_t vertex_pack_2_10_10_10(const float xyz[3], int32_t w) {
+	uint32_t packed = (uint32_t)(w & 0x3) << 30;
+	for (uint32_t i = 0; i < 3; i++) {
+		float value = xyz[i] < -1.f ? -1.f : xyz[i] > 1.f ? 1.f : xyz[i];
+		packed |= ((uint32_t)lrintf(value * 511.f) & 0x3FF) << (i * 10);
+	}
+
+	return packed;
+}
@@ -0,0 +1,387 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "renderer/texture_cache.h"
+#include "base.h"
+#include "base/file.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define COOKED_TEXTURE_MAGIC   0x58455443 // "CTEX"
+#define COOKED_TEXTURE_VERSION 1
+
+typedef struct {
+	uint32_t magic, version;
+	uint32_t format, width, height, level_count;
+	uint32_t level_offsets[COOKED_TEXTURE_MAX_LEVELS];
+	uint32_t level_sizes[COOKED_TEXTURE_MAX_LEVELS];
+} CookedTextureHeader;
+
+static uint8_t *mip_downsample(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t *out_width, uint32_t *out_height);
+static void compress_level(const uint8_t *rgba, uint32_t width, uint32_t height, TextureFormat format, uint8_t *out);
+static void bc1_compress_block(const uint8_t block[16][4], uint8_t out[8]);
+static void bc3_compress_alpha(const uint8_t block[16][4], uint8_t out[8]);
+static uint16_t rgb_to_565(const float rgb[3]);
+static void rgb_from_565(uint16_t color, int32_t rgb[3]);
+static bool cooked_texture_parse(const void *data, size_t size, CookedTexture *texture);
+
+void texture_cache_path(const char *directory, const char *source_path, uint32_t width, uint32_t height, char *path, size_t path_size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (const char *c = source_path; *c; c++)
+		hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+
+	snprintf(path, path_size, "%s/%016llx_%ux%u.ctex", directory, (unsigned long long)hash, width, height);
+}
+
+bool texture_cache_is_fresh(const char *cooked_path, const char *source_path) {
+	struct stat cooked, source;
+	if (stat(cooked_path, &cooked) != 0)
+		return false;
+
+	// A cache without its source is all there is, use it
+	if (stat(source_path, &source) != 0)
+		return true;
+
+	return cooked.st_mtime >= source.st_mtime;
+}
+
+TextureFormat texture_cook_format(const uint8_t *rgba, uint32_t width, uint32_t height) {
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		if (rgba[i * 4 + 3] != 255)
+			return TEXTURE_FORMAT_BC3;
+	}
+
+	return TEXTURE_FORMAT_BC1;
+}
+
+bool texture_cook(const uint8_t *rgba, uint32_t width, uint32_t height, TextureFormat format, const char *cooked_path) {
+	size_t size;
+	uint8_t *data = texture_compress(rgba, width, height, format, &size);
+	if (data == NULL)
+		return false;
+
+	bool written = file_write_atomic(cooked_path, data, size);
+	free(data);
+	if (!written) {
+		LOG_ERROR("Failed to write cooked texture [ %s ]", cooked_path);
+		return false;
+	}
+
+	LOG_DEBUG("Cooked [ %s ] %ux%u, %zu bytes (%.1fx smaller than RGBA8)", cooked_path, width, height, size, (double)width * height * 4 * 4 / 3 / size);
+	return true;
+}
+
+uint8_t *texture_compress(const uint8_t *rgba, uint32_t width, uint32_t height, TextureFormat format, size_t *size) {
+	if (width % 4 != 0 || height % 4 != 0 || (format != TEXTURE_FORMAT_BC1 && format != TEXTURE_FORMAT_BC3)) {
+		LOG_ERROR("Can't cook a %ux%u texture to format %d", width, height, format);
+		return NULL;
+	}
+
+	CookedTextureHeader header = { .magic = COOKED_TEXTURE_MAGIC, .version = COOKED_TEXTURE_VERSION, .format = format, .width = width, .height = height };
+
+	uint32_t level_width = width, level_height = height, offset = sizeof(CookedTextureHeader);
+	for (;;) {
+		header.level_offsets[header.level_count] = offset;
+		header.level_sizes[header.level_count] = texture_block_level_size(format, level_width, level_height);
+		offset += header.level_sizes[header.level_count];
+		header.level_count++;
+
+		if ((level_width == 1 && level_height == 1) || header.level_count == COOKED_TEXTURE_MAX_LEVELS)
+			break;
+		level_width = level_width > 1 ? level_width / 2 : 1;
+		level_height = level_height > 1 ? level_height / 2 : 1;
+	}
+
+	uint8_t *data = malloc(offset);
+	memcpy(data, &header, sizeof(header));
+
+	const uint8_t *level = rgba;
+	uint8_t *downsampled = NULL;
+	level_width = width;
+	level_height = height;
+	for (uint32_t i = 0; i < header.level_count; i++) {
+		compress_level(level, level_width, level_height, format, data + header.level_offsets[i]);
+
+		if (i + 1 < header.level_count) {
+			uint8_t *next = mip_downsample(level, level_width, level_height, &level_width, &level_height);
+			free(downsampled);
+			level = downsampled = next;
+		}
+	}
+	free(downsampled);
+
+	*size = offset;
+	return data;
+}
+
+bool cooked_texture_map(const char *cooked_path, CookedTexture *texture) {
+	*texture = (CookedTexture){ 0 };
+
+	size_t size;
+	const void *mapping = file_map(cooked_path, &size);
+	if (mapping == NULL)
+		return false;
+
+	if (!cooked_texture_parse(mapping, size, texture)) {
+		LOG_WARN("Cooked texture [ %s ] is invalid or outdated", cooked_path);
+		file_unmap(mapping, size);
+		return false;
+	}
+
+	return true;
+}
+
+bool cooked_texture_from_memory(uint8_t *data, size_t size, CookedTexture *texture) {
+	*texture = (CookedTexture){ 0 };
+
+	if (!cooked_texture_parse(data, size, texture)) {
+		LOG_WARN("Cooked texture data is invalid");
+		free(data);
+		return false;
+	}
+
+	texture->in_memory = true;
+	return true;
+}
+
+// Checks the header and points texture into data
+bool cooked_texture_parse(const void *data, size_t size, CookedTexture *texture) {
+	const CookedTextureHeader *header = data;
+	bool valid = size >= sizeof(CookedTextureHeader) && header->magic == COOKED_TEXTURE_MAGIC && header->version == COOKED_TEXTURE_VERSION &&
+				 (header->format == TEXTURE_FORMAT_BC1 || header->format == TEXTURE_FORMAT_BC3) && header->level_count > 0 &&
+				 header->level_count <= COOKED_TEXTURE_MAX_LEVELS;
+	for (uint32_t i = 0; valid && i < header->level_count; i++)
+		valid = (uint64_t)header->level_offsets[i] + header->level_sizes[i] <= (uint64_t)size;
+
+	if (!valid)
+		return false;
+
+	texture->format = header->format;
+	texture->width = header->width;
+	texture->height = header->height;
+	texture->level_count = header->level_count;
+	for (uint32_t i = 0; i < header->level_count; i++) {
+		texture->levels[i] = (const uint8_t *)data + header->level_offsets[i];
+		texture->level_sizes[i] = header->level_sizes[i];
+	}
+	texture->mapping = data;
+	texture->mapping_size = size;
+
+	return true;
+}
+
+void cooked_texture_unmap(CookedTexture *texture) {
+	if (texture->in_memory)
+		free((void *)texture->mapping);
+	else
+		file_unmap(texture->mapping, texture->mapping_size);
+	*texture = (CookedTexture){ 0 };
+}
+
+void texture_block_solid(TextureFormat format, const uint8_t rgba[4], uint8_t *out) {
+	uint8_t *color = out;
+	if (format == TEXTURE_FORMAT_BC3) {
+		memset(out, 0, 8);
+		out[0] = out[1] = rgba[3];
+		color = out + 8;
+	}
+
+	uint16_t packed = rgb_to_565((float[3]){ rgba[0], rgba[1], rgba[2] });
+	color[0] = color[2] = packed & 0xFF;
+	color[1] = color[3] = packed >> 8;
+	memset(color + 4, 0, 4);
+}
+
+uint32_t texture_block_level_size(TextureFormat format, uint32_t width, uint32_t height) {
+	uint32_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+	return blocks * (format == TEXTURE_FORMAT_BC1 ? 8 : 16);
+}
+
+// 2x2 box filter, odd sizes repeat their last row or column
+uint8_t *mip_downsample(const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t *out_width, uint32_t *out_height) {
+	uint32_t next_width = width > 1 ? width / 2 : 1, next_height = height > 1 ? height / 2 : 1;
+	uint8_t *next = malloc((size_t)next_width * next_height * 4);
+
+	for (uint32_t y = 0; y < next_height; y++) {
+		uint32_t y0 = y * 2, y1 = y0 + 1 < height ? y0 + 1 : y0;
+		for (uint32_t x = 0; x < next_width; x++) {
+			uint32_t x0 = x * 2, x1 = x0 + 1 < width ? x0 + 1 : x0;
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				uint32_t sum = rgba[((size_t)y0 * width + x0) * 4 + channel] + rgba[((size_t)y0 * width + x1) * 4 + channel] +
+							   rgba[((size_t)y1 * width + x0) * 4 + channel] + rgba[((size_t)y1 * width + x1) * 4 + channel];
+				next[((size_t)y * next_width + x) * 4 + channel] = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+
+	*out_width = next_width;
+	*out_height = next_height;
+	return next;
+}
+
+// Levels smaller than a block fill the rest of it by clamping to the edge
+void compress_level(const uint8_t *rgba, uint32_t width, uint32_t height, TextureFormat format, uint8_t *out) {
+	for (uint32_t block_y = 0; block_y < (height + 3) / 4; block_y++) {
+		for (uint32_t block_x = 0; block_x < (width + 3) / 4; block_x++) {
+			uint8_t block[16][4];
+			for (uint32_t i = 0; i < 16; i++) {
+				uint32_t x = block_x * 4 + i % 4, y = block_y * 4 + i / 4;
+				x = x < width ? x : width - 1;
+				y = y < height ? y : height - 1;
+				memcpy(block[i], rgba + ((size_t)y * width + x) * 4, 4);
+			}
+
+			if (format == TEXTURE_FORMAT_BC3) {
+				bc3_compress_alpha(block, out);
+				out += 8;
+			}
+			bc1_compress_block(block, out);
+			out += 8;
+		}
+	}
+}
+
+// Endpoints lie on the principal axis of the block colours, every pixel takes the closest of the four palette entries
+void bc1_compress_block(const uint8_t block[16][4], uint8_t out[8]) {
+	float mean[3] = { 0 };
+	for (uint32_t i = 0; i < 16; i++) {
+		for (uint32_t c = 0; c < 3; c++)
+			mean[c] += block[i][c] / 16.f;
+	}
+
+	float covariance[6] = { 0 }; // rr rg rb gg gb bb
+	for (uint32_t i = 0; i < 16; i++) {
+		float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	float axis[3] = { 1.f, 1.f, 1.f };
+	for (uint32_t iteration = 0; iteration < 8; iteration++) {
+		float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2],
+		};
+		float largest = fabsf(next[0]) > fabsf(next[1]) ? fabsf(next[0]) : fabsf(next[1]);
+		largest = largest > fabsf(next[2]) ? largest : fabsf(next[2]);
+		if (largest < 1e-6f)
+			break;
+		for (uint32_t c = 0; c < 3; c++)
+			axis[c] = next[c] / largest;
+	}
+
+	float minimum = 0.f, maximum = 0.f;
+	for (uint32_t i = 0; i < 16; i++) {
+		float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+		minimum = t < minimum ? t : minimum;
+		maximum = t > maximum ? t : maximum;
+	}
+
+	float length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float high[3], low[3];
+	for (uint32_t c = 0; c < 3; c++) {
+		high[c] = mean[c] + axis[c] * maximum / length;
+		low[c] = mean[c] + axis[c] * minimum / length;
+	}
+
+	uint16_t color0 = rgb_to_565(high), color1 = rgb_to_565(low);
+	if (color0 < color1) {
+		uint16_t swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	out[0] = color0 & 0xFF;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF;
+	out[3] = color1 >> 8;
+
+	// Equal endpoints would switch the block to three colour mode, index 0 is right for every pixel anyway
+	uint32_t indices = 0;
+	if (color0 != color1) {
+		int32_t palette[4][3];
+		rgb_from_565(color0, palette[0]);
+		rgb_from_565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t best = 0;
+			int32_t best_distance = INT32_MAX;
+			for (uint32_t entry = 0; entry < 4; entry++) {
+				int32_t dr = block[i][0] - palette[entry][0], dg = block[i][1] - palette[entry][1], db = block[i][2] - palette[entry][2];
+				int32_t distance = dr * dr + dg * dg + db * db;
+				if (distance < best_distance) {
+					best_distance = distance;
+					best = entry;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+
+	out[4] = indices & 0xFF;
+	out[5] = (indices >> 8) & 0xFF;
+	out[6] = (indices >> 16) & 0xFF;
+	out[7] = indices >> 24;
+}
+
+// Eight level alpha between the block's extremes
+void bc3_compress_alpha(const uint8_t block[16][4], uint8_t out[8]) {
+	uint8_t alpha0 = 0, alpha1 = 255;
+	for (uint32_t i = 0; i < 16; i++) {
+		alpha0 = block[i][3] > alpha0 ? block[i][3] : alpha0;
+		alpha1 = block[i][3] < alpha1 ? block[i][3] : alpha1;
+	}
+
+	out[0] = alpha0;
+	out[1] = alpha1;
+
+	uint64_t indices = 0;
+	if (alpha0 != alpha1) {
+		int32_t palette[8] = { alpha0, alpha1 };
+		for (uint32_t entry = 2; entry < 8; entry++)
+			palette[entry] = ((8 - entry) * alpha0 + (entry - 1) * alpha1) / 7;
+
+		for (uint32_t i = 0; i < 16; i++) {
+			uint64_t best = 0;
+			int32_t best_distance = INT32_MAX;
+			for (uint32_t entry = 0; entry < 8; entry++) {
+				int32_t distance = abs(block[i][3] - palette[entry]);
+				if (distance < best_distance) {
+					best_distance = distance;
+					best = entry;
+				}
+			}
+			indices |= best << (i * 3);
+		}
+	}
+
+	for (uint32_t i = 0; i < 6; i++)
+		out[2 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+uint16_t rgb_to_565(const float rgb[3]) {
+	int32_t r = (int32_t)(rgb[0] * 31.f / 255.f + .5f), g = (int32_t)(rgb[1] * 63.f / 255.f + .5f), b = (int32_t)(rgb[2] * 31.f / 255.f + .5f);
+	r = r < 0 ? 0 : r > 31 ? 31 : r;
+	g = g < 0 ? 0 : g > 63 ? 63 : g;
+	b = b < 0 ? 0 : b > 31 ? 31 : b;
+	return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+void rgb_from_565(uint16_t color, int32_t rgb[3]) {
+	int32_t r = color >> 11, g = (color >> 5) & 0x3F, b = color & 0x1F;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
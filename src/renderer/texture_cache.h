@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cooked textures: a full mip chain compressed to BC1 (opaque) or BC3 (with alpha) on the CPU and stored in a small
+ * container file. Loading one is a mmap, the levels are handed to the GPU as they are.
+ */
+
+#define COOKED_TEXTURE_MAX_LEVELS 16
+
+typedef enum {
+	TEXTURE_FORMAT_RGBA8,
+	TEXTURE_FORMAT_BC1, // 8 bytes per 4x4 block, no alpha
+	TEXTURE_FORMAT_BC3, // 16 bytes per 4x4 block, interpolated alpha
+
+	TEXTURE_FORMAT_COUNT
+} TextureFormat;
+
+typedef struct {
+	TextureFormat format;
+	uint32_t width, height, level_count;
+	const uint8_t *levels[COOKED_TEXTURE_MAX_LEVELS]; // Point into the mapping
+	uint32_t level_sizes[COOKED_TEXTURE_MAX_LEVELS];
+
+	const void *mapping;
+	size_t mapping_size;
+	bool in_memory; // mapping came from texture_compress rather than a file
+} CookedTexture;
+
+// Writes the cache file name for source_path at the given size to path, a different size gets a different file
+void texture_cache_path(const char *directory, const char *source_path, uint32_t width, uint32_t height, char *path, size_t path_size);
+// True if cooked_path exists and isn't older than source_path
+bool texture_cache_is_fresh(const char *cooked_path, const char *source_path);
+
+// Picks BC1 when every pixel is opaque, BC3 otherwise
+TextureFormat texture_cook_format(const uint8_t *rgba, uint32_t width, uint32_t height);
+// Builds the mip chain of an RGBA8 image, compresses it and writes it to cooked_path. Width and height must be multiples of 4
+bool texture_cook(const uint8_t *rgba, uint32_t width, uint32_t height, TextureFormat format, const char *cooked_path);
+// texture_cook without the file: returns the malloc-ed cooked file contents and writes their size, NULL if it can't cook
+uint8_t *texture_compress(const uint8_t *rgba, uint32_t width, uint32_t height, TextureFormat format, size_t *size);
+
+bool cooked_texture_map(const char *cooked_path, CookedTexture *texture);
+// Reads cooked file contents from memory and takes ownership of data, even if they're invalid
+bool cooked_texture_from_memory(uint8_t *data, size_t size, CookedTexture *texture);
+// Unmaps the file, or frees the memory the texture was read from
+void cooked_texture_unmap(CookedTexture *texture);
+
+// Fills out with one block of a solid colour, 8 bytes for BC1 and 16 for BC3
+void texture_block_solid(TextureFormat format, const uint8_t rgba[4], uint8_t *out);
+// Bytes of a level of a block compressed texture
+uint32_t texture_block_level_size(TextureFormat format, uint32_t width, uint32_t height);
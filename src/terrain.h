@@ -0,0 +1,53 @@
+#pragma once
+
+#include "base/job_system.h"
+#include "renderer.h"
+
+#include <stdint.h>
+
+#define TERRAIN_CHUNK_SIZE		  250.f // Chunk side length in world units
+#define TERRAIN_CHUNK_SUBDIVISION 64 // Quads per chunk side
+#define TERRAIN_HEIGHT_SCALE	  200.f
+#define TERRAIN_CHUNK_LOAD_BUDGET 4 // Max chunks generated per terrain_update call
+#define TERRAIN_CHUNK_MAP_BUDGET  32 // Max chunks loaded from the mesh cache per terrain_update call
+#define TERRAIN_LOD_COUNT		  5 // Level n has TERRAIN_CHUNK_SUBDIVISION >> n quads per side
+#define TERRAIN_LOD_DISTANCE	  500.f // Chunks closer than this use level 0, each doubling of distance drops a level
+
+typedef struct _terrain Terrain;
+
+typedef enum {
+	TERRAIN_VERTEX_FLOAT, // 20 bytes, float position and UV in world space
+	TERRAIN_VERTEX_QUANTIZED, // 12 bytes, SNORM16 position relative to the chunk and half float UV. The chunk transform goes in the model matrix
+
+	TERRAIN_VERTEX_COUNT
+} TerrainVertexLayout;
+
+/**
+ * ===========================================================================================
+ * -------- Terrain
+ * ===========================================================================================
+ **/
+
+Terrain *terrain_create(Renderer *renderer, JobSystem *jobs, float view_distance, TerrainVertexLayout vertex_layout);
+void terrain_destroy(Terrain *terrain);
+
+// Generated chunk meshes are written to directory and mapped from there instead of generated again, on this run and later
+// ones. Files are keyed on the generator parameters, so changing any of them misses the cache. NULL turns the cache off
+void terrain_set_mesh_cache(Terrain *terrain, const char *directory);
+
+// Streams chunks in around camera_position (nearest first), evicts the ones that left the view distance and
+// re-meshes the ones whose level of detail changed. Edges facing a coarser chunk are stitched to it, so seams don't crack
+void terrain_update(Terrain *terrain, float camera_position[3]);
+// Queues the chunks that intersect frustum (every chunk if it's NULL) and returns how many were queued.
+// Packets copy their pass, shader, textures and model from material, quantized chunks append their own transform to the model
+uint32_t terrain_draw(Terrain *terrain, const Frustum *frustum, RenderQueue *queue, const RenderPacket *material);
+
+// Nearest hit of ray within max_distance on the resident chunks, at the level of detail they're drawn at (seams to
+// coarser neighbours aside). Chunks are walked along the ray and their min/max height pyramids skip the quads it passes
+// above or below, so a cast visits a handful of quads. Don't call it during terrain_update
+bool terrain_raycast(const Terrain *terrain, const Ray *ray, float max_distance, RayHit *hit);
+// terrain_raycast for every ray, spread across the job system. Misses get a distance of INFINITY, returns the hit count
+uint32_t terrain_raycast_batch(const Terrain *terrain, const Ray *rays, uint32_t count, float max_distance, RayHit *hits);
+
+uint32_t terrain_chunk_count(Terrain *terrain);
+uint32_t terrain_triangle_count(Terrain *terrain);
@@ -0,0 +1,259 @@
+#include "noise.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && !defined(NOISE_NO_SIMD)
+#define NOISE_SIMD
+#endif
+
+#define PRIME_X			 501125321u
+#define PRIME_Y			 1136930381u
+#define HASH_MULTIPLIER	 0x27d4eb2du
+#define PERLIN_2D_BOUNDS 1.4247691104677813f
+
+// Same table as FastNoiseLite's GRADIENTS_2D, the batch path has to hash into identical gradients
+static const float g_gradients_2d[] = {
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220052f, 0.99144486137381f, -0.130526192220052f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.608761429008721f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220051f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220052f, 0.99144486137381f, -0.130526192220052f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.608761429008721f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220051f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220052f, 0.99144486137381f, -0.130526192220052f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.608761429008721f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220051f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220052f, 0.99144486137381f, -0.130526192220052f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.608761429008721f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220051f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220052f, 0.99144486137381f, -0.130526192220052f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.608761429008721f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220051f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+	-0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f,
+};
+
+static bool noise_is_batchable(const fnl_state *state);
+static float noise_fractal_bounding(const fnl_state *state);
+static float perlin_single(int32_t seed, float x, float y);
+
+static inline float lerp(float a, float b, float t) { return a + t * (b - a); }
+static inline float interp_quintic(float t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+static inline int32_t fast_floor(float f) { return f >= 0 ? (int32_t)f : (int32_t)f - 1; }
+
+#ifdef NOISE_SIMD
+typedef float f32xN __attribute__((vector_size(NOISE_BATCH_LANES * sizeof(float))));
+typedef int32_t i32xN __attribute__((vector_size(NOISE_BATCH_LANES * sizeof(int32_t))));
+typedef uint32_t u32xN __attribute__((vector_size(NOISE_BATCH_LANES * sizeof(uint32_t))));
+
+static f32xN noise_sample_n(const fnl_state *state, f32xN x, f32xN y);
+#endif
+
+void noise_fill_row(const fnl_state *state, float x, float step_x, float y, uint32_t count, float *out) {
+	uint32_t i = 0;
+
+#ifdef NOISE_SIMD
+	if (noise_is_batchable(state)) {
+		f32xN lane, zero = { 0 };
+		for (uint32_t l = 0; l < NOISE_BATCH_LANES; l++)
+			lane[l] = (float)l;
+
+		for (; i + NOISE_BATCH_LANES <= count; i += NOISE_BATCH_LANES) {
+			f32xN result = noise_sample_n(state, x + ((float)i + lane) * step_x, zero + y);
+			memcpy(out + i, &result, sizeof(result));
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		out[i] = noise_sample(state, x + (float)i * step_x, y);
+}
+
+float noise_sample(const fnl_state *state, float x, float y) {
+	if (!noise_is_batchable(state)) {
+		fnl_state copy = *state;
+		return fnlGetNoise2D(&copy, x, y);
+	}
+
+	x *= state->frequency;
+	y *= state->frequency;
+	if (state->fractal_type == FNL_FRACTAL_NONE)
+		return perlin_single(state->seed, x, y);
+
+	int32_t seed = state->seed;
+	float sum = 0, amp = noise_fractal_bounding(state);
+	for (int32_t i = 0; i < state->octaves; i++) {
+		float noise = perlin_single(seed++, x, y);
+
+		if (state->fractal_type == FNL_FRACTAL_RIDGED) {
+			noise = noise < 0 ? -noise : noise;
+			sum += (noise * -2 + 1) * amp;
+			amp *= lerp(1.0f, 1 - noise, state->weighted_strength);
+		} else {
+			sum += noise * amp;
+			amp *= lerp(1.0f, (noise + 1 < 2 ? noise + 1 : 2) * 0.5f, state->weighted_strength);
+		}
+
+		x *= state->lacunarity;
+		y *= state->lacunarity;
+		amp *= state->gain;
+	}
+
+	return sum;
+}
+
+bool noise_is_batchable(const fnl_state *state) {
+	return state->noise_type == FNL_NOISE_PERLIN &&
+		(state->fractal_type == FNL_FRACTAL_NONE || state->fractal_type == FNL_FRACTAL_FBM || state->fractal_type == FNL_FRACTAL_RIDGED);
+}
+
+float noise_fractal_bounding(const fnl_state *state) {
+	float gain = state->gain < 0 ? -state->gain : state->gain;
+	float amp = gain, amp_fractal = 1.0f;
+	for (int32_t i = 1; i < state->octaves; i++) {
+		amp_fractal += amp;
+		amp *= gain;
+	}
+
+	return 1.0f / amp_fractal;
+}
+
+static inline float grad_coord(int32_t seed, uint32_t x_primed, uint32_t y_primed, float xd, float yd) {
+	uint32_t hash = ((uint32_t)seed ^ x_primed ^ y_primed) * HASH_MULTIPLIER;
+	hash ^= hash >> 15;
+	hash &= 127 << 1; // Only bits below the sign survive, so the unsigned shift matches FastNoiseLite's signed one
+
+	return xd * g_gradients_2d[hash] + yd * g_gradients_2d[hash | 1];
+}
+
+float perlin_single(int32_t seed, float x, float y) {
+	int32_t x0 = fast_floor(x), y0 = fast_floor(y);
+
+	float xd0 = (float)(x - x0), yd0 = (float)(y - y0);
+	float xd1 = xd0 - 1, yd1 = yd0 - 1;
+	float xs = interp_quintic(xd0), ys = interp_quintic(yd0);
+
+	uint32_t x0_primed = (uint32_t)x0 * PRIME_X, y0_primed = (uint32_t)y0 * PRIME_Y;
+	uint32_t x1_primed = x0_primed + PRIME_X, y1_primed = y0_primed + PRIME_Y;
+
+	float xf0 = lerp(grad_coord(seed, x0_primed, y0_primed, xd0, yd0), grad_coord(seed, x1_primed, y0_primed, xd1, yd0), xs);
+	float xf1 = lerp(grad_coord(seed, x0_primed, y1_primed, xd0, yd1), grad_coord(seed, x1_primed, y1_primed, xd1, yd1), xs);
+
+	return lerp(xf0, xf1, ys) * PERLIN_2D_BOUNDS;
+}
+
+#ifdef NOISE_SIMD
+/*
+ * Lane-wise copies of the scalar functions above, the float operations have to stay in the same order.
+ * Everything but the gradient table lookup maps to plain vector instructions (SSE2 by default, AVX2 with -mavx2)
+ */
+
+static inline f32xN lerp_n(f32xN a, f32xN b, f32xN t) { return a + t * (b - a); }
+static inline f32xN interp_quintic_n(f32xN t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+static inline f32xN select_n(i32xN mask, f32xN a, f32xN b) { return (f32xN)(((i32xN)a & mask) | ((i32xN)b & ~mask)); }
+
+static inline u32xN hash_n(int32_t seed, u32xN x_primed, u32xN y_primed) {
+	u32xN hash = ((uint32_t)seed ^ x_primed ^ y_primed) * HASH_MULTIPLIER;
+	hash ^= hash >> 15;
+	return hash & (127 << 1);
+}
+
+#if defined(__AVX2__) && NOISE_BATCH_LANES == 8
+static inline f32xN gather_n(u32xN index) {
+	return (f32xN)_mm256_i32gather_ps(g_gradients_2d, (__m256i)index, 4);
+}
+#endif
+
+static f32xN perlin_single_n(int32_t seed, f32xN x, f32xN y) {
+	// Truncate, then step negative values down one like fast_floor (comparisons yield -1 per true lane)
+	i32xN x0 = __builtin_convertvector(x, i32xN) + (x < 0);
+	i32xN y0 = __builtin_convertvector(y, i32xN) + (y < 0);
+
+	f32xN xd0 = x - __builtin_convertvector(x0, f32xN), yd0 = y - __builtin_convertvector(y0, f32xN);
+	f32xN xd1 = xd0 - 1, yd1 = yd0 - 1;
+	f32xN xs = interp_quintic_n(xd0), ys = interp_quintic_n(yd0);
+
+	u32xN x0_primed = (u32xN)x0 * PRIME_X, y0_primed = (u32xN)y0 * PRIME_Y;
+	u32xN x1_primed = x0_primed + PRIME_X, y1_primed = y0_primed + PRIME_Y;
+
+	u32xN hash00 = hash_n(seed, x0_primed, y0_primed), hash10 = hash_n(seed, x1_primed, y0_primed);
+	u32xN hash01 = hash_n(seed, x0_primed, y1_primed), hash11 = hash_n(seed, x1_primed, y1_primed);
+
+#if defined(__AVX2__) && NOISE_BATCH_LANES == 8
+	f32xN g[8] = {
+		gather_n(hash00), gather_n(hash00 | 1), gather_n(hash10), gather_n(hash10 | 1),
+		gather_n(hash01), gather_n(hash01 | 1), gather_n(hash11), gather_n(hash11 | 1),
+	};
+#else
+	// No portable gather, do all four corners in one scalar pass
+	uint32_t hashes[4][NOISE_BATCH_LANES];
+	u32xN corner_hashes[4] = { hash00, hash10, hash01, hash11 };
+	memcpy(hashes, corner_hashes, sizeof(hashes));
+
+	float gradients[8][NOISE_BATCH_LANES];
+	for (uint32_t corner = 0; corner < 4; corner++) {
+		for (uint32_t l = 0; l < NOISE_BATCH_LANES; l++) {
+			gradients[corner * 2 + 0][l] = g_gradients_2d[hashes[corner][l]];
+			gradients[corner * 2 + 1][l] = g_gradients_2d[hashes[corner][l] | 1];
+		}
+	}
+
+	f32xN g[8];
+	memcpy(g, gradients, sizeof(g));
+#endif
+
+	f32xN xf0 = lerp_n(xd0 * g[0] + yd0 * g[1], xd1 * g[2] + yd0 * g[3], xs);
+	f32xN xf1 = lerp_n(xd0 * g[4] + yd1 * g[5], xd1 * g[6] + yd1 * g[7], xs);
+
+	return lerp_n(xf0, xf1, ys) * PERLIN_2D_BOUNDS;
+}
+
+f32xN noise_sample_n(const fnl_state *state, f32xN x, f32xN y) {
+	x *= state->frequency;
+	y *= state->frequency;
+	if (state->fractal_type == FNL_FRACTAL_NONE)
+		return perlin_single_n(state->seed, x, y);
+
+	// Weighted strength makes the amplitude depend on the previous octave, so it's tracked per lane
+	f32xN zero = { 0 };
+	f32xN sum = zero, amp = zero + noise_fractal_bounding(state);
+	int32_t seed = state->seed;
+	for (int32_t i = 0; i < state->octaves; i++) {
+		f32xN noise = perlin_single_n(seed++, x, y);
+
+		if (state->fractal_type == FNL_FRACTAL_RIDGED) {
+			noise = select_n(noise < 0, -noise, noise);
+			sum += (noise * -2 + 1) * amp;
+			amp *= lerp_n(zero + 1.0f, 1 - noise, zero + state->weighted_strength);
+		} else {
+			sum += noise * amp;
+			amp *= lerp_n(zero + 1.0f, select_n(noise + 1 < 2, noise + 1, zero + 2) * 0.5f, zero + state->weighted_strength);
+		}
+
+		x *= state->lacunarity;
+		y *= state->lacunarity;
+		amp *= state->gain;
+	}
+
+	return sum;
+}
+#endif
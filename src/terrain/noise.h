@@ -0,0 +1,25 @@
+#pragma once
+
+#include <fnl/FastNoiseLite.h>
+#include <stdint.h>
+
+// Largest difference from fnlGetNoise2D for the same inputs. The batch path runs the same float operations in the
+// same order, so it's bit-identical unless the compiler contracts them into FMAs differently (-ffp-contract=fast)
+#define NOISE_BATCH_TOLERANCE 1e-5f
+
+// One AVX2 register, or one SSE2 register otherwise
+#if defined(__AVX2__)
+#define NOISE_BATCH_LANES 8
+#else
+#define NOISE_BATCH_LANES 4
+#endif
+
+/*
+ * Fills out[i] = fnlGetNoise2D(state, x + i * step_x, y) for i in [0, count).
+ * Perlin noise with no fractal, FBm or ridged fractals is evaluated NOISE_BATCH_LANES points at a time,
+ * any other state configuration falls back to fnlGetNoise2D per point.
+ */
+void noise_fill_row(const fnl_state *state, float x, float step_x, float y, uint32_t count, float *out);
+
+// Scalar reference of the batch path, used for the tail of a row and when vector extensions are unavailable
+float noise_sample(const fnl_state *state, float x, float y);
@@ -0,0 +1,947 @@
+#include "terrain.h"
+#include "base.h"
+#include "base/chunk_grid.h"
+#include "base/darray.h"
+#include "base/file.h"
+#include "base/job_system.h"
+#include "base/pool.h"
+#include "renderer/mesh_cache.h"
+#include "renderer/mesh_optimizer.h"
+#include "terrain/noise.h"
+
+#include <fnl/FastNoiseLite.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_VERTICES_PER_SIDE	(TERRAIN_CHUNK_SUBDIVISION + 1)
+#define CHUNK_VERTEX_COUNT		(CHUNK_VERTICES_PER_SIDE * CHUNK_VERTICES_PER_SIDE)
+#define CHUNK_VERTEX_BYTES		(sizeof(TerrainVertex) * CHUNK_VERTEX_COUNT) // Room for a level 0 chunk in the largest layout
+#define TILE_ROWS				8 // Vertex rows generated per job
+#define HEIGHT_MIP_LIMIT		16 // Height pyramid levels a chunk can have, enough for 2^15 quads per side
+#define RAYS_PER_JOB			64 // Rays traced by one job of terrain_raycast_batch
+#define CHUNK_TILE_COUNT		((CHUNK_VERTICES_PER_SIDE + TILE_ROWS - 1) / TILE_ROWS)
+#define CHUNK_GENERATOR_VERSION	2 // Part of the mesh cache key, bump it when the same parameters start generating other vertices
+
+// Index buffers are keyed on the chunk level plus how many levels coarser the neighbour on each side is
+#define STITCH_KEY_COUNT (TERRAIN_LOD_COUNT * TERRAIN_LOD_COUNT * TERRAIN_LOD_COUNT * TERRAIN_LOD_COUNT * TERRAIN_LOD_COUNT)
+
+typedef enum {
+	SIDE_NORTH, // -z
+	SIDE_EAST, // +x
+	SIDE_SOUTH, // +z
+	SIDE_WEST, // -x
+
+	SIDE_COUNT
+} ChunkSide;
+
+typedef struct {
+	Buffer *buffer;
+	uint32_t count;
+} TerrainIndexBuffer;
+
+typedef struct {
+	float position[3];
+	float uv[2];
+} TerrainVertex;
+
+typedef struct {
+	int16_t position[4]; // xz in [-1, 1] across the chunk, y = height / TERRAIN_HEIGHT_SCALE, w is padding
+	uint16_t uv[2]; // Half floats, exact for every grid position
+} TerrainQuantizedVertex;
+
+typedef struct {
+	int32_t x, z; // Chunk coordinates, world position = coordinate * TERRAIN_CHUNK_SIZE
+	uint32_t level; // Mesh has TERRAIN_CHUNK_SUBDIVISION >> level quads per side
+	BoundingBox bounds;
+	Buffer *vertex_buffer;
+	const TerrainIndexBuffer *indices; // Stitched to the current neighbour levels
+	float model[16]; // Material model with the chunk transform of quantized vertices, as of the last terrain_draw
+	// Vertex heights row by row, then the min/max height pyramid ray casts descend: one pair per quad, then one per 2 x 2
+	// pairs of the level below and so on up to a single pair for the whole chunk
+	float *heights;
+} TerrainChunk;
+
+typedef struct {
+	int32_t x, z;
+	uint32_t level;
+	int32_t resident; // Index into Terrain::chunks when re-meshing at a new level, -1 for a new chunk
+	float distance;
+} ChunkRequest;
+
+typedef struct {
+	Terrain *terrain;
+	TerrainChunk *chunks;
+	float tile_heights[TERRAIN_CHUNK_LOAD_BUDGET * CHUNK_TILE_COUNT][2]; // Min and max height per tile
+} ChunkBatch;
+
+typedef struct {
+	const Terrain *terrain;
+	const Ray *ray;
+	float max_distance;
+	RayHit *hit;
+	bool found;
+
+	// The chunk being traced
+	const float *heights, *height_bounds[HEIGHT_MIP_LIMIT];
+	uint32_t quads;
+	float spacing, corner[2]; // World xz of the chunk corner
+} TerrainRaycast;
+
+typedef struct {
+	uint32_t x, z;
+	float t_enter, t_exit;
+} HeightNode;
+
+typedef struct {
+	const Terrain *terrain;
+	const Ray *rays;
+	uint32_t count;
+	float max_distance;
+	RayHit *hits;
+} TerrainRaycastBatch;
+
+struct _terrain {
+	Renderer *renderer;
+	JobSystem *jobs;
+	fnl_state noise;
+	float view_distance;
+	float camera_position[3]; // As of the last terrain_update
+	TerrainVertexLayout vertex_layout;
+	uint32_t vertex_size;
+
+	TerrainChunk *chunks; // darray of resident chunks
+	ChunkGrid *grid; // Chunk coordinates (x, 0, z) to index into chunks
+	ChunkRequest *requests; // darray, reused between updates
+	TerrainIndexBuffer *index_buffers; // STITCH_KEY_COUNT entries, built on first use
+	uint32_t *vertex_remap[TERRAIN_LOD_COUNT]; // Grid position (x + z * (quads + 1)) to vertex buffer position, per level
+	uint8_t *vertices; // Scratch space for TERRAIN_CHUNK_LOAD_BUDGET chunks, generated into before upload
+	Pool *height_pools[TERRAIN_LOD_COUNT]; // TerrainChunk::heights per level, every chunk of a level needs the same size
+
+	char *mesh_cache_directory; // NULL without a mesh cache
+	uint64_t mesh_cache_key; // Hash of the generator parameters, chunk keys continue from it
+
+	// Culling scratch, sized for the resident chunks
+	BoundingBox *cull_bounds;
+	uint8_t *cull_visible;
+	uint32_t cull_capacity;
+};
+
+static VertexAttribute g_chunk_attributes[TERRAIN_VERTEX_COUNT][2] = {
+	[TERRAIN_VERTEX_FLOAT] = {
+		{ .name = "a_position", .format = FORMAT_FLOAT3 },
+		{ .name = "a_uv", .format = FORMAT_FLOAT2 },
+	},
+	[TERRAIN_VERTEX_QUANTIZED] = {
+		{ .name = "a_position", .format = FORMAT_SNORM16x4 },
+		{ .name = "a_uv", .format = FORMAT_HALF2 },
+	},
+};
+
+static void terrain_chunk_generate_tile(void *user_data, uint32_t index);
+static void terrain_chunk_upload(Terrain *terrain, TerrainChunk *chunk, const void *vertices);
+static bool terrain_chunk_map(Terrain *terrain, TerrainChunk *chunk);
+static void terrain_chunk_cache(Terrain *terrain, const TerrainChunk *chunk, const void *vertices);
+static void terrain_chunk_model(const TerrainChunk *chunk, const float *material_model, float model[16]);
+static size_t terrain_chunk_vertices_size(Terrain *terrain, uint32_t level);
+static size_t terrain_chunk_heights_size(uint32_t level);
+static void terrain_chunk_place(Terrain *terrain, const ChunkRequest *request, TerrainChunk *chunk);
+static uint64_t terrain_chunk_key(Terrain *terrain, const TerrainChunk *chunk, char *path, size_t path_size);
+static void terrain_chunk_release(Terrain *terrain, TerrainChunk *chunk);
+static void terrain_chunk_read_heights(Terrain *terrain, TerrainChunk *chunk, const void *vertices);
+static bool terrain_raycast_chunk(void *user_data, const int32_t cell[3], uint32_t value);
+static bool terrain_raycast_node(TerrainRaycast *cast, uint32_t mip, uint32_t x, uint32_t z, float t_enter, float t_exit);
+static bool terrain_raycast_quad(TerrainRaycast *cast, uint32_t x, uint32_t z);
+static void terrain_raycast_job(void *user_data, uint32_t index);
+static void terrain_stitch_chunks(Terrain *terrain);
+static const TerrainIndexBuffer *terrain_index_buffer(Terrain *terrain, uint32_t level, const uint32_t coarser[SIDE_COUNT]);
+static uint32_t terrain_build_indices(uint32_t quads, const uint32_t coarser[SIDE_COUNT], uint32_t *indices);
+static uint32_t *terrain_build_vertex_remap(uint32_t level);
+static TerrainChunk *terrain_find_chunk(Terrain *terrain, int32_t x, int32_t z);
+static uint32_t terrain_lod_level(float distance);
+static float chunk_distance(int32_t x, int32_t z, float camera_x, float camera_z);
+static float chunk_lod_distance(int32_t x, int32_t z, const float camera_position[3]);
+static int chunk_request_compare(const void *a, const void *b);
+static bool ray_clip_square(const Ray *ray, float x, float z, float size, float *t_enter, float *t_exit);
+static float ray_triangle(const Ray *ray, const float a[3], const float b[3], const float c[3], float normal[3]);
+
+Terrain *terrain_create(Renderer *renderer, JobSystem *jobs, float view_distance, TerrainVertexLayout vertex_layout) {
+	Terrain *terrain = malloc(sizeof(Terrain));
+
+	*terrain = (Terrain){ .renderer = renderer, .jobs = jobs, .view_distance = view_distance, .vertex_layout = vertex_layout };
+	terrain->vertex_size = vertex_layout == TERRAIN_VERTEX_QUANTIZED ? sizeof(TerrainQuantizedVertex) : sizeof(TerrainVertex);
+	terrain->noise = fnlCreateState();
+	terrain->noise.noise_type = FNL_NOISE_PERLIN;
+	terrain->noise.fractal_type = FNL_FRACTAL_RIDGED;
+	terrain->noise.octaves = 3;
+
+	terrain->chunks = darray_create(sizeof(TerrainChunk), 64);
+	// One cell per chunk column, tall enough for every height the noise produces
+	terrain->grid = chunk_grid_create((float[3]){ TERRAIN_CHUNK_SIZE, 2.f * TERRAIN_HEIGHT_SCALE, TERRAIN_CHUNK_SIZE }, (float[3]){ 0.f, -TERRAIN_HEIGHT_SCALE, 0.f });
+	terrain->requests = darray_create(sizeof(ChunkRequest), 64);
+	terrain->index_buffers = calloc(STITCH_KEY_COUNT, sizeof(TerrainIndexBuffer));
+	terrain->vertices = malloc(CHUNK_VERTEX_BYTES * TERRAIN_CHUNK_LOAD_BUDGET);
+	for (uint32_t level = 0; level < TERRAIN_LOD_COUNT; level++) {
+		terrain->vertex_remap[level] = terrain_build_vertex_remap(level);
+		terrain->height_pools[level] = pool_create(terrain_chunk_heights_size(level), 16);
+	}
+
+	return terrain;
+}
+
+void terrain_destroy(Terrain *terrain) {
+	if (terrain == NULL)
+		return;
+
+	for (uint32_t i = 0; i < darray_length(terrain->chunks); i++)
+		terrain_chunk_release(terrain, &terrain->chunks[i]);
+
+	for (uint32_t i = 0; i < STITCH_KEY_COUNT; i++) {
+		if (terrain->index_buffers[i].buffer)
+			terrain->renderer->buffer_destroy(terrain->renderer, terrain->index_buffers[i].buffer);
+	}
+
+	darray_free(terrain->chunks);
+	chunk_grid_destroy(terrain->grid);
+	darray_free(terrain->requests);
+	free(terrain->index_buffers);
+	free(terrain->vertices);
+	for (uint32_t level = 0; level < TERRAIN_LOD_COUNT; level++) {
+		free(terrain->vertex_remap[level]);
+		pool_destroy(terrain->height_pools[level]);
+	}
+	free(terrain->cull_bounds);
+	free(terrain->cull_visible);
+	free(terrain->mesh_cache_directory);
+	free(terrain);
+}
+
+void terrain_set_mesh_cache(Terrain *terrain, const char *directory) {
+	free(terrain->mesh_cache_directory);
+	terrain->mesh_cache_directory = NULL;
+	if (directory == NULL)
+		return;
+
+	if (!file_create_directories(directory)) {
+		LOG_WARN("Can't create mesh cache [ %s ], chunks won't be cached", directory);
+		return;
+	}
+	size_t size = strlen(directory) + 1;
+	terrain->mesh_cache_directory = malloc(size);
+	memcpy(terrain->mesh_cache_directory, directory, size);
+
+	// Everything that goes into a chunk's vertices besides its coordinates and level
+	const fnl_state *noise = &terrain->noise;
+	const int32_t generator[] = { CHUNK_GENERATOR_VERSION, TERRAIN_CHUNK_SUBDIVISION, noise->seed, noise->noise_type, noise->rotation_type_3d,
+		noise->fractal_type, noise->octaves };
+	const float scales[] = { TERRAIN_CHUNK_SIZE, TERRAIN_HEIGHT_SCALE, noise->frequency, noise->lacunarity, noise->gain, noise->weighted_strength,
+		noise->ping_pong_strength };
+
+	uint64_t key = mesh_cache_hash(MESH_CACHE_HASH_SEED, generator, sizeof(generator));
+	key = mesh_cache_hash(key, scales, sizeof(scales));
+	terrain->mesh_cache_key = mesh_cache_hash_layout(key, g_chunk_attributes[terrain->vertex_layout], 2);
+}
+
+void terrain_update(Terrain *terrain, float camera_position[3]) {
+	const float camera_x = camera_position[0] / TERRAIN_CHUNK_SIZE, camera_z = camera_position[2] / TERRAIN_CHUNK_SIZE;
+	const float radius = terrain->view_distance / TERRAIN_CHUNK_SIZE;
+	bool chunks_changed = false;
+
+	memcpy(terrain->camera_position, camera_position, sizeof(terrain->camera_position));
+
+	// Evict, with one chunk of slack so chunks on the boundary don't get regenerated every other frame
+	for (int32_t i = (int32_t)darray_length(terrain->chunks) - 1; i >= 0; i--) {
+		TerrainChunk *chunk = &terrain->chunks[i];
+		if (chunk_distance(chunk->x, chunk->z, camera_x, camera_z) <= radius + 1.f)
+			continue;
+
+		terrain_chunk_release(terrain, chunk);
+		chunk_grid_remove(terrain->grid, (int32_t[3]){ chunk->x, 0, chunk->z });
+		*chunk = darray_back(terrain->chunks);
+		darray_pop(terrain->chunks);
+		if (i < (int32_t)darray_length(terrain->chunks))
+			chunk_grid_set(terrain->grid, (int32_t[3]){ chunk->x, 0, chunk->z }, (uint32_t)i);
+		chunks_changed = true;
+	}
+
+	// Re-mesh resident chunks whose level is off, with 10% slack so chunks don't flip levels on a threshold
+	darray_reset(terrain->requests);
+	for (uint32_t i = 0; i < darray_length(terrain->chunks); i++) {
+		TerrainChunk *chunk = &terrain->chunks[i];
+		float lod_distance = chunk_lod_distance(chunk->x, chunk->z, camera_position);
+		if (chunk->level >= terrain_lod_level(lod_distance * .9f) && chunk->level <= terrain_lod_level(lod_distance * 1.1f))
+			continue;
+
+		ChunkRequest request = {
+			.x = chunk->x,
+			.z = chunk->z,
+			.level = terrain_lod_level(lod_distance),
+			.resident = (int32_t)i,
+			.distance = chunk_distance(chunk->x, chunk->z, camera_x, camera_z),
+		};
+		darray_push(terrain->requests, request);
+	}
+
+	// Collect missing chunks
+	int32_t min_x = (int32_t)floorf(camera_x - radius), max_x = (int32_t)ceilf(camera_x + radius);
+	int32_t min_z = (int32_t)floorf(camera_z - radius), max_z = (int32_t)ceilf(camera_z + radius);
+	for (int32_t z = min_z; z <= max_z; z++) {
+		for (int32_t x = min_x; x <= max_x; x++) {
+			ChunkRequest request = { .x = x, .z = z, .resident = -1, .distance = chunk_distance(x, z, camera_x, camera_z) };
+			if (request.distance > radius || terrain_find_chunk(terrain, x, z))
+				continue;
+
+			request.level = terrain_lod_level(chunk_lod_distance(x, z, camera_position));
+			darray_push(terrain->requests, request);
+		}
+	}
+
+	// Load the nearest ones first, from the mesh cache when they're in it
+	uint32_t request_count = darray_length(terrain->requests);
+	if (request_count > 0) {
+		qsort(terrain->requests, request_count, sizeof(ChunkRequest), chunk_request_compare);
+
+		TerrainChunk batch_chunks[TERRAIN_CHUNK_LOAD_BUDGET];
+		const ChunkRequest *batch_requests[TERRAIN_CHUNK_LOAD_BUDGET];
+		uint32_t batch_count = 0, mapped_count = 0;
+		for (uint32_t i = 0; i < request_count; i++) {
+			const ChunkRequest *request = &terrain->requests[i];
+			TerrainChunk chunk = { .x = request->x, .z = request->z, .level = request->level };
+
+			if (terrain->mesh_cache_directory) {
+				if (mapped_count == TERRAIN_CHUNK_MAP_BUDGET)
+					break;
+				if (terrain_chunk_map(terrain, &chunk)) {
+					terrain_chunk_place(terrain, request, &chunk);
+					mapped_count++;
+					continue;
+				}
+			}
+
+			if (batch_count == TERRAIN_CHUNK_LOAD_BUDGET)
+				break;
+			batch_requests[batch_count] = request;
+			batch_chunks[batch_count++] = chunk;
+		}
+
+		// Heightmaps are generated in row tiles across the job system, uploads stay on this thread
+		ChunkBatch batch = { .terrain = terrain, .chunks = batch_chunks };
+		job_system_parallel_for(terrain->jobs, batch_count * CHUNK_TILE_COUNT, terrain_chunk_generate_tile, &batch);
+
+		for (uint32_t i = 0; i < batch_count; i++) {
+			TerrainChunk *generated = &batch_chunks[i];
+
+			float min_height = INFINITY, max_height = -INFINITY;
+			for (uint32_t tile = i * CHUNK_TILE_COUNT; tile < (i + 1) * CHUNK_TILE_COUNT; tile++) {
+				min_height = fminf(min_height, batch.tile_heights[tile][0]);
+				max_height = fmaxf(max_height, batch.tile_heights[tile][1]);
+			}
+			generated->bounds = (BoundingBox){
+				.min = { generated->x * TERRAIN_CHUNK_SIZE, min_height, generated->z * TERRAIN_CHUNK_SIZE },
+				.max = { (generated->x + 1) * TERRAIN_CHUNK_SIZE, max_height, (generated->z + 1) * TERRAIN_CHUNK_SIZE },
+			};
+
+			const uint8_t *vertices = terrain->vertices + i * CHUNK_VERTEX_BYTES;
+			if (terrain->mesh_cache_directory)
+				terrain_chunk_cache(terrain, generated, vertices);
+
+			terrain_chunk_upload(terrain, generated, vertices);
+			terrain_chunk_place(terrain, batch_requests[i], generated);
+		}
+		chunks_changed = true;
+	}
+
+	if (chunks_changed)
+		terrain_stitch_chunks(terrain);
+}
+
+uint32_t terrain_draw(Terrain *terrain, const Frustum *frustum, RenderQueue *queue, const RenderPacket *material) {
+	uint32_t chunk_count = darray_length(terrain->chunks);
+
+	if (chunk_count > terrain->cull_capacity) {
+		terrain->cull_capacity = chunk_count * 2;
+		terrain->cull_bounds = realloc(terrain->cull_bounds, sizeof(BoundingBox) * terrain->cull_capacity);
+		terrain->cull_visible = realloc(terrain->cull_visible, sizeof(uint8_t) * terrain->cull_capacity);
+	}
+
+	// Gather the bounds so the frustum test can run over a packed array
+	for (uint32_t i = 0; i < chunk_count; i++) {
+		terrain->cull_bounds[i] = terrain->chunks[i].bounds;
+		terrain->cull_visible[i] = 1;
+	}
+
+	uint32_t drawn = chunk_count;
+	if (frustum)
+		drawn = frustum_test_aabbs(frustum, terrain->cull_bounds, chunk_count, terrain->cull_visible);
+
+	for (uint32_t i = 0; i < chunk_count; i++) {
+		if (!terrain->cull_visible[i])
+			continue;
+
+		TerrainChunk *chunk = &terrain->chunks[i];
+		RenderPacket packet = *material;
+		packet.depth = chunk_lod_distance(chunk->x, chunk->z, terrain->camera_position);
+		packet.vertex_buffer = chunk->vertex_buffer;
+		if (terrain->vertex_layout == TERRAIN_VERTEX_QUANTIZED) {
+			terrain_chunk_model(chunk, material->model, chunk->model);
+			packet.model = chunk->model;
+		}
+		packet.index_buffer = chunk->indices->buffer;
+		packet.instance_buffer = NULL;
+		packet.count = chunk->indices->count;
+		packet.instance_count = 0;
+		render_queue_push(queue, &packet);
+	}
+
+	return drawn;
+}
+
+bool terrain_raycast(const Terrain *terrain, const Ray *ray, float max_distance, RayHit *hit) {
+	TerrainRaycast cast = { .terrain = terrain, .ray = ray, .max_distance = max_distance, .hit = hit };
+
+	// Chunks come nearest first and don't overlap in xz, so the first hit is the nearest one
+	chunk_grid_query_ray(terrain->grid, ray->origin, ray->direction, max_distance, terrain_raycast_chunk, &cast);
+	return cast.found;
+}
+
+uint32_t terrain_raycast_batch(const Terrain *terrain, const Ray *rays, uint32_t count, float max_distance, RayHit *hits) {
+	TerrainRaycastBatch batch = { .terrain = terrain, .rays = rays, .count = count, .max_distance = max_distance, .hits = hits };
+	job_system_parallel_for(terrain->jobs, (count + RAYS_PER_JOB - 1) / RAYS_PER_JOB, terrain_raycast_job, &batch);
+
+	uint32_t hit_count = 0;
+	for (uint32_t i = 0; i < count; i++)
+		hit_count += hits[i].distance < INFINITY;
+	return hit_count;
+}
+
+uint32_t terrain_chunk_count(Terrain *terrain) {
+	return darray_length(terrain->chunks);
+}
+
+uint32_t terrain_triangle_count(Terrain *terrain) {
+	uint32_t triangle_count = 0;
+	for (uint32_t i = 0; i < darray_length(terrain->chunks); i++)
+		triangle_count += terrain->chunks[i].indices->count / 3;
+
+	return triangle_count;
+}
+
+void terrain_chunk_generate_tile(void *user_data, uint32_t index) {
+	ChunkBatch *batch = (ChunkBatch *)user_data;
+	Terrain *terrain = batch->terrain;
+	const TerrainChunk *chunk = &batch->chunks[index / CHUNK_TILE_COUNT];
+
+	// Coarser levels have fewer rows, so their trailing tiles have nothing to do
+	const int32_t quads = TERRAIN_CHUNK_SUBDIVISION >> chunk->level, step = 1 << chunk->level;
+	const int32_t row_begin = (index % CHUNK_TILE_COUNT) * TILE_ROWS;
+	const int32_t row_end = row_begin + TILE_ROWS < quads + 1 ? row_begin + TILE_ROWS : quads + 1;
+
+	const float spacing = TERRAIN_CHUNK_SIZE / TERRAIN_CHUNK_SUBDIVISION;
+	const int32_t grid_x = chunk->x * TERRAIN_CHUNK_SUBDIVISION, grid_z = chunk->z * TERRAIN_CHUNK_SUBDIVISION;
+
+	// Positions are sampled on the level 0 grid, so a coarse vertex has the exact height of the fine vertex it covers.
+	// Every vertex only depends on its global grid position, so neither the tile split nor the neighbours change it
+	uint8_t *vertices = terrain->vertices + (index / CHUNK_TILE_COUNT) * CHUNK_VERTEX_BYTES;
+	const uint32_t *remap = terrain->vertex_remap[chunk->level];
+	float min_height = INFINITY, max_height = -INFINITY;
+	for (int32_t z = row_begin; z < row_end; z++) {
+		float heights[CHUNK_VERTICES_PER_SIDE];
+		noise_fill_row(&terrain->noise, grid_x * .5f, step * .5f, (grid_z + z * step) * .5f, quads + 1, heights);
+
+		for (int32_t x = 0; x <= quads; x++) {
+			int32_t global_x = grid_x + x * step, global_z = grid_z + z * step;
+			float height = heights[x] * TERRAIN_HEIGHT_SCALE;
+			min_height = fminf(min_height, height);
+			max_height = fmaxf(max_height, height);
+
+			if (terrain->vertex_layout == TERRAIN_VERTEX_QUANTIZED) {
+				// x * step / TERRAIN_CHUNK_SUBDIVISION is exact, so chunk edges and the vertices shared between levels
+				// quantize to the same value on both sides
+				TerrainQuantizedVertex *vertex = (TerrainQuantizedVertex *)vertices + remap[x + z * (quads + 1)];
+				vertex->position[0] = vertex_pack_snorm16((float)(x * step) / TERRAIN_CHUNK_SUBDIVISION * 2.f - 1.f);
+				vertex->position[1] = vertex_pack_snorm16(heights[x]);
+				vertex->position[2] = vertex_pack_snorm16((float)(z * step) / TERRAIN_CHUNK_SUBDIVISION * 2.f - 1.f);
+				vertex->position[3] = 0;
+				vertex->uv[0] = vertex_pack_half((float)x / quads);
+				vertex->uv[1] = vertex_pack_half((float)z / quads);
+			} else {
+				TerrainVertex *vertex = (TerrainVertex *)vertices + remap[x + z * (quads + 1)];
+				vertex->position[0] = global_x * spacing;
+				vertex->position[1] = height;
+				vertex->position[2] = global_z * spacing;
+				vertex->uv[0] = (float)x / quads;
+				vertex->uv[1] = (float)z / quads;
+			}
+		}
+	}
+
+	batch->tile_heights[index][0] = min_height;
+	batch->tile_heights[index][1] = max_height;
+}
+
+void terrain_chunk_upload(Terrain *terrain, TerrainChunk *chunk, const void *vertices) {
+	Renderer *renderer = terrain->renderer;
+	chunk->vertex_buffer = renderer->buffer_create(renderer, BUFFER_TYPE_VERTEX, terrain_chunk_vertices_size(terrain, chunk->level), (void *)vertices);
+	renderer->buffer_set_layout(renderer, chunk->vertex_buffer, g_chunk_attributes[terrain->vertex_layout], 2);
+	chunk->indices = NULL;
+	terrain_chunk_read_heights(terrain, chunk, vertices);
+}
+
+// Uploads the chunk straight from its mapped cache file, false if it isn't cached
+bool terrain_chunk_map(Terrain *terrain, TerrainChunk *chunk) {
+	char path[512];
+	uint64_t key = terrain_chunk_key(terrain, chunk, path, sizeof(path));
+
+	CachedMesh mesh;
+	if (!mesh_cache_map(path, key, &mesh))
+		return false;
+
+	bool valid = mesh.vertices_size == terrain_chunk_vertices_size(terrain, chunk->level);
+	if (valid) {
+		chunk->bounds = mesh.bounds;
+		terrain_chunk_upload(terrain, chunk, mesh.vertices);
+	}
+
+	mesh_cache_unmap(&mesh);
+	return valid;
+}
+
+void terrain_chunk_cache(Terrain *terrain, const TerrainChunk *chunk, const void *vertices) {
+	char path[512];
+	uint64_t key = terrain_chunk_key(terrain, chunk, path, sizeof(path));
+
+	// Index buffers are shared between chunks and cheap to build, only the vertices are worth caching
+	CachedMesh mesh = {
+		.attribute_count = 2,
+		.bounds = chunk->bounds,
+		.vertices = vertices,
+		.vertices_size = terrain_chunk_vertices_size(terrain, chunk->level),
+	};
+	memcpy(mesh.attributes, g_chunk_attributes[terrain->vertex_layout], sizeof(g_chunk_attributes[0]));
+	mesh_cache_write(path, key, &mesh);
+}
+
+// material_model (identity if NULL) times the transform from quantized chunk space to world space
+void terrain_chunk_model(const TerrainChunk *chunk, const float *material_model, float model[16]) {
+	static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	const float *m = material_model ? material_model : identity;
+	const float scale[3] = { TERRAIN_CHUNK_SIZE * .5f, TERRAIN_HEIGHT_SCALE, TERRAIN_CHUNK_SIZE * .5f };
+	const float center_x = (chunk->x + .5f) * TERRAIN_CHUNK_SIZE, center_z = (chunk->z + .5f) * TERRAIN_CHUNK_SIZE;
+
+	// Column major, the chunk transform only scales the axes and translates in xz
+	for (uint32_t row = 0; row < 4; row++) {
+		model[0 + row] = m[0 + row] * scale[0];
+		model[4 + row] = m[4 + row] * scale[1];
+		model[8 + row] = m[8 + row] * scale[2];
+		model[12 + row] = m[0 + row] * center_x + m[8 + row] * center_z + m[12 + row];
+	}
+}
+
+size_t terrain_chunk_vertices_size(Terrain *terrain, uint32_t level) {
+	uint32_t vertices_per_side = (TERRAIN_CHUNK_SUBDIVISION >> level) + 1;
+	return (size_t)terrain->vertex_size * vertices_per_side * vertices_per_side;
+}
+
+// Bytes of a chunk's heights and height pyramid
+size_t terrain_chunk_heights_size(uint32_t level) {
+	const uint32_t quads = TERRAIN_CHUNK_SUBDIVISION >> level, columns = quads + 1;
+
+	size_t float_count = columns * columns;
+	for (uint32_t side = quads; side > 0; side >>= 1)
+		float_count += side * side * 2;
+	return sizeof(float) * float_count;
+}
+
+// Takes over the resident chunk the request re-meshes, or adds a new one
+void terrain_chunk_place(Terrain *terrain, const ChunkRequest *request, TerrainChunk *chunk) {
+	if (request->resident >= 0) {
+		TerrainChunk *resident = &terrain->chunks[request->resident];
+		terrain_chunk_release(terrain, resident);
+		*resident = *chunk;
+	} else {
+		chunk_grid_set(terrain->grid, (int32_t[3]){ chunk->x, 0, chunk->z }, darray_length(terrain->chunks));
+		darray_push(terrain->chunks, *chunk);
+	}
+}
+
+uint64_t terrain_chunk_key(Terrain *terrain, const TerrainChunk *chunk, char *path, size_t path_size) {
+	const int32_t coordinates[] = { chunk->x, chunk->z, (int32_t)chunk->level };
+	uint64_t key = mesh_cache_hash(terrain->mesh_cache_key, coordinates, sizeof(coordinates));
+
+	mesh_cache_path(terrain->mesh_cache_directory, key, path, path_size);
+	return key;
+}
+
+void terrain_chunk_release(Terrain *terrain, TerrainChunk *chunk) {
+	terrain->renderer->buffer_destroy(terrain->renderer, chunk->vertex_buffer);
+	chunk->vertex_buffer = NULL;
+	pool_free(terrain->height_pools[chunk->level], chunk->heights);
+	chunk->heights = NULL;
+}
+
+// Reads the heights back out of the vertices, the same way for generated and mapped chunks, and builds the pyramid
+void terrain_chunk_read_heights(Terrain *terrain, TerrainChunk *chunk, const void *vertices) {
+	const uint32_t quads = TERRAIN_CHUNK_SUBDIVISION >> chunk->level, columns = quads + 1;
+	const uint32_t *remap = terrain->vertex_remap[chunk->level];
+	float *heights = pool_alloc(terrain->height_pools[chunk->level], NULL);
+
+	for (uint32_t i = 0; i < columns * columns; i++) {
+		if (terrain->vertex_layout == TERRAIN_VERTEX_QUANTIZED) {
+			float height = ((const TerrainQuantizedVertex *)vertices)[remap[i]].position[1] / 32767.f;
+			heights[i] = fmaxf(height, -1.f) * TERRAIN_HEIGHT_SCALE;
+		} else {
+			heights[i] = ((const TerrainVertex *)vertices)[remap[i]].position[1];
+		}
+	}
+
+	float *bounds = heights + columns * columns;
+	for (uint32_t z = 0; z < quads; z++) {
+		for (uint32_t x = 0; x < quads; x++) {
+			const float *corner = &heights[x + z * columns];
+			float *quad = &bounds[(x + z * quads) * 2];
+			quad[0] = fminf(fminf(corner[0], corner[1]), fminf(corner[columns], corner[columns + 1]));
+			quad[1] = fmaxf(fmaxf(corner[0], corner[1]), fmaxf(corner[columns], corner[columns + 1]));
+		}
+	}
+	for (uint32_t side = quads; side > 1; side >>= 1) {
+		float *parents = bounds + side * side * 2;
+		for (uint32_t z = 0; z < side / 2; z++) {
+			for (uint32_t x = 0; x < side / 2; x++) {
+				const float *child = &bounds[(x * 2 + z * 2 * side) * 2];
+				float *parent = &parents[(x + z * side / 2) * 2];
+				parent[0] = fminf(fminf(child[0], child[2]), fminf(child[side * 2], child[side * 2 + 2]));
+				parent[1] = fmaxf(fmaxf(child[1], child[3]), fmaxf(child[side * 2 + 1], child[side * 2 + 3]));
+			}
+		}
+		bounds = parents;
+	}
+
+	chunk->heights = heights;
+}
+
+bool terrain_raycast_chunk(void *user_data, const int32_t cell[3], uint32_t value) {
+	TerrainRaycast *cast = user_data;
+	const TerrainChunk *chunk = &cast->terrain->chunks[value];
+	(void)cell;
+
+	cast->quads = TERRAIN_CHUNK_SUBDIVISION >> chunk->level;
+	cast->spacing = TERRAIN_CHUNK_SIZE / cast->quads;
+	cast->corner[0] = chunk->x * TERRAIN_CHUNK_SIZE;
+	cast->corner[1] = chunk->z * TERRAIN_CHUNK_SIZE;
+	cast->heights = chunk->heights;
+
+	uint32_t mip = 0;
+	const float *bounds = chunk->heights + (cast->quads + 1) * (cast->quads + 1);
+	for (uint32_t side = cast->quads; side > 0; side >>= 1) {
+		cast->height_bounds[mip++] = bounds;
+		bounds += side * side * 2;
+	}
+
+	float t_enter = 0.f, t_exit = cast->max_distance;
+	if (!ray_clip_square(cast->ray, cast->corner[0], cast->corner[1], TERRAIN_CHUNK_SIZE, &t_enter, &t_exit))
+		return true;
+
+	cast->found = terrain_raycast_node(cast, mip - 1, 0, 0, t_enter, t_exit);
+	return !cast->found;
+}
+
+// Skips the node if the ray passes above or below its height range while over it, otherwise descends into the children
+// it crosses in the order it crosses them. They don't overlap in xz, so the first hit found is the nearest
+bool terrain_raycast_node(TerrainRaycast *cast, uint32_t mip, uint32_t x, uint32_t z, float t_enter, float t_exit) {
+	const Ray *ray = cast->ray;
+	const float *bounds = &cast->height_bounds[mip][(x + z * (cast->quads >> mip)) * 2];
+	const float y_enter = ray->origin[1] + ray->direction[1] * t_enter, y_exit = ray->origin[1] + ray->direction[1] * t_exit;
+	const float epsilon = 1e-3f; // Keeps rays that graze a node from slipping through between neighbours
+	if (fminf(y_enter, y_exit) > bounds[1] + epsilon || fmaxf(y_enter, y_exit) < bounds[0] - epsilon)
+		return false;
+
+	if (mip == 0)
+		return terrain_raycast_quad(cast, x, z);
+
+	HeightNode children[4];
+	uint32_t child_count = 0;
+	const float child_size = cast->spacing * (float)(1u << (mip - 1));
+	for (uint32_t i = 0; i < 4; i++) {
+		HeightNode child = { .x = x * 2 + (i & 1), .z = z * 2 + (i >> 1), .t_enter = t_enter, .t_exit = t_exit };
+		if (!ray_clip_square(ray, cast->corner[0] + child.x * child_size, cast->corner[1] + child.z * child_size, child_size, &child.t_enter, &child.t_exit))
+			continue;
+
+		uint32_t slot = child_count++;
+		for (; slot > 0 && children[slot - 1].t_enter > child.t_enter; slot--)
+			children[slot] = children[slot - 1];
+		children[slot] = child;
+	}
+
+	for (uint32_t i = 0; i < child_count; i++) {
+		if (terrain_raycast_node(cast, mip - 1, children[i].x, children[i].z, children[i].t_enter, children[i].t_exit))
+			return true;
+	}
+	return false;
+}
+
+// The quad's two triangles, split the way terrain_build_indices splits it
+bool terrain_raycast_quad(TerrainRaycast *cast, uint32_t x, uint32_t z) {
+	const uint32_t columns = cast->quads + 1;
+	const float *heights = &cast->heights[x + z * columns];
+	const float x0 = cast->corner[0] + x * cast->spacing, z0 = cast->corner[1] + z * cast->spacing;
+	const float x1 = x0 + cast->spacing, z1 = z0 + cast->spacing;
+
+	const float corner_00[3] = { x0, heights[0], z0 }, corner_10[3] = { x1, heights[1], z0 };
+	const float corner_01[3] = { x0, heights[columns], z1 }, corner_11[3] = { x1, heights[columns + 1], z1 };
+
+	float normals[2][3];
+	float distances[2] = {
+		ray_triangle(cast->ray, corner_10, corner_00, corner_01, normals[0]),
+		ray_triangle(cast->ray, corner_10, corner_01, corner_11, normals[1]),
+	};
+	uint32_t nearest = distances[1] < distances[0];
+	if (distances[nearest] > cast->max_distance)
+		return false;
+
+	const Ray *ray = cast->ray;
+	RayHit *hit = cast->hit;
+	hit->distance = distances[nearest];
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		hit->position[axis] = ray->origin[axis] + ray->direction[axis] * hit->distance;
+		hit->normal[axis] = normals[nearest][axis];
+	}
+	return true;
+}
+
+void terrain_raycast_job(void *user_data, uint32_t index) {
+	TerrainRaycastBatch *batch = user_data;
+	const uint32_t end = (index + 1) * RAYS_PER_JOB < batch->count ? (index + 1) * RAYS_PER_JOB : batch->count;
+
+	for (uint32_t i = index * RAYS_PER_JOB; i < end; i++) {
+		if (!terrain_raycast(batch->terrain, &batch->rays[i], batch->max_distance, &batch->hits[i]))
+			batch->hits[i] = (RayHit){ .distance = INFINITY };
+	}
+}
+
+void terrain_stitch_chunks(Terrain *terrain) {
+	static const int32_t side_offsets[SIDE_COUNT][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+
+	// The finer chunk of each pair drops its in-between edge vertices, missing neighbours count as the same level
+	for (uint32_t i = 0; i < darray_length(terrain->chunks); i++) {
+		TerrainChunk *chunk = &terrain->chunks[i];
+
+		uint32_t coarser[SIDE_COUNT];
+		for (uint32_t side = 0; side < SIDE_COUNT; side++) {
+			TerrainChunk *neighbour = terrain_find_chunk(terrain, chunk->x + side_offsets[side][0], chunk->z + side_offsets[side][1]);
+			coarser[side] = neighbour && neighbour->level > chunk->level ? neighbour->level - chunk->level : 0;
+		}
+
+		chunk->indices = terrain_index_buffer(terrain, chunk->level, coarser);
+	}
+}
+
+const TerrainIndexBuffer *terrain_index_buffer(Terrain *terrain, uint32_t level, const uint32_t coarser[SIDE_COUNT]) {
+	uint32_t key = level;
+	for (uint32_t side = 0; side < SIDE_COUNT; side++)
+		key = key * TERRAIN_LOD_COUNT + coarser[side];
+
+	TerrainIndexBuffer *index_buffer = &terrain->index_buffers[key];
+	if (index_buffer->buffer)
+		return index_buffer;
+
+	uint32_t quads = TERRAIN_CHUNK_SUBDIVISION >> level, vertex_count = (quads + 1) * (quads + 1);
+	uint32_t *indices = malloc(sizeof(uint32_t) * quads * quads * 6);
+	index_buffer->count = terrain_build_indices(quads, coarser, indices);
+	mesh_remap_indices(indices, index_buffer->count, terrain->vertex_remap[level]);
+
+	float acmr = mesh_acmr(indices, index_buffer->count, vertex_count);
+	mesh_optimize_vertex_cache(indices, index_buffer->count, vertex_count);
+	LOG_DEBUG("Terrain index buffer %u: %u triangles, ACMR %.3f -> %.3f", key, index_buffer->count / 3, acmr,
+			  mesh_acmr(indices, index_buffer->count, vertex_count));
+
+	Renderer *renderer = terrain->renderer;
+	if (mesh_indices_fit_16(vertex_count)) {
+		mesh_indices_to_16(indices, index_buffer->count, (uint16_t *)indices);
+		index_buffer->buffer = renderer->buffer_create(renderer, BUFFER_TYPE_INDEX16, sizeof(uint16_t) * index_buffer->count, indices);
+	} else {
+		index_buffer->buffer = renderer->buffer_create(renderer, BUFFER_TYPE_INDEX, sizeof(uint32_t) * index_buffer->count, indices);
+	}
+	free(indices);
+
+	return index_buffer;
+}
+
+// Emits a, b, c with the same winding as the regular grid triangles, whatever order they were passed in
+static void emit_triangle(uint32_t *indices, uint32_t *indices_ptr, uint32_t quads, const int32_t a[2], const int32_t b[2], const int32_t c[2]) {
+	const int32_t cross = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+	const int32_t *second = cross > 0 ? c : b, *third = cross > 0 ? b : c;
+
+	indices[(*indices_ptr)++] = a[0] + a[1] * (quads + 1);
+	indices[(*indices_ptr)++] = second[0] + second[1] * (quads + 1);
+	indices[(*indices_ptr)++] = third[0] + third[1] * (quads + 1);
+}
+
+/*
+ * Triangulates the strip between a chunk edge that only keeps every step-th vertex (outer) and the full
+ * resolution row one quad in (inner), walking both by their position along the edge.
+ * axis is the grid axis the edge runs along, the other coordinate of each row is fixed.
+ */
+static void emit_stitch_strip(uint32_t *indices, uint32_t *indices_ptr, uint32_t quads, uint32_t axis, int32_t outer, int32_t inner, int32_t step, int32_t inner_begin, int32_t inner_end) {
+	int32_t outer_position = 0, inner_position = inner_begin;
+
+	while (outer_position < (int32_t)quads || inner_position < inner_end) {
+		int32_t a[2], b[2], c[2];
+		a[axis] = outer_position, a[!axis] = outer;
+		b[axis] = inner_position, b[!axis] = inner;
+
+		bool advance_inner = outer_position >= (int32_t)quads || (inner_position < inner_end && inner_position + 1 <= outer_position + step);
+		if (advance_inner) {
+			c[axis] = ++inner_position, c[!axis] = inner;
+		} else {
+			outer_position += step;
+			c[axis] = outer_position, c[!axis] = outer;
+		}
+		emit_triangle(indices, indices_ptr, quads, a, b, c);
+	}
+}
+
+uint32_t terrain_build_indices(uint32_t quads, const uint32_t coarser[SIDE_COUNT], uint32_t *indices) {
+	uint32_t indices_ptr = 0;
+	const uint32_t columns = quads + 1;
+
+	// The row of quads along every stitched side is replaced by a strip that meets the coarser neighbour's edge
+	const int32_t x_begin = coarser[SIDE_WEST] ? 1 : 0, x_end = coarser[SIDE_EAST] ? quads - 1 : quads;
+	const int32_t z_begin = coarser[SIDE_NORTH] ? 1 : 0, z_end = coarser[SIDE_SOUTH] ? quads - 1 : quads;
+
+	for (int32_t z = z_begin; z < z_end; z++) {
+		for (int32_t x = x_begin; x < x_end; x++) {
+			uint32_t index = x + z * columns;
+
+			indices[indices_ptr++] = index + 1;
+			indices[indices_ptr++] = index;
+			indices[indices_ptr++] = index + columns;
+
+			indices[indices_ptr++] = index + 1;
+			indices[indices_ptr++] = index + columns;
+			indices[indices_ptr++] = index + columns + 1;
+		}
+	}
+
+	// Neighbouring strips share the diagonal from the chunk corner to the first inner vertex, so corners stay closed
+	if (coarser[SIDE_NORTH])
+		emit_stitch_strip(indices, &indices_ptr, quads, 0, 0, 1, 1 << coarser[SIDE_NORTH], x_begin, x_end);
+	if (coarser[SIDE_SOUTH])
+		emit_stitch_strip(indices, &indices_ptr, quads, 0, quads, quads - 1, 1 << coarser[SIDE_SOUTH], x_begin, x_end);
+	if (coarser[SIDE_WEST])
+		emit_stitch_strip(indices, &indices_ptr, quads, 1, 0, 1, 1 << coarser[SIDE_WEST], z_begin, z_end);
+	if (coarser[SIDE_EAST])
+		emit_stitch_strip(indices, &indices_ptr, quads, 1, quads, quads - 1, 1 << coarser[SIDE_EAST], z_begin, z_end);
+
+	return indices_ptr;
+}
+
+// Vertices of a level are stored in the order the cache optimized, unstitched triangles first use them. Stitching only
+// drops edge vertices, so every index buffer of the level reads the buffer in close to that order too
+uint32_t *terrain_build_vertex_remap(uint32_t level) {
+	const uint32_t unstitched[SIDE_COUNT] = { 0 };
+	uint32_t quads = TERRAIN_CHUNK_SUBDIVISION >> level, vertex_count = (quads + 1) * (quads + 1);
+
+	uint32_t *indices = malloc(sizeof(uint32_t) * quads * quads * 6);
+	uint32_t index_count = terrain_build_indices(quads, unstitched, indices);
+	mesh_optimize_vertex_cache(indices, index_count, vertex_count);
+
+	uint32_t *remap = malloc(sizeof(uint32_t) * vertex_count);
+	mesh_vertex_fetch_remap(indices, index_count, vertex_count, remap);
+	free(indices);
+
+	return remap;
+}
+
+TerrainChunk *terrain_find_chunk(Terrain *terrain, int32_t x, int32_t z) {
+	uint32_t index;
+	if (!chunk_grid_get(terrain->grid, (int32_t[3]){ x, 0, z }, &index))
+		return NULL;
+
+	return &terrain->chunks[index];
+}
+
+// Level 0 below TERRAIN_LOD_DISTANCE, then one level coarser every time the distance doubles
+uint32_t terrain_lod_level(float distance) {
+	uint32_t level = 0;
+	while (level + 1 < TERRAIN_LOD_COUNT && distance >= TERRAIN_LOD_DISTANCE * (float)(1u << level))
+		level++;
+
+	return level;
+}
+
+float chunk_distance(int32_t x, int32_t z, float camera_x, float camera_z) {
+	float dx = (x + .5f) - camera_x, dz = (z + .5f) - camera_z;
+	return sqrtf(dx * dx + dz * dz);
+}
+
+float chunk_lod_distance(int32_t x, int32_t z, const float camera_position[3]) {
+	float dx = (x + .5f) * TERRAIN_CHUNK_SIZE - camera_position[0];
+	float dz = (z + .5f) * TERRAIN_CHUNK_SIZE - camera_position[2];
+	return sqrtf(dx * dx + camera_position[1] * camera_position[1] + dz * dz);
+}
+
+int chunk_request_compare(const void *a, const void *b) {
+	float distance_a = ((const ChunkRequest *)a)->distance, distance_b = ((const ChunkRequest *)b)->distance;
+	return (distance_a > distance_b) - (distance_a < distance_b);
+}
+
+// Narrows [t_enter, t_exit] to where the ray is over the square from (x, z) to (x + size, z + size), false if it's never
+bool ray_clip_square(const Ray *ray, float x, float z, float size, float *t_enter, float *t_exit) {
+	const float low[2] = { x, z };
+
+	for (uint32_t i = 0; i < 2; i++) {
+		const float origin = ray->origin[i * 2], direction = ray->direction[i * 2];
+		if (direction == 0.f) {
+			if (origin < low[i] || origin > low[i] + size)
+				return false;
+			continue;
+		}
+
+		float t0 = (low[i] - origin) / direction, t1 = (low[i] + size - origin) / direction;
+		if (t0 > t1) {
+			float swap = t0;
+			t0 = t1, t1 = swap;
+		}
+		*t_enter = fmaxf(*t_enter, t0);
+		*t_exit = fminf(*t_exit, t1);
+	}
+
+	return *t_enter <= *t_exit;
+}
+
+// Moller-Trumbore, returns the distance along the ray to triangle abc or INFINITY. Writes the unit normal of abc,
+// which faces up for the counterclockwise terrain triangles
+float ray_triangle(const Ray *ray, const float a[3], const float b[3], const float c[3], float normal[3]) {
+	const float epsilon = 1e-6f; // Lets hits on a shared edge through on both sides rather than neither
+	const float *d = ray->direction;
+	const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+	const float p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+	const float determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+	if (fabsf(determinant) < 1e-12f)
+		return INFINITY;
+
+	const float inverse = 1.f / determinant;
+	const float s[3] = { ray->origin[0] - a[0], ray->origin[1] - a[1], ray->origin[2] - a[2] };
+	const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+	if (u < -epsilon || u > 1.f + epsilon)
+		return INFINITY;
+
+	const float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+	const float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverse;
+	if (v < -epsilon || u + v > 1.f + epsilon)
+		return INFINITY;
+
+	const float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+	if (t < 0.f)
+		return INFINITY;
+
+	normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	for (uint32_t axis = 0; axis < 3; axis++)
+		normal[axis] /= length;
+	return t;
+}
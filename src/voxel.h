@@ -0,0 +1,156 @@
+#pragma once
+
+#include "base/job_system.h"
+#include "renderer.h"
+
+#include <fnl/FastNoiseLite.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VOXEL_CHUNK_SIZE	 32 // Blocks per chunk side
+#define VOXEL_CHUNK_VOLUME	 (VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE)
+#define VOXEL_SECTION_HEIGHT 8 // Block layers per section, the unit chunks are re-meshed in
+#define VOXEL_CHUNK_SECTIONS (VOXEL_CHUNK_SIZE / VOXEL_SECTION_HEIGHT)
+#define VOXEL_REMESH_BUDGET	 16 // Max chunks re-meshed by one background batch
+
+typedef uint16_t BlockId;
+
+typedef enum {
+	BLOCK_AIR, // The only block faces are never drawn against
+	BLOCK_STONE,
+	BLOCK_DIRT,
+	BLOCK_GRASS,
+	BLOCK_SAND,
+
+	BLOCK_COUNT
+} BlockType;
+
+typedef enum {
+	VOXEL_FACE_POSITIVE_X,
+	VOXEL_FACE_NEGATIVE_X,
+	VOXEL_FACE_POSITIVE_Y,
+	VOXEL_FACE_NEGATIVE_Y,
+	VOXEL_FACE_POSITIVE_Z,
+	VOXEL_FACE_NEGATIVE_Z,
+
+	VOXEL_FACE_COUNT
+} VoxelFace;
+
+typedef struct _voxel_chunk VoxelChunk;
+typedef struct _voxel_mesher VoxelMesher;
+typedef struct _voxel_world VoxelWorld;
+
+// 8 bytes, read through voxel_vertex_attributes
+typedef struct {
+	uint8_t position[4]; // xyz in [0, VOXEL_CHUNK_SIZE] relative to the chunk corner, w = VoxelFace
+	uint16_t block; // BlockId
+	uint8_t uv[2]; // In blocks, so textures repeat across merged faces
+} VoxelVertex;
+
+// 4 vertices per quad, drawn with the indices of voxel_quad_indices. The array belongs to the mesher that produced it
+typedef struct {
+	VoxelVertex *vertices;
+	uint32_t quad_count;
+} VoxelMesh;
+
+extern VertexAttribute voxel_vertex_attributes[2]; // a_voxel (UINT8x4) and a_block (UINT16x2, block and uv)
+
+/**
+ * ===========================================================================================
+ * -------- Chunk
+ * ===========================================================================================
+ **/
+
+// Blocks are stored as indices into a per-chunk palette, packed at the fewest bits (0, 1, 2, 4, 8 or 16) that address
+// it, so a chunk of one block type takes no block storage at all and a typical terrain chunk 2 or 4 bits per block
+VoxelChunk *voxel_chunk_create(void); // All air
+void voxel_chunk_destroy(VoxelChunk *chunk);
+
+BlockId voxel_chunk_get(const VoxelChunk *chunk, uint32_t x, uint32_t y, uint32_t z);
+// Grows the palette (and the bits per block) when block is new to the chunk. Blocks that stop being used keep their
+// palette entry until the next voxel_chunk_pack
+void voxel_chunk_set(VoxelChunk *chunk, uint32_t x, uint32_t y, uint32_t z, BlockId block);
+
+// Dense copies, blocks[x + y * VOXEL_CHUNK_SIZE + z * VOXEL_CHUNK_SIZE^2]. Packing rebuilds the palette from scratch
+void voxel_chunk_unpack(const VoxelChunk *chunk, BlockId *blocks);
+void voxel_chunk_pack(VoxelChunk *chunk, const BlockId *blocks);
+
+uint32_t voxel_chunk_palette_size(const VoxelChunk *chunk);
+size_t voxel_chunk_memory(const VoxelChunk *chunk); // Bytes, including the palette
+bool voxel_chunk_is_empty(const VoxelChunk *chunk); // Only air
+
+// Heightmap terrain from noise for the chunk at chunk coordinates (chunk_x, chunk_y, chunk_z): grass over a few blocks
+// of dirt over stone, sand close to sea level. height_scale is the block height noise 1 maps to
+void voxel_chunk_generate(VoxelChunk *chunk, const fnl_state *noise, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, float height_scale);
+
+/**
+ * ===========================================================================================
+ * -------- Mesher
+ * ===========================================================================================
+ **/
+
+// Scratch space for meshing one chunk at a time, use one per thread
+VoxelMesher *voxel_mesher_create(void);
+void voxel_mesher_destroy(VoxelMesher *mesher);
+
+// Emits the faces of chunk that touch air, merging coplanar faces of the same block into rectangles. neighbours[face]
+// is the chunk on that side, faces towards a NULL neighbour are emitted. The mesh stays valid until the next call
+void voxel_mesh_greedy(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT], VoxelMesh *mesh);
+// voxel_mesh_greedy for the sections set in section_mask only (bit i covers the block layers from
+// i * VOXEL_SECTION_HEIGHT), meshes[i] gets the faces of the blocks in section i. Faces don't merge across sections
+void voxel_mesh_greedy_sections(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT], uint32_t section_mask,
+								VoxelMesh meshes[VOXEL_CHUNK_SECTIONS]);
+// One quad per visible face, the baseline voxel_mesh_greedy is measured against
+void voxel_mesh_naive(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT], VoxelMesh *mesh);
+
+// Two triangles (0, 1, 2) and (0, 2, 3) per quad, so every mesh can share one index buffer
+void voxel_quad_indices(uint32_t quad_count, uint32_t *indices);
+
+/**
+ * ===========================================================================================
+ * -------- World
+ * ===========================================================================================
+ **/
+
+// Cumulative since the world was created, except dirty_chunks
+typedef struct {
+	uint32_t dirty_chunks; // Waiting for a re-mesh as of the last voxel_world_update
+	uint64_t batches, chunks_remeshed, sections_remeshed;
+	uint64_t buffer_updates, buffer_swaps; // Meshes that rewrote their chunk's buffer, and ones that outgrew it
+	double remesh_seconds, max_remesh_seconds; // Wall time from dispatching a batch to finding it done
+} VoxelWorldStats;
+
+typedef struct {
+	RayHit hit; // The normal points out of the face the ray entered the block through
+	int32_t block[3]; // Block coordinates, as voxel_world_get_block takes them
+	BlockId block_id;
+} VoxelRayHit;
+
+// size[0] x size[1] x size[2] chunks of blocks block_size units wide, centred on the origin in x and z with the bottom
+// at y = 0. Chunks are generated with voxel_chunk_generate up front, their meshes are built by voxel_world_update
+VoxelWorld *voxel_world_create(Renderer *renderer, JobSystem *jobs, const uint32_t size[3], float block_size, const fnl_state *noise, float height_scale);
+void voxel_world_destroy(VoxelWorld *world);
+
+// Block coordinates count from the world corner, blocks outside the world are air
+BlockId voxel_world_get_block(const VoxelWorld *world, int32_t x, int32_t y, int32_t z);
+// Marks the sections whose faces the block touches dirty, in its chunk and across chunk borders. Edits made while a
+// re-mesh runs are applied once it finished, voxel_world_get_block doesn't see them until then
+void voxel_world_set_block(VoxelWorld *world, int32_t x, int32_t y, int32_t z, BlockId block);
+
+// Nearest solid block within max_distance, stepping block by block along ray (3D DDA) from where it enters the world.
+// Blocks are only read in chunks that have any, so the cost is the number of blocks crossed. Sees what
+// voxel_world_get_block sees
+bool voxel_world_raycast(const VoxelWorld *world, const Ray *ray, float max_distance, VoxelRayHit *hit);
+// voxel_world_raycast for every ray, spread across the job system. Misses get a distance of INFINITY, returns the hit count
+uint32_t voxel_world_raycast_batch(const VoxelWorld *world, const Ray *rays, uint32_t count, float max_distance, VoxelRayHit *hits);
+
+// Uploads the meshes of a finished background re-mesh and starts the next one on the dirty chunks nearest to
+// camera_position. Only the dirty sections are meshed again. A mesh that fits its chunk's buffer rewrites all of it (the
+// backend orphans the old storage, draws in flight keep reading it) while one that doesn't gets a new buffer swapped in,
+// so neither the draw nor the upload waits on the other
+void voxel_world_update(VoxelWorld *world, const float camera_position[3]);
+// Queues the chunks with faces that intersect frustum (every one if it's NULL) and returns how many were queued. Packets
+// copy their pass, shader, textures and model from material and append the chunk transform to the model
+uint32_t voxel_world_draw(VoxelWorld *world, const Frustum *frustum, RenderQueue *queue, const RenderPacket *material);
+
+void voxel_world_get_stats(const VoxelWorld *world, VoxelWorldStats *stats);
@@ -0,0 +1,206 @@
+#include "voxel.h"
+#include "base.h"
+#include "terrain/noise.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DIRT_DEPTH 3 // Blocks of dirt under the grass
+#define SAND_LEVEL 2 // Surfaces at most this far above sea level (y = 0) are sand
+
+struct _voxel_chunk {
+	BlockId *palette;
+	uint32_t palette_size, palette_capacity;
+	uint32_t bits; // Per block, 0 when the palette has a single entry
+	uint64_t *words; // VOXEL_CHUNK_VOLUME * bits / 64 words of palette indices, NULL when bits is 0
+	uint32_t solid_count; // Blocks that aren't air
+};
+
+static uint32_t palette_bits(uint32_t palette_size);
+static void voxel_chunk_repack(VoxelChunk *chunk, uint32_t bits);
+static uint32_t voxel_chunk_index_get(const VoxelChunk *chunk, uint32_t index);
+static void voxel_chunk_index_set(VoxelChunk *chunk, uint32_t index, uint32_t palette_index);
+
+VoxelChunk *voxel_chunk_create(void) {
+	VoxelChunk *chunk = malloc(sizeof(VoxelChunk));
+
+	*chunk = (VoxelChunk){ .palette_size = 1, .palette_capacity = 4 };
+	chunk->palette = malloc(sizeof(BlockId) * chunk->palette_capacity);
+	chunk->palette[0] = BLOCK_AIR;
+
+	return chunk;
+}
+
+void voxel_chunk_destroy(VoxelChunk *chunk) {
+	if (chunk == NULL)
+		return;
+
+	free(chunk->palette);
+	free(chunk->words);
+	free(chunk);
+}
+
+BlockId voxel_chunk_get(const VoxelChunk *chunk, uint32_t x, uint32_t y, uint32_t z) {
+	return chunk->palette[voxel_chunk_index_get(chunk, x + y * VOXEL_CHUNK_SIZE + z * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE)];
+}
+
+void voxel_chunk_set(VoxelChunk *chunk, uint32_t x, uint32_t y, uint32_t z, BlockId block) {
+	uint32_t index = x + y * VOXEL_CHUNK_SIZE + z * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE;
+	BlockId previous = chunk->palette[voxel_chunk_index_get(chunk, index)];
+	if (previous == block)
+		return;
+
+	uint32_t palette_index = 0;
+	while (palette_index < chunk->palette_size && chunk->palette[palette_index] != block)
+		palette_index++;
+
+	if (palette_index == chunk->palette_size) {
+		if (chunk->palette_size == chunk->palette_capacity) {
+			chunk->palette_capacity *= 2;
+			chunk->palette = realloc(chunk->palette, sizeof(BlockId) * chunk->palette_capacity);
+		}
+		chunk->palette[chunk->palette_size++] = block;
+
+		if (palette_bits(chunk->palette_size) != chunk->bits)
+			voxel_chunk_repack(chunk, palette_bits(chunk->palette_size));
+	}
+
+	voxel_chunk_index_set(chunk, index, palette_index);
+	chunk->solid_count += (block != BLOCK_AIR) - (previous != BLOCK_AIR);
+}
+
+void voxel_chunk_unpack(const VoxelChunk *chunk, BlockId *blocks) {
+	if (chunk->bits == 0) {
+		for (uint32_t i = 0; i < VOXEL_CHUNK_VOLUME; i++)
+			blocks[i] = chunk->palette[0];
+		return;
+	}
+
+	// Whole words at a time, bits is a power of two so no entry straddles two words
+	const uint32_t per_word = 64 / chunk->bits;
+	const uint64_t mask = (1ull << chunk->bits) - 1;
+	for (uint32_t word = 0; word < VOXEL_CHUNK_VOLUME / per_word; word++) {
+		uint64_t value = chunk->words[word];
+		for (uint32_t i = 0; i < per_word; i++, value >>= chunk->bits)
+			blocks[word * per_word + i] = chunk->palette[value & mask];
+	}
+}
+
+void voxel_chunk_pack(VoxelChunk *chunk, const BlockId *blocks) {
+	// Build the palette first so the bits per block are known before anything is written
+	chunk->palette_size = 0;
+	chunk->solid_count = 0;
+	BlockId last = blocks[0];
+	bool has_last = false;
+	for (uint32_t i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+		chunk->solid_count += blocks[i] != BLOCK_AIR;
+		if (has_last && blocks[i] == last)
+			continue;
+
+		uint32_t palette_index = 0;
+		while (palette_index < chunk->palette_size && chunk->palette[palette_index] != blocks[i])
+			palette_index++;
+		if (palette_index == chunk->palette_size) {
+			if (chunk->palette_size == chunk->palette_capacity) {
+				chunk->palette_capacity *= 2;
+				chunk->palette = realloc(chunk->palette, sizeof(BlockId) * chunk->palette_capacity);
+			}
+			chunk->palette[chunk->palette_size++] = blocks[i];
+		}
+		last = blocks[i];
+		has_last = true;
+	}
+
+	chunk->bits = palette_bits(chunk->palette_size);
+	free(chunk->words);
+	chunk->words = NULL;
+	if (chunk->bits == 0)
+		return;
+
+	chunk->words = calloc(VOXEL_CHUNK_VOLUME * chunk->bits / 64, sizeof(uint64_t));
+	uint32_t palette_index = 0;
+	for (uint32_t i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+		if (chunk->palette[palette_index] != blocks[i]) {
+			palette_index = 0;
+			while (chunk->palette[palette_index] != blocks[i])
+				palette_index++;
+		}
+		chunk->words[(i * chunk->bits) >> 6] |= (uint64_t)palette_index << ((i * chunk->bits) & 63);
+	}
+}
+
+uint32_t voxel_chunk_palette_size(const VoxelChunk *chunk) {
+	return chunk->palette_size;
+}
+
+size_t voxel_chunk_memory(const VoxelChunk *chunk) {
+	return sizeof(VoxelChunk) + sizeof(BlockId) * chunk->palette_capacity + (size_t)VOXEL_CHUNK_VOLUME * chunk->bits / 8;
+}
+
+bool voxel_chunk_is_empty(const VoxelChunk *chunk) {
+	return chunk->solid_count == 0;
+}
+
+void voxel_chunk_generate(VoxelChunk *chunk, const fnl_state *noise, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, float height_scale) {
+	BlockId *blocks = malloc(sizeof(BlockId) * VOXEL_CHUNK_VOLUME);
+	const int32_t base_x = chunk_x * VOXEL_CHUNK_SIZE, base_y = chunk_y * VOXEL_CHUNK_SIZE, base_z = chunk_z * VOXEL_CHUNK_SIZE;
+
+	for (uint32_t z = 0; z < VOXEL_CHUNK_SIZE; z++) {
+		// Same noise coordinates per block as the heightmap terrain uses per grid vertex
+		float heights[VOXEL_CHUNK_SIZE];
+		noise_fill_row(noise, base_x * .5f, .5f, (base_z + (int32_t)z) * .5f, VOXEL_CHUNK_SIZE, heights);
+
+		for (uint32_t x = 0; x < VOXEL_CHUNK_SIZE; x++) {
+			int32_t surface = (int32_t)floorf(heights[x] * height_scale);
+			BlockId top = surface <= SAND_LEVEL ? BLOCK_SAND : BLOCK_GRASS;
+
+			for (uint32_t y = 0; y < VOXEL_CHUNK_SIZE; y++) {
+				int32_t world_y = base_y + (int32_t)y;
+				BlockId block = BLOCK_AIR;
+				if (world_y == surface)
+					block = top;
+				else if (world_y < surface)
+					block = world_y >= surface - DIRT_DEPTH ? (top == BLOCK_SAND ? BLOCK_SAND : BLOCK_DIRT) : BLOCK_STONE;
+
+				blocks[x + y * VOXEL_CHUNK_SIZE + z * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE] = block;
+			}
+		}
+	}
+
+	voxel_chunk_pack(chunk, blocks);
+	free(blocks);
+}
+
+// Smallest power of two bits (or 0) that can index palette_size entries
+uint32_t palette_bits(uint32_t palette_size) {
+	uint32_t bits = 0;
+	while ((1u << bits) < palette_size)
+		bits = bits ? bits * 2 : 1;
+
+	return bits;
+}
+
+void voxel_chunk_repack(VoxelChunk *chunk, uint32_t bits) {
+	uint64_t *words = calloc(VOXEL_CHUNK_VOLUME * bits / 64, sizeof(uint64_t));
+	for (uint32_t i = 0; i < VOXEL_CHUNK_VOLUME; i++)
+		words[(i * bits) >> 6] |= (uint64_t)voxel_chunk_index_get(chunk, i) << ((i * bits) & 63);
+
+	free(chunk->words);
+	chunk->words = words;
+	chunk->bits = bits;
+}
+
+uint32_t voxel_chunk_index_get(const VoxelChunk *chunk, uint32_t index) {
+	if (chunk->bits == 0)
+		return 0;
+
+	uint32_t bit = index * chunk->bits;
+	return (uint32_t)(chunk->words[bit >> 6] >> (bit & 63)) & ((1u << chunk->bits) - 1);
+}
+
+void voxel_chunk_index_set(VoxelChunk *chunk, uint32_t index, uint32_t palette_index) {
+	uint32_t bit = index * chunk->bits;
+	uint64_t mask = (uint64_t)((1u << chunk->bits) - 1) << (bit & 63);
+	chunk->words[bit >> 6] = (chunk->words[bit >> 6] & ~mask) | ((uint64_t)palette_index << (bit & 63));
+}
@@ -0,0 +1,252 @@
+#include "voxel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PADDED_SIZE	  (VOXEL_CHUNK_SIZE + 2) // One block of the neighbours on every side
+#define PADDED_VOLUME (PADDED_SIZE * PADDED_SIZE * PADDED_SIZE)
+
+struct _voxel_mesher {
+	BlockId blocks[VOXEL_CHUNK_VOLUME];
+	BlockId padded[PADDED_VOLUME];
+	int32_t mask[VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE]; // Block of the face on a slice, negated for faces pointing down the axis
+
+	VoxelVertex *vertices;
+	uint32_t quad_count, quad_capacity;
+};
+
+VertexAttribute voxel_vertex_attributes[2] = {
+	{ .name = "a_voxel", .format = FORMAT_UINT8x4 },
+	{ .name = "a_block", .format = FORMAT_UINT16x2 },
+};
+
+static void voxel_mesher_pad(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT]);
+static void voxel_mesher_greedy_region(VoxelMesher *mesher, const uint32_t min[3], const uint32_t max[3]);
+static void voxel_mesher_naive_region(VoxelMesher *mesher, const uint32_t min[3], const uint32_t max[3]);
+static void voxel_mesher_build_mask(VoxelMesher *mesher, uint32_t axis, uint32_t slice, const uint32_t min[3], const uint32_t max[3]);
+static void voxel_mesher_emit_quad(VoxelMesher *mesher, uint32_t axis, uint32_t slice, uint32_t i, uint32_t j, uint32_t width, uint32_t height, int32_t face);
+static void voxel_mesher_finish(VoxelMesher *mesher, uint32_t first_quad, uint32_t end_quad, VoxelMesh *mesh);
+
+VoxelMesher *voxel_mesher_create(void) {
+	VoxelMesher *mesher = malloc(sizeof(VoxelMesher));
+
+	mesher->quad_count = 0;
+	mesher->quad_capacity = 1024;
+	mesher->vertices = malloc(sizeof(VoxelVertex) * 4 * mesher->quad_capacity);
+
+	return mesher;
+}
+
+void voxel_mesher_destroy(VoxelMesher *mesher) {
+	if (mesher == NULL)
+		return;
+
+	free(mesher->vertices);
+	free(mesher);
+}
+
+void voxel_mesh_greedy(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT], VoxelMesh *mesh) {
+	const uint32_t min[3] = { 0, 0, 0 }, max[3] = { VOXEL_CHUNK_SIZE, VOXEL_CHUNK_SIZE, VOXEL_CHUNK_SIZE };
+
+	mesher->quad_count = 0;
+	if (!voxel_chunk_is_empty(chunk)) {
+		voxel_mesher_pad(mesher, chunk, neighbours);
+		voxel_mesher_greedy_region(mesher, min, max);
+	}
+	voxel_mesher_finish(mesher, 0, mesher->quad_count, mesh);
+}
+
+void voxel_mesh_greedy_sections(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT], uint32_t section_mask,
+								VoxelMesh meshes[VOXEL_CHUNK_SECTIONS]) {
+	uint32_t first_quads[VOXEL_CHUNK_SECTIONS + 1] = { 0 };
+	const bool empty = voxel_chunk_is_empty(chunk);
+
+	mesher->quad_count = 0;
+	if (!empty)
+		voxel_mesher_pad(mesher, chunk, neighbours);
+
+	for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++) {
+		const uint32_t min[3] = { 0, section * VOXEL_SECTION_HEIGHT, 0 };
+		const uint32_t max[3] = { VOXEL_CHUNK_SIZE, (section + 1) * VOXEL_SECTION_HEIGHT, VOXEL_CHUNK_SIZE };
+		if (!empty && (section_mask & (1u << section)))
+			voxel_mesher_greedy_region(mesher, min, max);
+		first_quads[section + 1] = mesher->quad_count;
+	}
+
+	// Only once the array stopped growing can the sections point into it
+	for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++) {
+		if (section_mask & (1u << section))
+			voxel_mesher_finish(mesher, first_quads[section], first_quads[section + 1], &meshes[section]);
+	}
+}
+
+void voxel_mesh_naive(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT], VoxelMesh *mesh) {
+	const uint32_t min[3] = { 0, 0, 0 }, max[3] = { VOXEL_CHUNK_SIZE, VOXEL_CHUNK_SIZE, VOXEL_CHUNK_SIZE };
+
+	mesher->quad_count = 0;
+	if (!voxel_chunk_is_empty(chunk)) {
+		voxel_mesher_pad(mesher, chunk, neighbours);
+		voxel_mesher_naive_region(mesher, min, max);
+	}
+	voxel_mesher_finish(mesher, 0, mesher->quad_count, mesh);
+}
+
+void voxel_quad_indices(uint32_t quad_count, uint32_t *indices) {
+	for (uint32_t quad = 0; quad < quad_count; quad++, indices += 6) {
+		uint32_t base = quad * 4;
+		indices[0] = base, indices[1] = base + 1, indices[2] = base + 2;
+		indices[3] = base, indices[4] = base + 2, indices[5] = base + 3;
+	}
+}
+
+/*
+ * For every axis the region is cut into the planes between its block layers. A plane's mask holds the faces that
+ * separate a solid block of the region from air, and each unvisited face grows into the widest and then tallest
+ * rectangle of the same block and direction, which is emitted as one quad and cleared from the mask.
+ */
+void voxel_mesher_greedy_region(VoxelMesher *mesher, const uint32_t min[3], const uint32_t max[3]) {
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		const uint32_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+		for (uint32_t slice = min[axis]; slice <= max[axis]; slice++) {
+			voxel_mesher_build_mask(mesher, axis, slice, min, max);
+
+			int32_t *mask = mesher->mask;
+			for (uint32_t j = min[v]; j < max[v]; j++) {
+				for (uint32_t i = min[u]; i < max[u];) {
+					int32_t face = mask[i + j * VOXEL_CHUNK_SIZE];
+					if (face == 0) {
+						i++;
+						continue;
+					}
+
+					uint32_t width = 1;
+					while (i + width < max[u] && mask[i + width + j * VOXEL_CHUNK_SIZE] == face)
+						width++;
+
+					uint32_t height = 1;
+					for (; j + height < max[v]; height++) {
+						const int32_t *row = mask + (j + height) * VOXEL_CHUNK_SIZE + i;
+						uint32_t k = 0;
+						while (k < width && row[k] == face)
+							k++;
+						if (k < width)
+							break;
+					}
+
+					voxel_mesher_emit_quad(mesher, axis, slice, i, j, width, height, face);
+					for (uint32_t y = 0; y < height; y++)
+						memset(mask + (j + y) * VOXEL_CHUNK_SIZE + i, 0, sizeof(int32_t) * width);
+					i += width;
+				}
+			}
+		}
+	}
+}
+
+void voxel_mesher_naive_region(VoxelMesher *mesher, const uint32_t min[3], const uint32_t max[3]) {
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		const uint32_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+		for (uint32_t slice = min[axis]; slice <= max[axis]; slice++) {
+			voxel_mesher_build_mask(mesher, axis, slice, min, max);
+
+			for (uint32_t j = min[v]; j < max[v]; j++) {
+				for (uint32_t i = min[u]; i < max[u]; i++) {
+					if (mesher->mask[i + j * VOXEL_CHUNK_SIZE])
+						voxel_mesher_emit_quad(mesher, axis, slice, i, j, 1, 1, mesher->mask[i + j * VOXEL_CHUNK_SIZE]);
+				}
+			}
+		}
+	}
+}
+
+// Copies the chunk into the middle of the padded grid and the touching layer of each neighbour around it
+void voxel_mesher_pad(VoxelMesher *mesher, const VoxelChunk *chunk, const VoxelChunk *const neighbours[VOXEL_FACE_COUNT]) {
+	memset(mesher->padded, 0, sizeof(mesher->padded));
+
+	voxel_chunk_unpack(chunk, mesher->blocks);
+	for (uint32_t z = 0; z < VOXEL_CHUNK_SIZE; z++) {
+		for (uint32_t y = 0; y < VOXEL_CHUNK_SIZE; y++) {
+			memcpy(mesher->padded + 1 + (y + 1) * PADDED_SIZE + (z + 1) * PADDED_SIZE * PADDED_SIZE,
+				mesher->blocks + y * VOXEL_CHUNK_SIZE + z * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE, sizeof(BlockId) * VOXEL_CHUNK_SIZE);
+		}
+	}
+
+	if (neighbours == NULL)
+		return;
+
+	const uint32_t last = VOXEL_CHUNK_SIZE - 1;
+	for (uint32_t b = 0; b < VOXEL_CHUNK_SIZE; b++) {
+		for (uint32_t a = 0; a < VOXEL_CHUNK_SIZE; a++) {
+			if (neighbours[VOXEL_FACE_POSITIVE_X])
+				mesher->padded[PADDED_SIZE - 1 + (a + 1) * PADDED_SIZE + (b + 1) * PADDED_SIZE * PADDED_SIZE] = voxel_chunk_get(neighbours[VOXEL_FACE_POSITIVE_X], 0, a, b);
+			if (neighbours[VOXEL_FACE_NEGATIVE_X])
+				mesher->padded[0 + (a + 1) * PADDED_SIZE + (b + 1) * PADDED_SIZE * PADDED_SIZE] = voxel_chunk_get(neighbours[VOXEL_FACE_NEGATIVE_X], last, a, b);
+			if (neighbours[VOXEL_FACE_POSITIVE_Y])
+				mesher->padded[(a + 1) + (PADDED_SIZE - 1) * PADDED_SIZE + (b + 1) * PADDED_SIZE * PADDED_SIZE] = voxel_chunk_get(neighbours[VOXEL_FACE_POSITIVE_Y], a, 0, b);
+			if (neighbours[VOXEL_FACE_NEGATIVE_Y])
+				mesher->padded[(a + 1) + 0 + (b + 1) * PADDED_SIZE * PADDED_SIZE] = voxel_chunk_get(neighbours[VOXEL_FACE_NEGATIVE_Y], a, last, b);
+			if (neighbours[VOXEL_FACE_POSITIVE_Z])
+				mesher->padded[(a + 1) + (b + 1) * PADDED_SIZE + (PADDED_SIZE - 1) * PADDED_SIZE * PADDED_SIZE] = voxel_chunk_get(neighbours[VOXEL_FACE_POSITIVE_Z], a, b, 0);
+			if (neighbours[VOXEL_FACE_NEGATIVE_Z])
+				mesher->padded[(a + 1) + (b + 1) * PADDED_SIZE + 0] = voxel_chunk_get(neighbours[VOXEL_FACE_NEGATIVE_Z], a, b, last);
+		}
+	}
+}
+
+// Faces on the plane between block layers slice - 1 and slice of axis, only the ones that belong to blocks of the
+// region. Mask cells outside the region are left as they are, nothing reads them
+void voxel_mesher_build_mask(VoxelMesher *mesher, uint32_t axis, uint32_t slice, const uint32_t min[3], const uint32_t max[3]) {
+	static const uint32_t strides[3] = { 1, PADDED_SIZE, PADDED_SIZE * PADDED_SIZE };
+	const uint32_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+	const BlockId *behind = mesher->padded + slice * strides[axis], *ahead = behind + strides[axis];
+
+	for (uint32_t j = min[v]; j < max[v]; j++) {
+		for (uint32_t i = min[u]; i < max[u]; i++) {
+			uint32_t offset = (i + 1) * strides[u] + (j + 1) * strides[v];
+			BlockId a = behind[offset], b = ahead[offset];
+
+			int32_t face = 0;
+			if (a != BLOCK_AIR && b == BLOCK_AIR && slice > min[axis])
+				face = a;
+			else if (b != BLOCK_AIR && a == BLOCK_AIR && slice < max[axis])
+				face = -(int32_t)b;
+			mesher->mask[i + j * VOXEL_CHUNK_SIZE] = face;
+		}
+	}
+}
+
+// Counter-clockwise seen from the side the face points to
+void voxel_mesher_emit_quad(VoxelMesher *mesher, uint32_t axis, uint32_t slice, uint32_t i, uint32_t j, uint32_t width, uint32_t height, int32_t face) {
+	if (mesher->quad_count == mesher->quad_capacity) {
+		mesher->quad_capacity *= 2;
+		mesher->vertices = realloc(mesher->vertices, sizeof(VoxelVertex) * 4 * mesher->quad_capacity);
+	}
+
+	const uint32_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+	const bool negative = face < 0;
+	const uint8_t corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+	VoxelVertex *vertices = mesher->vertices + mesher->quad_count * 4;
+	for (uint32_t corner = 0; corner < 4; corner++) {
+		// Negative faces walk the corners the other way round to flip the winding
+		const uint8_t *offset = corners[negative ? (4 - corner) % 4 : corner];
+		VoxelVertex *vertex = &vertices[corner];
+
+		vertex->position[axis] = (uint8_t)slice;
+		vertex->position[u] = (uint8_t)(i + offset[0] * width);
+		vertex->position[v] = (uint8_t)(j + offset[1] * height);
+		vertex->position[3] = (uint8_t)(axis * 2 + negative);
+		vertex->block = (BlockId)(negative ? -face : face);
+		vertex->uv[0] = (uint8_t)(offset[0] * width);
+		vertex->uv[1] = (uint8_t)(offset[1] * height);
+	}
+
+	mesher->quad_count++;
+}
+
+void voxel_mesher_finish(VoxelMesher *mesher, uint32_t first_quad, uint32_t end_quad, VoxelMesh *mesh) {
+	mesh->vertices = mesher->vertices + first_quad * 4;
+	mesh->quad_count = end_quad - first_quad;
+}
@@ -0,0 +1,583 @@
+#include "voxel.h"
+#include "base.h"
+#include "base/clock.h"
+#include "base/darray.h"
+#include "renderer/mesh_optimizer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_BUFFER_QUADS 256 // Smallest chunk vertex buffer, so chunks that gain a few faces keep theirs
+#define RAYS_PER_JOB	 64 // Rays traced by one job of voxel_world_raycast_batch
+
+typedef struct {
+	VoxelChunk *chunk;
+	uint32_t dirty; // Sections whose faces changed since they were last meshed
+	VoxelVertex *section_vertices[VOXEL_CHUNK_SECTIONS]; // Last mesh of each section, the buffer is rebuilt from these
+	uint32_t section_quads[VOXEL_CHUNK_SECTIONS];
+
+	Buffer *vertex_buffer; // NULL until the chunk first has faces
+	uint32_t quad_count, quad_capacity; // Quads drawn, and quads vertex_buffer has room for
+	float model[16]; // Material model with the chunk transform, as of the last voxel_world_draw
+} VoxelChunkSlot;
+
+typedef struct {
+	int32_t x, y, z;
+	BlockId block;
+} VoxelEdit;
+
+typedef struct {
+	VoxelWorld *world;
+	uint32_t count;
+	uint32_t slots[VOXEL_REMESH_BUDGET];
+	uint32_t sections[VOXEL_REMESH_BUDGET]; // Dirty masks as the batch started
+	VoxelVertex *vertices[VOXEL_REMESH_BUDGET][VOXEL_CHUNK_SECTIONS]; // Results, allocated by the jobs
+	uint32_t quads[VOXEL_REMESH_BUDGET][VOXEL_CHUNK_SECTIONS];
+	JobCounter counter;
+	double start;
+} VoxelRemeshBatch;
+
+typedef struct {
+	VoxelWorld *world;
+	const fnl_state *noise;
+	float height_scale;
+} VoxelGenerateJob;
+
+typedef struct {
+	const VoxelWorld *world;
+	const Ray *rays;
+	uint32_t count;
+	float max_distance;
+	VoxelRayHit *hits;
+} VoxelRaycastBatch;
+
+struct _voxel_world {
+	Renderer *renderer;
+	JobSystem *jobs;
+	uint32_t size[3]; // In chunks
+	float block_size;
+	float origin[3]; // World position of the corner of chunk (0, 0, 0)
+	float camera_position[3]; // As of the last voxel_world_update
+
+	VoxelChunkSlot *slots; // x + (y + z * size[1]) * size[0]
+	BoundingBox *bounds; // Per slot, in world space
+	uint8_t *visible; // Culling scratch, per slot
+
+	VoxelMesher *meshers[VOXEL_REMESH_BUDGET]; // One per job of a batch
+	VoxelRemeshBatch batch;
+	bool remeshing;
+	VoxelEdit *pending_edits; // darray of edits made while the batch ran
+
+	Buffer *index_buffer; // voxel_quad_indices shared by every chunk
+	uint32_t index_quads;
+	VoxelVertex *staging; // Vertices of the chunk being uploaded
+	uint32_t staging_quads;
+
+	VoxelWorldStats stats;
+};
+
+static void voxel_world_generate_chunk(void *user_data, uint32_t index);
+static void voxel_world_remesh_chunk(void *user_data, uint32_t index);
+static void voxel_world_raycast_job(void *user_data, uint32_t index);
+static void voxel_world_start_batch(VoxelWorld *world);
+static void voxel_world_finish_batch(VoxelWorld *world);
+static void voxel_world_upload(VoxelWorld *world, VoxelChunkSlot *slot);
+static void voxel_world_reserve_indices(VoxelWorld *world, uint32_t quad_count);
+static void voxel_world_apply_edit(VoxelWorld *world, const VoxelEdit *edit);
+static void voxel_world_mark_dirty(VoxelWorld *world, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, uint32_t local_y);
+static VoxelChunkSlot *voxel_world_slot(const VoxelWorld *world, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z);
+static void voxel_world_chunk_model(const VoxelWorld *world, uint32_t index, const float *material_model, float model[16]);
+static uint32_t next_power_of_two(uint32_t value);
+
+VoxelWorld *voxel_world_create(Renderer *renderer, JobSystem *jobs, const uint32_t size[3], float block_size, const fnl_state *noise, float height_scale) {
+	VoxelWorld *world = malloc(sizeof(VoxelWorld));
+
+	*world = (VoxelWorld){ .renderer = renderer, .jobs = jobs, .size = { size[0], size[1], size[2] }, .block_size = block_size };
+	world->origin[0] = -(float)(size[0] * VOXEL_CHUNK_SIZE) * block_size * .5f;
+	world->origin[2] = -(float)(size[2] * VOXEL_CHUNK_SIZE) * block_size * .5f;
+
+	const uint32_t slot_count = size[0] * size[1] * size[2];
+	world->slots = calloc(slot_count, sizeof(VoxelChunkSlot));
+	world->bounds = malloc(sizeof(BoundingBox) * slot_count);
+	world->visible = malloc(sizeof(uint8_t) * slot_count);
+	world->pending_edits = darray_create(sizeof(VoxelEdit), 64);
+	for (uint32_t i = 0; i < VOXEL_REMESH_BUDGET; i++)
+		world->meshers[i] = voxel_mesher_create();
+
+	const float chunk_size = VOXEL_CHUNK_SIZE * block_size;
+	for (uint32_t i = 0; i < slot_count; i++) {
+		uint32_t x = i % size[0], y = i / size[0] % size[1], z = i / (size[0] * size[1]);
+		world->slots[i].dirty = (1u << VOXEL_CHUNK_SECTIONS) - 1;
+		world->bounds[i] = (BoundingBox){
+			.min = { world->origin[0] + x * chunk_size, world->origin[1] + y * chunk_size, world->origin[2] + z * chunk_size },
+			.max = { world->origin[0] + (x + 1) * chunk_size, world->origin[1] + (y + 1) * chunk_size, world->origin[2] + (z + 1) * chunk_size },
+		};
+	}
+
+	double start = clock_seconds();
+	VoxelGenerateJob generate = { .world = world, .noise = noise, .height_scale = height_scale };
+	job_system_parallel_for(jobs, slot_count, voxel_world_generate_chunk, &generate);
+	LOG_DEBUG("Generated %u voxel chunks in %.1f ms", slot_count, (clock_seconds() - start) * 1e3);
+
+	return world;
+}
+
+void voxel_world_destroy(VoxelWorld *world) {
+	if (world == NULL)
+		return;
+
+	if (world->remeshing) {
+		job_system_wait(world->jobs, &world->batch.counter);
+		for (uint32_t i = 0; i < world->batch.count; i++) {
+			for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++)
+				free(world->batch.vertices[i][section]);
+		}
+	}
+
+	const uint32_t slot_count = world->size[0] * world->size[1] * world->size[2];
+	for (uint32_t i = 0; i < slot_count; i++) {
+		VoxelChunkSlot *slot = &world->slots[i];
+		voxel_chunk_destroy(slot->chunk);
+		for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++)
+			free(slot->section_vertices[section]);
+		if (slot->vertex_buffer)
+			world->renderer->buffer_destroy(world->renderer, slot->vertex_buffer);
+	}
+	for (uint32_t i = 0; i < VOXEL_REMESH_BUDGET; i++)
+		voxel_mesher_destroy(world->meshers[i]);
+	if (world->index_buffer)
+		world->renderer->buffer_destroy(world->renderer, world->index_buffer);
+
+	darray_free(world->pending_edits);
+	free(world->staging);
+	free(world->slots);
+	free(world->bounds);
+	free(world->visible);
+	free(world);
+}
+
+BlockId voxel_world_get_block(const VoxelWorld *world, int32_t x, int32_t y, int32_t z) {
+	if (x < 0 || y < 0 || z < 0)
+		return BLOCK_AIR;
+
+	const VoxelChunkSlot *slot = voxel_world_slot(world, x / VOXEL_CHUNK_SIZE, y / VOXEL_CHUNK_SIZE, z / VOXEL_CHUNK_SIZE);
+	if (slot == NULL)
+		return BLOCK_AIR;
+	return voxel_chunk_get(slot->chunk, x % VOXEL_CHUNK_SIZE, y % VOXEL_CHUNK_SIZE, z % VOXEL_CHUNK_SIZE);
+}
+
+void voxel_world_set_block(VoxelWorld *world, int32_t x, int32_t y, int32_t z, BlockId block) {
+	VoxelEdit edit = { .x = x, .y = y, .z = z, .block = block };
+
+	// The batch's jobs read the chunks, so they can't change underneath it
+	if (world->remeshing)
+		darray_push(world->pending_edits, edit);
+	else
+		voxel_world_apply_edit(world, &edit);
+}
+
+// Amanatides & Woo in block space, where the world corner is at 0 and a block is 1 unit wide
+bool voxel_world_raycast(const VoxelWorld *world, const Ray *ray, float max_distance, VoxelRayHit *hit) {
+	float origin[3];
+	int32_t extent[3];
+	float t_enter = 0.f, t_exit = max_distance / world->block_size;
+	int32_t entered_axis = -1; // Axis of the face the ray last stepped through, -1 while it's in the block it started in
+
+	// Start where the ray enters the world, if it starts outside
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		origin[axis] = (ray->origin[axis] - world->origin[axis]) / world->block_size;
+		extent[axis] = (int32_t)(world->size[axis] * VOXEL_CHUNK_SIZE);
+
+		const float direction = ray->direction[axis];
+		if (direction == 0.f) {
+			if (origin[axis] < 0.f || origin[axis] >= (float)extent[axis])
+				return false;
+			continue;
+		}
+
+		float t0 = -origin[axis] / direction, t1 = (extent[axis] - origin[axis]) / direction;
+		if (t0 > t1) {
+			float swap = t0;
+			t0 = t1, t1 = swap;
+		}
+		if (t0 > t_enter)
+			t_enter = t0, entered_axis = (int32_t)axis;
+		t_exit = t1 < t_exit ? t1 : t_exit;
+	}
+	if (t_enter > t_exit)
+		return false;
+
+	int32_t block[3], step[3];
+	float t_next[3], t_delta[3];
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		// The entry point sits on the world box, rounding can put it one block outside
+		block[axis] = (int32_t)floorf(origin[axis] + ray->direction[axis] * t_enter);
+		block[axis] = block[axis] < 0 ? 0 : block[axis] >= extent[axis] ? extent[axis] - 1 : block[axis];
+
+		if (ray->direction[axis] == 0.f) {
+			step[axis] = 0;
+			t_next[axis] = t_delta[axis] = INFINITY;
+			continue;
+		}
+		step[axis] = ray->direction[axis] > 0.f ? 1 : -1;
+		t_delta[axis] = 1.f / fabsf(ray->direction[axis]);
+		t_next[axis] = (block[axis] + (step[axis] > 0) - origin[axis]) / ray->direction[axis];
+	}
+
+	// Blocks are only read in chunks that have any, the steps through air-only chunks are just the DDA
+	const VoxelChunkSlot *slot = NULL;
+	int32_t chunk[3] = { -1, -1, -1 };
+	float t = t_enter;
+	for (;;) {
+		const int32_t chunk_x = block[0] / VOXEL_CHUNK_SIZE, chunk_y = block[1] / VOXEL_CHUNK_SIZE, chunk_z = block[2] / VOXEL_CHUNK_SIZE;
+		if (chunk_x != chunk[0] || chunk_y != chunk[1] || chunk_z != chunk[2]) {
+			chunk[0] = chunk_x, chunk[1] = chunk_y, chunk[2] = chunk_z;
+			slot = voxel_world_slot(world, chunk_x, chunk_y, chunk_z);
+		}
+
+		if (!voxel_chunk_is_empty(slot->chunk)) {
+			BlockId id = voxel_chunk_get(slot->chunk, block[0] % VOXEL_CHUNK_SIZE, block[1] % VOXEL_CHUNK_SIZE, block[2] % VOXEL_CHUNK_SIZE);
+			if (id != BLOCK_AIR) {
+				*hit = (VoxelRayHit){ .block = { block[0], block[1], block[2] }, .block_id = id };
+				hit->hit.distance = t * world->block_size;
+				for (uint32_t axis = 0; axis < 3; axis++)
+					hit->hit.position[axis] = ray->origin[axis] + ray->direction[axis] * hit->hit.distance;
+				if (entered_axis >= 0)
+					hit->hit.normal[entered_axis] = (float)-step[entered_axis];
+				return true;
+			}
+		}
+
+		const uint32_t axis = t_next[0] < t_next[1] ? (t_next[0] < t_next[2] ? 0 : 2) : (t_next[1] < t_next[2] ? 1 : 2);
+		if (t_next[axis] > t_exit)
+			return false;
+
+		t = t_next[axis];
+		entered_axis = (int32_t)axis;
+		block[axis] += step[axis];
+		t_next[axis] += t_delta[axis];
+		if (block[axis] < 0 || block[axis] >= extent[axis])
+			return false;
+	}
+}
+
+uint32_t voxel_world_raycast_batch(const VoxelWorld *world, const Ray *rays, uint32_t count, float max_distance, VoxelRayHit *hits) {
+	VoxelRaycastBatch batch = { .world = world, .rays = rays, .count = count, .max_distance = max_distance, .hits = hits };
+	job_system_parallel_for(world->jobs, (count + RAYS_PER_JOB - 1) / RAYS_PER_JOB, voxel_world_raycast_job, &batch);
+
+	uint32_t hit_count = 0;
+	for (uint32_t i = 0; i < count; i++)
+		hit_count += hits[i].hit.distance < INFINITY;
+	return hit_count;
+}
+
+void voxel_world_update(VoxelWorld *world, const float camera_position[3]) {
+	memcpy(world->camera_position, camera_position, sizeof(world->camera_position));
+
+	if (world->remeshing) {
+		if (!job_system_is_done(&world->batch.counter))
+			return;
+		voxel_world_finish_batch(world);
+
+		for (uint32_t i = 0; i < darray_length(world->pending_edits); i++)
+			voxel_world_apply_edit(world, &world->pending_edits[i]);
+		darray_reset(world->pending_edits);
+	}
+
+	voxel_world_start_batch(world);
+}
+
+uint32_t voxel_world_draw(VoxelWorld *world, const Frustum *frustum, RenderQueue *queue, const RenderPacket *material) {
+	const uint32_t slot_count = world->size[0] * world->size[1] * world->size[2];
+
+	memset(world->visible, 1, sizeof(uint8_t) * slot_count);
+	if (frustum)
+		frustum_test_aabbs(frustum, world->bounds, slot_count, world->visible);
+
+	uint32_t drawn = 0;
+	for (uint32_t i = 0; i < slot_count; i++) {
+		VoxelChunkSlot *slot = &world->slots[i];
+		if (!world->visible[i] || slot->quad_count == 0)
+			continue;
+
+		const BoundingBox *bounds = &world->bounds[i];
+		float center[3] = { (bounds->min[0] + bounds->max[0]) * .5f, (bounds->min[1] + bounds->max[1]) * .5f, (bounds->min[2] + bounds->max[2]) * .5f };
+		float dx = center[0] - world->camera_position[0], dy = center[1] - world->camera_position[1], dz = center[2] - world->camera_position[2];
+
+		RenderPacket packet = *material;
+		packet.depth = sqrtf(dx * dx + dy * dy + dz * dz);
+		voxel_world_chunk_model(world, i, material->model, slot->model);
+		packet.model = slot->model;
+		packet.vertex_buffer = slot->vertex_buffer;
+		packet.index_buffer = world->index_buffer;
+		packet.instance_buffer = NULL;
+		packet.count = slot->quad_count * 6;
+		packet.instance_count = 0;
+		render_queue_push(queue, &packet);
+		drawn++;
+	}
+
+	return drawn;
+}
+
+void voxel_world_get_stats(const VoxelWorld *world, VoxelWorldStats *stats) {
+	*stats = world->stats;
+}
+
+void voxel_world_generate_chunk(void *user_data, uint32_t index) {
+	VoxelGenerateJob *job = user_data;
+	VoxelWorld *world = job->world;
+	int32_t x = (int32_t)(index % world->size[0]), y = (int32_t)(index / world->size[0] % world->size[1]), z = (int32_t)(index / (world->size[0] * world->size[1]));
+
+	world->slots[index].chunk = voxel_chunk_create();
+	voxel_chunk_generate(world->slots[index].chunk, job->noise, x, y, z, job->height_scale);
+}
+
+// Meshes the dirty sections of one chunk of the batch into vertex arrays the render thread takes over
+void voxel_world_remesh_chunk(void *user_data, uint32_t index) {
+	VoxelRemeshBatch *batch = user_data;
+	VoxelWorld *world = batch->world;
+	const uint32_t slot_index = batch->slots[index];
+	int32_t x = (int32_t)(slot_index % world->size[0]), y = (int32_t)(slot_index / world->size[0] % world->size[1]),
+			z = (int32_t)(slot_index / (world->size[0] * world->size[1]));
+
+	const int32_t offsets[VOXEL_FACE_COUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const VoxelChunk *neighbours[VOXEL_FACE_COUNT];
+	for (uint32_t face = 0; face < VOXEL_FACE_COUNT; face++) {
+		const VoxelChunkSlot *neighbour = voxel_world_slot(world, x + offsets[face][0], y + offsets[face][1], z + offsets[face][2]);
+		neighbours[face] = neighbour ? neighbour->chunk : NULL;
+	}
+
+	VoxelMesh meshes[VOXEL_CHUNK_SECTIONS];
+	voxel_mesh_greedy_sections(world->meshers[index], world->slots[slot_index].chunk, neighbours, batch->sections[index], meshes);
+
+	for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++) {
+		batch->vertices[index][section] = NULL;
+		batch->quads[index][section] = 0;
+		if (!(batch->sections[index] & (1u << section)) || meshes[section].quad_count == 0)
+			continue;
+
+		size_t size = sizeof(VoxelVertex) * 4 * meshes[section].quad_count;
+		batch->vertices[index][section] = malloc(size);
+		batch->quads[index][section] = meshes[section].quad_count;
+		memcpy(batch->vertices[index][section], meshes[section].vertices, size);
+	}
+}
+
+// Takes the up to VOXEL_REMESH_BUDGET dirty chunks nearest to the camera and meshes them on the job system
+void voxel_world_start_batch(VoxelWorld *world) {
+	VoxelRemeshBatch *batch = &world->batch;
+	float distances[VOXEL_REMESH_BUDGET];
+	const uint32_t slot_count = world->size[0] * world->size[1] * world->size[2];
+
+	batch->count = 0;
+	world->stats.dirty_chunks = 0;
+	for (uint32_t i = 0; i < slot_count; i++) {
+		if (world->slots[i].dirty == 0)
+			continue;
+		world->stats.dirty_chunks++;
+
+		const BoundingBox *bounds = &world->bounds[i];
+		float dx = (bounds->min[0] + bounds->max[0]) * .5f - world->camera_position[0];
+		float dy = (bounds->min[1] + bounds->max[1]) * .5f - world->camera_position[1];
+		float dz = (bounds->min[2] + bounds->max[2]) * .5f - world->camera_position[2];
+		float distance = dx * dx + dy * dy + dz * dz;
+
+		// Insertion into the sorted nearest so far, the budget is small
+		uint32_t position = batch->count;
+		while (position > 0 && distances[position - 1] > distance)
+			position--;
+		if (position == VOXEL_REMESH_BUDGET)
+			continue;
+
+		uint32_t last = batch->count < VOXEL_REMESH_BUDGET ? batch->count++ : VOXEL_REMESH_BUDGET - 1;
+		memmove(distances + position + 1, distances + position, sizeof(float) * (last - position));
+		memmove(batch->slots + position + 1, batch->slots + position, sizeof(uint32_t) * (last - position));
+		distances[position] = distance;
+		batch->slots[position] = i;
+	}
+	if (batch->count == 0)
+		return;
+
+	// Edits from here on dirty the sections again and get picked up by a later batch
+	for (uint32_t i = 0; i < batch->count; i++) {
+		VoxelChunkSlot *slot = &world->slots[batch->slots[i]];
+		batch->sections[i] = slot->dirty;
+		slot->dirty = 0;
+	}
+
+	batch->world = world;
+	batch->counter = (JobCounter){ 0 };
+	batch->start = clock_seconds();
+	world->remeshing = true;
+	job_system_dispatch(world->jobs, batch->count, voxel_world_remesh_chunk, batch, &batch->counter);
+}
+
+void voxel_world_finish_batch(VoxelWorld *world) {
+	VoxelRemeshBatch *batch = &world->batch;
+	double elapsed = clock_seconds() - batch->start;
+
+	world->remeshing = false;
+	world->stats.batches++;
+	world->stats.remesh_seconds += elapsed;
+	if (elapsed > world->stats.max_remesh_seconds)
+		world->stats.max_remesh_seconds = elapsed;
+
+	for (uint32_t i = 0; i < batch->count; i++) {
+		VoxelChunkSlot *slot = &world->slots[batch->slots[i]];
+
+		for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++) {
+			if (!(batch->sections[i] & (1u << section)))
+				continue;
+
+			free(slot->section_vertices[section]);
+			slot->section_vertices[section] = batch->vertices[i][section];
+			slot->section_quads[section] = batch->quads[i][section];
+			world->stats.sections_remeshed++;
+		}
+
+		voxel_world_upload(world, slot);
+		world->stats.chunks_remeshed++;
+	}
+	LOG_TRACE("Re-meshed %u voxel chunks in %.2f ms", batch->count, elapsed * 1e3);
+}
+
+// The whole buffer is rewritten even when only a few sections changed. A partial update would have to wait for the
+// frames in flight still drawing the buffer, a full one lets the backend orphan the storage they read
+void voxel_world_upload(VoxelWorld *world, VoxelChunkSlot *slot) {
+	Renderer *renderer = world->renderer;
+	uint32_t quad_count = 0;
+	for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++)
+		quad_count += slot->section_quads[section];
+
+	slot->quad_count = quad_count;
+	if (quad_count == 0)
+		return;
+
+	// A mesh that outgrew its buffer goes into a new one
+	const bool swap = slot->vertex_buffer == NULL || quad_count > slot->quad_capacity;
+	if (swap)
+		slot->quad_capacity = next_power_of_two(quad_count > MIN_BUFFER_QUADS ? quad_count : MIN_BUFFER_QUADS);
+
+	// Staged up to the buffer capacity, the quads past quad_count are never drawn
+	if (slot->quad_capacity > world->staging_quads) {
+		world->staging_quads = slot->quad_capacity;
+		world->staging = realloc(world->staging, sizeof(VoxelVertex) * 4 * world->staging_quads);
+	}
+	uint32_t staged = 0;
+	for (uint32_t section = 0; section < VOXEL_CHUNK_SECTIONS; section++) {
+		if (slot->section_quads[section] == 0)
+			continue;
+		memcpy(world->staging + staged * 4, slot->section_vertices[section], sizeof(VoxelVertex) * 4 * slot->section_quads[section]);
+		staged += slot->section_quads[section];
+	}
+
+	if (swap) {
+		// Buffers only grow. The old one can go right away, the backend keeps it alive for draws still in flight
+		Buffer *previous = slot->vertex_buffer;
+		slot->vertex_buffer = renderer->buffer_create(renderer, BUFFER_TYPE_VERTEX, sizeof(VoxelVertex) * 4 * slot->quad_capacity, world->staging);
+		renderer->buffer_set_layout(renderer, slot->vertex_buffer, voxel_vertex_attributes, 2);
+		if (previous)
+			renderer->buffer_destroy(renderer, previous);
+		world->stats.buffer_swaps++;
+	} else {
+		renderer->buffer_update(renderer, slot->vertex_buffer, world->staging, 0, sizeof(VoxelVertex) * 4 * slot->quad_capacity);
+		world->stats.buffer_updates++;
+	}
+
+	voxel_world_reserve_indices(world, slot->quad_capacity);
+}
+
+// Grows the shared index buffer to cover quad_count quads, 16-bit while the vertices it addresses fit
+void voxel_world_reserve_indices(VoxelWorld *world, uint32_t quad_count) {
+	if (quad_count <= world->index_quads)
+		return;
+
+	Renderer *renderer = world->renderer;
+	if (world->index_buffer)
+		renderer->buffer_destroy(renderer, world->index_buffer);
+
+	world->index_quads = quad_count;
+	uint32_t index_count = quad_count * 6;
+	uint32_t *indices = malloc(sizeof(uint32_t) * index_count);
+	voxel_quad_indices(quad_count, indices);
+
+	if (mesh_indices_fit_16(quad_count * 4)) {
+		mesh_indices_to_16(indices, index_count, (uint16_t *)indices);
+		world->index_buffer = renderer->buffer_create(renderer, BUFFER_TYPE_INDEX16, sizeof(uint16_t) * index_count, indices);
+	} else {
+		world->index_buffer = renderer->buffer_create(renderer, BUFFER_TYPE_INDEX, sizeof(uint32_t) * index_count, indices);
+	}
+	free(indices);
+}
+
+void voxel_world_raycast_job(void *user_data, uint32_t index) {
+	VoxelRaycastBatch *batch = user_data;
+	const uint32_t end = (index + 1) * RAYS_PER_JOB < batch->count ? (index + 1) * RAYS_PER_JOB : batch->count;
+
+	for (uint32_t i = index * RAYS_PER_JOB; i < end; i++) {
+		if (!voxel_world_raycast(batch->world, &batch->rays[i], batch->max_distance, &batch->hits[i]))
+			batch->hits[i] = (VoxelRayHit){ .hit.distance = INFINITY };
+	}
+}
+
+void voxel_world_apply_edit(VoxelWorld *world, const VoxelEdit *edit) {
+	if (edit->x < 0 || edit->y < 0 || edit->z < 0)
+		return;
+
+	int32_t chunk_x = edit->x / VOXEL_CHUNK_SIZE, chunk_y = edit->y / VOXEL_CHUNK_SIZE, chunk_z = edit->z / VOXEL_CHUNK_SIZE;
+	VoxelChunkSlot *slot = voxel_world_slot(world, chunk_x, chunk_y, chunk_z);
+	if (slot == NULL)
+		return;
+
+	uint32_t x = edit->x % VOXEL_CHUNK_SIZE, y = edit->y % VOXEL_CHUNK_SIZE, z = edit->z % VOXEL_CHUNK_SIZE;
+	if (voxel_chunk_get(slot->chunk, x, y, z) == edit->block)
+		return;
+	voxel_chunk_set(slot->chunk, x, y, z, edit->block);
+
+	// The block's own faces and the faces of the six blocks around it, which may sit in the next section or chunk
+	const uint32_t last = VOXEL_CHUNK_SIZE - 1;
+	voxel_world_mark_dirty(world, chunk_x, chunk_y, chunk_z, y);
+	if (y % VOXEL_SECTION_HEIGHT == 0)
+		voxel_world_mark_dirty(world, chunk_x, chunk_y - (y == 0), chunk_z, y == 0 ? last : y - 1);
+	if (y % VOXEL_SECTION_HEIGHT == VOXEL_SECTION_HEIGHT - 1)
+		voxel_world_mark_dirty(world, chunk_x, chunk_y + (y == last), chunk_z, y == last ? 0 : y + 1);
+	if (x == 0 || x == last)
+		voxel_world_mark_dirty(world, chunk_x + (x == 0 ? -1 : 1), chunk_y, chunk_z, y);
+	if (z == 0 || z == last)
+		voxel_world_mark_dirty(world, chunk_x, chunk_y, chunk_z + (z == 0 ? -1 : 1), y);
+}
+
+void voxel_world_mark_dirty(VoxelWorld *world, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z, uint32_t local_y) {
+	VoxelChunkSlot *slot = voxel_world_slot(world, chunk_x, chunk_y, chunk_z);
+	if (slot)
+		slot->dirty |= 1u << (local_y / VOXEL_SECTION_HEIGHT);
+}
+
+VoxelChunkSlot *voxel_world_slot(const VoxelWorld *world, int32_t chunk_x, int32_t chunk_y, int32_t chunk_z) {
+	if (chunk_x < 0 || chunk_y < 0 || chunk_z < 0 || chunk_x >= (int32_t)world->size[0] || chunk_y >= (int32_t)world->size[1] || chunk_z >= (int32_t)world->size[2])
+		return NULL;
+	return &world->slots[chunk_x + (chunk_y + chunk_z * world->size[1]) * world->size[0]];
+}
+
+void voxel_world_chunk_model(const VoxelWorld *world, uint32_t index, const float *material_model, float model[16]) {
+	static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	const float *m = material_model ? material_model : identity;
+	const float *corner = world->bounds[index].min;
+
+	// Column major, the chunk transform scales blocks to block_size and translates to the chunk corner
+	for (uint32_t row = 0; row < 4; row++) {
+		model[0 + row] = m[0 + row] * world->block_size;
+		model[4 + row] = m[4 + row] * world->block_size;
+		model[8 + row] = m[8 + row] * world->block_size;
+		model[12 + row] = m[0 + row] * corner[0] + m[4 + row] * corner[1] + m[8 + row] * corner[2] + m[12 + row];
+	}
+}
+
+uint32_t next_power_of_two(uint32_t value) {
+	uint32_t power = 1;
+	while (power < value)
+		power <<= 1;
+	return power;
+}